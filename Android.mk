@@ -60,6 +60,10 @@ LOCAL_SRC_FILES:= \
     native/IMultiDisplaySinkRegistrar.cpp \
     native/IMultiDisplayCallbackRegistrar.cpp \
     native/IMultiDisplayDecoderConfig.cpp \
+    native/MultiDisplayStore.cpp \
+    native/MultiDisplaySinkPreferences.cpp \
+    native/MultiDisplayLatency.cpp \
+    native/MultiDisplayRecorder.cpp \
     native/MultiDisplayService.cpp
 ifeq ($(TARGET_HAS_VPP),true)
 LOCAL_SRC_FILES += native/IMultiDisplayVppConfig.cpp
@@ -71,6 +75,7 @@ LOCAL_MODULE_TAGS := optional
 LOCAL_SHARED_LIBRARIES := \
     libui libcutils libutils libbinder
 LOCAL_CFLAGS := -DLOG_TAG=\"MultiDisplay\"
+LOCAL_CPPFLAGS := -std=gnu++11
 
 ifeq ($(ENABLE_IMG_GRAPHICS),true)
     LOCAL_SRC_FILES += \
@@ -109,6 +114,19 @@ LOCAL_C_INCLUDES += $(TARGET_OUT_HEADERS)/libmedia_utils_vpp
 LOCAL_SHARED_LIBRARIES += libvpp_setting
 endif
 
+# The headers shared with the legacy trees
+LOCAL_C_INCLUDES += $(LOCAL_PATH)/shared
+
+# Trace points in the ftrace marker, see shared/MultiDisplayTrace.h
+ifeq ($(MDS_ENABLE_TRACE),true)
+LOCAL_CFLAGS += -DMDS_TRACE
+endif
+
+# Lock contention profile, see shared/MultiDisplayLockProfile.h
+ifeq ($(MDS_ENABLE_LOCK_PROFILE),true)
+LOCAL_CFLAGS += -DMDS_LOCK_PROFILE
+endif
+
 #LOCAL_C_INCLUDES += $(TARGET_OUT_HEADERS)
 
 include $(BUILD_SHARED_LIBRARY)
@@ -131,11 +149,16 @@ LOCAL_SHARED_LIBRARIES := \
 
 LOCAL_C_INCLUDES := \
      $(JNI_H_INCLUDE) \
-     $(call include-path-for, frameworks-base)
+     $(call include-path-for, frameworks-base) \
+     $(LOCAL_PATH)/native \
+     $(LOCAL_PATH)/shared
 
 ifeq ($(TARGET_HAS_VPP),true)
 LOCAL_CFLAGS += -DTARGET_HAS_VPP
 endif
+ifeq ($(MDS_ENABLE_TRACE),true)
+LOCAL_CFLAGS += -DMDS_TRACE
+endif
 LOCAL_CFLAGS += -DLOG_TAG=\"MultiDisplay\"
 
 include $(BUILD_SHARED_LIBRARY)
@@ -194,3 +217,10 @@ include $(BUILD_PREBUILT)
 include $(BUILD_DROIDDOC)
 
 endif
+
+# Development tools, see tools/
+ifneq ($(USE_MDS_LEGACY),true)
+ifeq ($(TARGET_HAS_MULTIPLE_DISPLAY),true)
+include $(LOCAL_PATH)/tools/Android.mk
+endif
+endif
@@ -12,7 +12,8 @@ LOCAL_COPY_HEADERS := \
     native/include/MultiDisplayClient.h \
     native/include/MultiDisplayComposer.h \
     native/include/MultiDisplayType.h \
-    native/include/MultiDisplayService.h
+    native/include/MultiDisplayService.h \
+    ../shared/MultiDisplayLockProfile.h
 
 include $(BUILD_COPY_HEADERS)
 
@@ -22,6 +23,7 @@ LOCAL_SRC_FILES:= \
     native/MultiDisplayClient.cpp \
     native/IMultiDisplayComposer.cpp \
     native/MultiDisplayComposer.cpp \
+    native/MultiDisplayModePlan.cpp \
     native/IExtendDisplayListener.cpp
 
 LOCAL_MODULE:= libmultidisplay
@@ -52,6 +54,19 @@ ifeq ($(ENABLE_HDCP),true)
     LOCAL_CFLAGS += -DENABLE_HDCP
 endif
 
+# The headers shared with the main tree
+LOCAL_C_INCLUDES += $(LOCAL_PATH)/../shared
+
+# Trace points in the ftrace marker, see ../shared/MultiDisplayTrace.h
+ifeq ($(MDS_ENABLE_TRACE),true)
+    LOCAL_CFLAGS += -DMDS_TRACE
+endif
+
+# Lock contention profile, see ../shared/MultiDisplayLockProfile.h
+ifeq ($(MDS_ENABLE_LOCK_PROFILE),true)
+    LOCAL_CFLAGS += -DMDS_LOCK_PROFILE
+endif
+
 include $(BUILD_SHARED_LIBRARY)
 
 # Build JNI library
@@ -128,3 +143,8 @@ LOCAL_SRC_FILES := $(LOCAL_MODULE)
 include $(BUILD_PREBUILT)
 
 include $(BUILD_DROIDDOC)
+
+# Development tools, see tools/
+ifeq ($(TARGET_HAS_MULTIPLE_DISPLAY),true)
+include $(LOCAL_PATH)/tools/Android.mk
+endif
@@ -0,0 +1,183 @@
+/*
+ * Copyright (c) 2012-2013, Intel Corporation. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+//#define LOG_NDEBUG 0
+
+#include <string.h>
+#include <utils/Log.h>
+#include "drm_hdmi.h"
+#include "MultiDisplayModePlan.h"
+
+static inline bool checkMode(int value, int bit) {
+    return (value & bit) == bit;
+}
+
+static inline void addStep(MDSHdmiModePlan* plan, int step) {
+    if (plan->count < MDS_STEP_MAX)
+        plan->steps[plan->count++] = step;
+}
+
+// Broadcast the final mode only if it is changed
+static void finishPlan(MDSHdmiModePlan* plan, int mode, int oldMode) {
+    plan->mode = mode;
+    if (mode != oldMode)
+        addStep(plan, MDS_STEP_BROADCAST);
+}
+
+void planHdmiMode(const MDSHdmiModeInput& in, MDSHdmiModePlan* plan) {
+    memset(plan, 0, sizeof(MDSHdmiModePlan));
+    plan->mipiPolicy = in.mipiPolicy;
+    plan->connectStatus = in.lastConnectStatus;
+    plan->result = MDS_NO_ERROR;
+    int mode = in.mode;
+
+    // Common case, update video status
+    if (in.playing) {
+        mode |= MDS_VIDEO_PLAYING;
+    } else {
+        mode &= ~MDS_VIDEO_PLAYING;
+    }
+    int connectStatus = in.connectStatus;
+    if (in.hotplug && connectStatus == DRM_HDMI_CONNECTED &&
+            in.lastConnectStatus == DRM_HDMI_CONNECTED) {
+        /*bug 146422/148938: if setHdmiMode_l is called by notifyHotplug, the connector status should be changed.
+         * So force connector status to disconnect when the old status is connected and then a hotplug occur.*/
+        connectStatus = DRM_HDMI_DISCONNECTED;
+    }
+#if !defined(DVI_SUPPORTED)
+    if (connectStatus == DRM_DVI_CONNECTED) {
+        LOGE("%s: DVI is connected but is not supported for now.", __func__);
+        plan->connectStatus = connectStatus;
+        plan->result = MDS_ERROR;
+        finishPlan(plan, mode, in.mode);
+        return;
+    }
+#endif
+#ifndef VPG_DRM
+    // Common case, turn on MIPI if necessary
+    if (connectStatus == DRM_HDMI_DISCONNECTED ||
+            in.hdmiPolicy == MDS_HDMI_ON_NOT_ALLOWED ||
+            in.playing == false) {
+        plan->mipiPolicy = MDS_MIPI_OFF_NOT_ALLOWED;
+        if (!checkMode(mode, MDS_MIPI_ON)) {
+            addStep(plan, MDS_STEP_MIPI_ON);
+            mode |= MDS_MIPI_ON;
+            plan->mipiOn = true;
+        }
+    }
+#endif
+    // Common case, HDMI is disconnected
+    if (connectStatus == DRM_HDMI_DISCONNECTED) {
+        plan->connectStatus = connectStatus;
+        if (!checkMode(mode, MDS_HDMI_CONNECTED)) {
+            LOGV("HDMI is already in disconnected state.");
+            finishPlan(plan, mode, in.mode);
+            return;
+        }
+        addStep(plan, MDS_STEP_AUDIO_UNPLUG);
+        addStep(plan, MDS_STEP_HDCP_RESET);
+        mode &= ~(MDS_HDMI_CONNECTED | MDS_HDMI_ON | MDS_HDCP_ON |
+                MDS_HDMI_CLONE | MDS_HDMI_VIDEO_EXT | MDS_OVERLAY_OFF);
+        addStep(plan, MDS_STEP_BROADCAST);
+        addStep(plan, MDS_STEP_HDMI_DISCONNECTED);
+        plan->mode = mode;
+        return;
+    }
+
+    // Do not need to notify HDMI audio driver about hotplug during startup.
+    bool notifyAudio = !checkMode(mode, MDS_HDMI_CONNECTED) && in.drmInit;
+    mode |= MDS_HDMI_CONNECTED;
+
+    // Common case, check HDMI policy
+    if (in.hdmiPolicy == MDS_HDMI_ON_NOT_ALLOWED) {
+        if (in.lastConnectStatus != connectStatus && notifyAudio) {
+            addStep(plan, MDS_STEP_AUDIO_PLUG);
+            plan->connectStatus = connectStatus;
+        }
+        if (!checkMode(mode, MDS_HDMI_ON)) {
+            LOGW("HDMI is already in off state.");
+            finishPlan(plan, mode, in.mode);
+            return;
+        }
+        if (checkMode(mode, MDS_HDCP_ON))
+            addStep(plan, MDS_STEP_HDCP_OFF);
+        mode &= ~(MDS_HDCP_ON | MDS_HDMI_ON | MDS_HDMI_CLONE | MDS_HDMI_VIDEO_EXT);
+        addStep(plan, MDS_STEP_BROADCAST);
+#ifndef VPG_DRM
+        addStep(plan, MDS_STEP_HDMI_VIDEO_OFF);
+#endif
+        plan->mode = mode;
+        return;
+    }
+    if (in.hotplug)
+        plan->connectStatus = connectStatus;
+
+    if (in.playing && checkMode(mode, MDS_HDMI_VIDEO_EXT)) {
+        LOGW("HDMI is already in Video Extended mode.");
+        finishPlan(plan, mode, in.mode);
+        return;
+    } else if (!in.playing && checkMode(mode, MDS_HDMI_CLONE)) {
+        LOGW("HDMI is already in cloned state.");
+        finishPlan(plan, mode, in.mode);
+        return;
+    }
+
+    // Turn off overlay temporarily during mode transition.
+    // Transition mode starts with standalone local mipi mode (no cloned, no video extended).
+    // The intermediate modes are not broadcasted, the listeners only see
+    // the transitional mode before the timing change and the final mode.
+    plan->transitionalMode = mode;
+    plan->transitionalMode &= ~(MDS_HDMI_CLONE | MDS_HDMI_VIDEO_EXT);
+    plan->transitionalMode |= MDS_OVERLAY_OFF;
+    addStep(plan, MDS_STEP_BROADCAST_TRANSITION);
+
+    if (in.playing) {
+        addStep(plan, MDS_STEP_VIDEO_TIMING);
+        if (in.protectedContent) {
+            addStep(plan, MDS_STEP_HDCP_ON);
+            mode |= MDS_HDCP_ON;
+        }
+        mode |= MDS_HDMI_VIDEO_EXT;
+        mode &= ~MDS_HDMI_CLONE;
+        plan->mipiPolicy = MDS_MIPI_OFF_ALLOWED;
+    } else {
+        if (checkMode(mode, MDS_HDCP_ON)) {
+            addStep(plan, MDS_STEP_HDCP_OFF);
+            mode &= ~MDS_HDCP_ON;
+        }
+        addStep(plan, MDS_STEP_CLONE_TIMING);
+        mode &= ~MDS_HDMI_VIDEO_EXT;
+        mode |= MDS_HDMI_CLONE;
+    }
+    mode |= MDS_OVERLAY_OFF;
+
+    // Common case, turn on HDMI if necessary
+    if (!checkMode(mode, MDS_HDMI_ON)) {
+#ifndef VPG_DRM
+        addStep(plan, MDS_STEP_HDMI_VIDEO_ON);
+#endif
+        mode |= MDS_HDMI_ON;
+    }
+    if (checkMode(mode, MDS_HDMI_VIDEO_EXT)) {
+        //Enable overlay lastly
+        mode &= ~MDS_OVERLAY_OFF;
+    }
+    addStep(plan, MDS_STEP_BROADCAST);
+    if (notifyAudio)
+        addStep(plan, MDS_STEP_AUDIO_PLUG);
+    plan->mode = mode;
+}
@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2012-2013, Intel Corporation. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef __MULTIDISPLAY_MODE_PLAN_H__
+#define __MULTIDISPLAY_MODE_PLAN_H__
+#include <display/MultiDisplayType.h>
+
+// The inputs of a HDMI mode transition, @see planHdmiMode
+typedef struct {
+    int  mode;              // the current mode
+    int  hdmiPolicy;
+    int  mipiPolicy;
+    int  lastConnectStatus; // the HDMI connect status known before
+    int  connectStatus;     // the HDMI connect status probed now
+    bool hotplug;
+    bool drmInit;
+    bool playing;
+    bool protectedContent;
+} MDSHdmiModeInput;
+
+// The side effects of a HDMI mode transition
+enum {
+    MDS_STEP_MIPI_ON,           // turn on MIPI
+    MDS_STEP_AUDIO_UNPLUG,      // notify the audio driver of the unplug
+    MDS_STEP_HDCP_RESET,        // disable HDCP of a disconnected sink
+    MDS_STEP_HDCP_OFF,          // disable HDCP of a connected sink
+    MDS_STEP_HDCP_ON,
+    MDS_STEP_BROADCAST_TRANSITION, // broadcast the transitional mode, overlay off
+    MDS_STEP_VIDEO_TIMING,      // set the video timing if SurfaceFlinger allows
+    MDS_STEP_CLONE_TIMING,
+    MDS_STEP_HDMI_VIDEO_ON,
+    MDS_STEP_HDMI_VIDEO_OFF,
+    MDS_STEP_BROADCAST,         // broadcast the final mode
+    MDS_STEP_HDMI_DISCONNECTED, // reset the DRM state of the sink
+    MDS_STEP_AUDIO_PLUG,        // notify the audio driver of the plug
+    MDS_STEP_MAX,
+};
+
+// The ordered side effects and the final state of a HDMI mode transition
+struct MDSHdmiModePlan {
+    int  steps[MDS_STEP_MAX];
+    int  count;
+    int  mode;
+    int  transitionalMode;
+    int  mipiPolicy;
+    int  connectStatus;
+    bool mipiOn;
+    int  result;
+};
+
+/*
+ * Compute the final mode and the ordered side effects of a HDMI mode
+ * transition. It is pure, the composer runs the plan under its lock,
+ * and a table test drives it with plain inputs, see tools/mds_plan_test.
+ */
+void planHdmiMode(const MDSHdmiModeInput& in, MDSHdmiModePlan* plan);
+
+#endif
@@ -17,11 +17,13 @@
  */
 
 //#define LOG_NDEBUG 0
+#include <unistd.h>
 #include <utils/Log.h>
 #include <binder/IServiceManager.h>
 #include <binder/IPCThreadState.h>
 #include <display/MultiDisplayType.h>
 #include <display/MultiDisplayService.h>
+#include <display/MultiDisplayLockProfile.h>
 
 
 using namespace android;
@@ -143,3 +145,17 @@ int MultiDisplayService::getDisplayCapability() {
     MDS_CHECK_MDS();
     return mMDC->getDisplayCapability();
 }
+
+status_t MultiDisplayService::dump(int fd, const Vector<String16>& args) {
+    String8 out;
+    if (!checkCallingPermission(String16("android.permission.DUMP"))) {
+        out.appendFormat("Permission Denial: can't dump MultiDisplay from pid=%d, uid=%d\n",
+                IPCThreadState::self()->getCallingPid(),
+                IPCThreadState::self()->getCallingUid());
+    } else {
+        out.appendFormat("Mode 0x%x\n", getMode(false));
+        android::intel::mdsDumpLocks(out);
+    }
+    write(fd, out.string(), out.size());
+    return NO_ERROR;
+}
@@ -48,6 +48,10 @@ typedef struct _drmContext {
     MDSHDMITiming modeSelected;
     char productInfo[EDID_PRODUCT_INFO_LEN];
     drmModeConnectorPtr hdmiConnector;
+    // The MIPI connector and its DPMS property, looked up once
+    bool mipiDpmsValid;
+    uint32_t mipiConnectorId;
+    uint32_t mipiDpmsPropId;
 } drmContext;
 
 static drmContext gDrmCxt;
@@ -659,30 +663,25 @@ bool drm_hdmi_getTiming(int mode, MDSHDMITiming* info)
 }
 
 #ifndef VPG_DRM
-bool drm_mipi_setMode(int mode)
+static bool getMipiDpms()
 {
+    if (gDrmCxt.mipiDpmsValid)
+        return true;
     drmModeConnector *connector = getConnector(gDrmCxt.drmFD, DRM_MODE_CONNECTOR_MIPI);
     if (connector == NULL)
         return false;
 
     int i = 0;
     drmModePropertyPtr props = NULL;
-
-    // Set MIPI On/Off
     for (i = 0; i < connector->count_props; i++) {
         props = drmModeGetProperty(gDrmCxt.drmFD, connector->props[i]);
         if (!props) continue;
 
-        if (porps->name != NULL &&
+        if (props->name != NULL &&
                 !strncmp(props->name, "DPMS", sizeof("DPMS"))) {
-            LOGV("%s: %s %u", __func__,
-                  (mode == DRM_MIPI_ON) ? "On" : "Off",
-                  connector->connector_id);
-            drmModeConnectorSetProperty(gDrmCxt.drmFD,
-                                        connector->connector_id,
-                                        props->prop_id,
-                                        (mode == DRM_MIPI_ON)
-                                        ? DRM_MODE_DPMS_ON : DRM_MODE_DPMS_OFF);
+            gDrmCxt.mipiConnectorId = connector->connector_id;
+            gDrmCxt.mipiDpmsPropId = props->prop_id;
+            gDrmCxt.mipiDpmsValid = true;
             drmModeFreeProperty(props);
             break;
         }
@@ -690,6 +689,25 @@ bool drm_mipi_setMode(int mode)
     }
 
     drmModeFreeConnector(connector);
-    return true;
+    if (!gDrmCxt.mipiDpmsValid)
+        LOGE("%s: MIPI has no DPMS property", __func__);
+    return gDrmCxt.mipiDpmsValid;
+}
+
+bool drm_mipi_setMode(int mode)
+{
+    if (!getMipiDpms())
+        return false;
+
+    // Set MIPI On/Off
+    LOGV("%s: %s %u", __func__,
+          (mode == DRM_MIPI_ON) ? "On" : "Off",
+          gDrmCxt.mipiConnectorId);
+    int ret = drmModeConnectorSetProperty(gDrmCxt.drmFD,
+                                          gDrmCxt.mipiConnectorId,
+                                          gDrmCxt.mipiDpmsPropId,
+                                          (mode == DRM_MIPI_ON)
+                                          ? DRM_MODE_DPMS_ON : DRM_MODE_DPMS_OFF);
+    return (ret == 0);
 }
 #endif
@@ -62,6 +62,9 @@ public:
     int getHdmiDeviceChange();
     int getVideoInfo(int* dw, int* dh, int* fps, int* interlace);
     int getDisplayCapability();
+
+    // Print the lock profile for dumpsys
+    virtual status_t dump(int fd, const Vector<String16>& args);
 };
 
 }; // namespace android
@@ -0,0 +1,5 @@
+# Development tools, built only when they are named
+
+LOCAL_PATH:= $(call my-dir)
+
+include $(call all-makefiles-under,$(LOCAL_PATH))
@@ -24,9 +24,12 @@
 #include <display/IMultiDisplayComposer.h>
 #include <display/MultiDisplayComposer.h>
 #include "drm_hdmi.h"
+#include "MultiDisplayModePlan.h"
+#include "MultiDisplayTrace.h"
 #include "drm_hdcp.h"
 
 using namespace android;
+using namespace android::intel;
 
 
 #define MDC_CHECK_INIT() \
@@ -56,7 +59,10 @@ MultiDisplayListener::~MultiDisplayListener() {
     mIEListener = NULL;
 }
 
-MultiDisplayComposer::MultiDisplayComposer() {
+MultiDisplayComposer::MultiDisplayComposer() :
+    mLock("mLock"),
+    mMipiLock("mMipiLock")
+{
     mDrmInit = false;
     mMode = 0;
     mMipiPolicy = MDS_MIPI_OFF_NOT_ALLOWED;
@@ -65,11 +71,16 @@ MultiDisplayComposer::MultiDisplayComposer() {
     mMipiOn = true;
     mWidiVideoExt = false;
     mMipiReq = NO_MIPI_REQ;
+    mMipiTarget = true;
+    // The panel is on at boot, as mMipiOn
+    mMipiApplied = true;
     mSurfaceComposer = NULL;
     mScaleMode = 0;
     mScaleStepX = 0;
     mScaleStepY = 0;
     mConnectStatus = 0;
+    memset(&mTiming, 0, sizeof(MDSHDMITiming));
+    mTimingValid = false;
 
     // Default value
     mDisplayCapability = MDS_HW_SUPPORT_WIDI;
@@ -87,9 +98,9 @@ MultiDisplayComposer::~MultiDisplayComposer() {
 int MultiDisplayComposer::getMode(bool wait) {
     MDC_CHECK_INIT();
     if (wait)
-        mLock.lock();
+        mdsLock(mLock, __func__);
     else {
-        if (mLock.tryLock() == -EBUSY) {
+        if (mdsTryLock(mLock, __func__) == -EBUSY) {
             //LOGW("%s: couldn't hold lock", __func__);
             return MDS_MODE_NONE;
         }
@@ -101,7 +112,7 @@ int MultiDisplayComposer::getMode(bool wait) {
 
 int MultiDisplayComposer::notifyWidi(bool on) {
     MDC_CHECK_INIT();
-    Mutex::Autolock _l(mMipiLock);
+    MDS_AUTOLOCK(mMipiLock);
     mWidiVideoExt = on;
     if (mWidiVideoExt)
         mMode |= MDS_WIDI_ON;
@@ -113,7 +124,7 @@ int MultiDisplayComposer::notifyWidi(bool on) {
 
 int MultiDisplayComposer::notifyMipi(bool on) {
     MDC_CHECK_INIT();
-    Mutex::Autolock _l(mMipiLock);
+    MDS_AUTOLOCK(mMipiLock);
     mMipiReq = on ? MIPI_ON_REQ : MIPI_OFF_REQ;
     mMipiCon.signal();
     return MDS_NO_ERROR;
@@ -121,14 +132,14 @@ int MultiDisplayComposer::notifyMipi(bool on) {
 
 int MultiDisplayComposer::setHdmiPowerOff() {
     MDC_CHECK_INIT();
-    Mutex::Autolock _l(mLock);
+    MDS_AUTOLOCK(mLock);
     drm_hdmi_setHdmiPowerOff();
     return MDS_NO_ERROR;
 }
 
 int MultiDisplayComposer::prepareForVideo(int status) {
     MDC_CHECK_INIT();
-    Mutex::Autolock _l(mLock);
+    MDS_AUTOLOCK(mLock);
     if (mVideoState == status)
         return MDS_NO_ERROR;
     LOGV("%s: Video preparing status %d", __func__, status);
@@ -144,13 +155,13 @@ int MultiDisplayComposer::prepareForVideo(int status) {
 
 int MultiDisplayComposer::getVideoState() {
     MDC_CHECK_INIT();
-    Mutex::Autolock _l(mLock);
+    MDS_AUTOLOCK(mLock);
     return mVideoState;
 }
 
 int MultiDisplayComposer::updateVideoInfo(const MDSVideoSourceInfo& info) {
     MDC_CHECK_INIT();
-    Mutex::Autolock _l(mLock);
+    MDS_AUTOLOCK(mLock);
     LOGV("update video info: \
         \n mode: 0x%x, \
         \n is playing: %d, \
@@ -169,185 +180,128 @@ int MultiDisplayComposer::updateVideoInfo(const MDSVideoSourceInfo& info) {
 
 
 int MultiDisplayComposer::setHdmiMode_l() {
+    MDS_TRACE_CALL();
     LOGV("Entering %s, current mode = %#x", __func__, mMode);
-    MDSHDMITiming timing;
-    memset(&timing, 0, sizeof(MDSHDMITiming));
-
-    // Common case, update video status
-    if (mVideo.isPlaying) {
-        mMode |= MDS_VIDEO_PLAYING;
-    } else {
-        mMode &= ~MDS_VIDEO_PLAYING;
-    }
-    // Common case, check HDMI connect status
-    int connectStatus = getHdmiPlug_l();
-#if !defined(DVI_SUPPORTED)
-    if (connectStatus == DRM_DVI_CONNECTED) {
-        LOGE("%s: DVI is connected but is not supported for now.", __func__);
-        broadcastMessage_l(MDS_MODE_CHANGE, &mMode, sizeof(mMode));
-        mConnectStatus = connectStatus;
-        return MDS_ERROR;
-    }
+    MDSHdmiModeInput in;
+    in.mode = mMode;
+    in.hdmiPolicy = mHdmiPolicy;
+    in.mipiPolicy = mMipiPolicy;
+    in.lastConnectStatus = mConnectStatus;
+    in.connectStatus = getHdmiPlug_l();
+    in.drmInit = mDrmInit;
+    in.playing = mVideo.isPlaying;
+    in.protectedContent = mVideo.isProtected;
+
+    MDSHdmiModePlan plan;
+    planHdmiMode(in, &plan);
+    return executeHdmiModePlan_l(plan);
+}
+
+#ifdef MDS_TRACE
+// The trace section names of MDS_STEP_*
+static const char* sStepNames[MDS_STEP_MAX] = {
+    "MIPI on",
+    "audio unplug",
+    "HDCP reset",
+    "HDCP off",
+    "HDCP on",
+    "broadcast transition",
+    "video timing",
+    "clone timing",
+    "HDMI video on",
+    "HDMI video off",
+    "broadcast",
+    "HDMI disconnected",
+    "audio plug",
+};
 #endif
-    // Common case, turn on MIPI if necessary
-    if (connectStatus == DRM_HDMI_DISCONNECTED ||
-        mHdmiPolicy == MDS_HDMI_ON_NOT_ALLOWED ||
-        mVideo.isPlaying == false) {
-        mMipiPolicy = MDS_MIPI_OFF_NOT_ALLOWED;
-        if (!checkMode(mMode, MDS_MIPI_ON)) {
-            LOGI("Turn on MIPI.");
-            drm_mipi_setMode(DRM_MIPI_ON);
-            mMode |= MDS_MIPI_ON;
-            mMipiOn = true;
-        }
-    }
-    // Common case, HDMI is disconnected
-    if (connectStatus == DRM_HDMI_DISCONNECTED) {
-        LOGI("HDMI is disconnected.");
-        if (!checkMode(mMode, MDS_HDMI_CONNECTED)) {
-            LOGW("HDMI is already in disconnected state.");
-            broadcastMessage_l(MDS_MODE_CHANGE, &mMode, sizeof(mMode));
-            mConnectStatus = connectStatus;
-            return MDS_NO_ERROR;
-        }
-
-        LOGV("Notify HDMI audio driver hot unplug event.");
-        drm_hdmi_notify_audio_hotplug(false);
-        drm_hdcp_disable_hdcp(false);
-        mMode &= ~MDS_HDMI_CONNECTED;
-        mMode &= ~MDS_HDMI_ON;
-        mMode &= ~MDS_HDCP_ON;
-        mMode &= ~MDS_HDMI_CLONE;
-        mMode &= ~MDS_HDMI_VIDEO_EXT;
-        mMode &= ~MDS_OVERLAY_OFF;
-        broadcastMessage_l(MDS_MODE_CHANGE, &mMode, sizeof(mMode));
-        drm_hdmi_onHdmiDisconnected();
-        mConnectStatus = connectStatus;
-        return MDS_NO_ERROR;
-    }
-
-    LOGI("HDMI is connected.");
-    bool notify_audio_hotplug = (mMode & MDS_HDMI_CONNECTED) == 0;
-    mMode |= MDS_HDMI_CONNECTED;
-
-    // Common case, check HDMI policy
-    if (mHdmiPolicy == MDS_HDMI_ON_NOT_ALLOWED) {
-        LOGI("HDMI on is not allowed. Turning off HDMI...");
-        if (mConnectStatus != connectStatus &&
-               notify_audio_hotplug && mDrmInit) {
-            // Do not need to notify HDMI audio driver about hotplug during startup.
-            LOGV("Notify HDMI audio drvier hot plug event.");
-            drm_hdmi_notify_audio_hotplug(true);
-            mConnectStatus = connectStatus;
-        }
-        if (!checkMode(mMode, MDS_HDMI_ON)) {
-            LOGW("HDMI is already in off state.");
-            broadcastMessage_l(MDS_MODE_CHANGE, &mMode, sizeof(mMode));
-            return MDS_NO_ERROR;
-        }
-        if (checkMode(mMode, MDS_HDCP_ON)) {
-            drm_hdcp_disable_hdcp(true);
-        }
-        mMode &= ~MDS_HDCP_ON;
-        mMode &= ~MDS_HDMI_ON;
-        mMode &= ~MDS_HDMI_CLONE;
-        mMode &= ~MDS_HDMI_VIDEO_EXT;
-        broadcastMessage_l(MDS_MODE_CHANGE, &mMode, sizeof(mMode));
-        drm_hdmi_setHdmiVideoOff();
-        return MDS_NO_ERROR;
-    }
-    mConnectStatus = connectStatus;
-
-    if (mVideo.isPlaying && checkMode(mMode, MDS_HDMI_VIDEO_EXT)) {
-        LOGW("HDMI is already in Video Extended mode.");
-        broadcastMessage_l(MDS_MODE_CHANGE, &mMode, sizeof(mMode));
-        return MDS_NO_ERROR;
-    } else if (!mVideo.isPlaying && checkMode(mMode, MDS_HDMI_CLONE)) {
-        LOGW("HDMI is already in cloned state.");
-        broadcastMessage_l(MDS_MODE_CHANGE, &mMode, sizeof(mMode));
-        return MDS_NO_ERROR;
-    }
-    // Common case, turn off overlay temporarily during mode transition.
-    // Make sure overlay is turned on when this function exits.
-    // Transition mode starts with standalone local mipi mode (no cloned, no video extended).
-    int transitionalMode = mMode;
-    transitionalMode &= ~MDS_HDMI_CLONE;
-    transitionalMode &= ~MDS_HDMI_VIDEO_EXT;
-    transitionalMode |= MDS_OVERLAY_OFF;
-    broadcastMessage_l(MDS_MODE_CHANGE, &transitionalMode, sizeof(transitionalMode));
-
-    // Common case, notify HWC to set HDMI timing if need
-    if (mVideo.isPlaying) {
-        // disable dynamic mode setting for presentation mode
-        if (isHdmiTimingDynamicSettingEnable_l()) {
-            LOGI("Video is in playing state. Mode = %#x", mMode);
-            timing.width = mVideo.displayW;
-            timing.height = mVideo.displayH;
-            timing.refresh = mVideo.frameRate;
-            timing.interlace = 0;
-            timing.ratio = 0;
-            drm_hdmi_getTiming(DRM_HDMI_VIDEO_EXT, &timing);
-            setHdmiTiming_l((void*)&timing, sizeof(MDSHDMITiming));
-        }
-        if (mVideo.isProtected) {
-            // Common case, turn on HDCP
-            LOGV("Turning on HDCP...");
-            if (drm_hdcp_enable_hdcp() == false) {
-                LOGE("Fail to enable HDCP.");
-                // Continue mode setting as it may be recovered, unless HDCP is not supported.
-                // If HDCP is not supported, user will have to unplug the cable to restore video to phone.
-            }
-            mMode |= MDS_HDCP_ON;
-        }
-    } else {
-        LOGV("Video is not in playing state. Mode = %#x", mMode);
-        if (checkMode(mMode, MDS_HDCP_ON)) {
-            LOGV("Turning off HDCP before mode change");
-            drm_hdcp_disable_hdcp(true);
-            mMode &= ~MDS_HDCP_ON;
-        }
-        drm_hdmi_getTiming(DRM_HDMI_CLONE, &timing);
-        setHdmiTiming_l((void*)&timing, sizeof(MDSHDMITiming));
-    }
-
-    // Common case, prolong overlay off time
-    mMode |= MDS_OVERLAY_OFF;
-    if (mVideo.isPlaying) {
-        mMode |= MDS_HDMI_VIDEO_EXT;
-        mMode &= ~MDS_HDMI_CLONE;
-        mMipiPolicy = MDS_MIPI_OFF_ALLOWED;
-    } else {
-        mMode &= ~MDS_HDMI_VIDEO_EXT;
-        mMode |= MDS_HDMI_CLONE;
-    }
-    broadcastMessage_l(MDS_MODE_CHANGE, &mMode, sizeof(mMode));
 
-    // Common case, turn on HDMI if need
-    if (!checkMode(mMode, MDS_HDMI_ON)) {
-        LOGI("Turn on HDMI...");
-        if (!drm_hdmi_setHdmiVideoOn()) {
-            LOGI("Fail to turn on HDMI.");
+int MultiDisplayComposer::executeHdmiModePlan_l(const MDSHdmiModePlan& plan) {
+    MDS_TRACE_CALL();
+    MDSHDMITiming timing;
+    mMode = plan.mode;
+    mMipiPolicy = plan.mipiPolicy;
+    mConnectStatus = plan.connectStatus;
+    if (plan.mipiOn)
+        mMipiOn = true;
+
+    for (int i = 0; i < plan.count; i++) {
+        MDS_TRACE_NAME(sStepNames[plan.steps[i]]);
+        switch (plan.steps[i]) {
+            case MDS_STEP_MIPI_ON:
+                LOGV("Turn on MIPI.");
+                setMipiTarget_l(true);
+                syncMipi();
+                break;
+            case MDS_STEP_HDMI_VIDEO_ON:
+                LOGV("Turn on HDMI...");
+                if (!drm_hdmi_setHdmiVideoOn()) {
+                    LOGV("Fail to turn on HDMI.");
+                }
+                break;
+            case MDS_STEP_HDMI_VIDEO_OFF:
+                drm_hdmi_setHdmiVideoOff();
+                // The timing is set again when HDMI is turned on
+                mTimingValid = false;
+                break;
+            case MDS_STEP_AUDIO_UNPLUG:
+                LOGV("Notify HDMI audio driver hot unplug event.");
+                drm_hdmi_notify_audio_hotplug(false);
+                break;
+            case MDS_STEP_HDCP_RESET:
+                drm_hdcp_disable_hdcp(false);
+                break;
+            case MDS_STEP_HDCP_OFF:
+                LOGV("Turning off HDCP before mode change");
+                drm_hdcp_disable_hdcp(true);
+                break;
+            case MDS_STEP_HDCP_ON:
+                LOGV("Turning on HDCP...");
+                if (drm_hdcp_enable_hdcp() == false) {
+                    LOGE("Fail to enable HDCP.");
+                    // Continue mode setting as it may be recovered, unless HDCP is not supported.
+                    // If HDCP is not supported, user will have to unplug the cable to restore video to phone.
+                }
+                break;
+            case MDS_STEP_BROADCAST_TRANSITION: {
+                int transitionalMode = plan.transitionalMode;
+                broadcastMessage_l(MDS_MODE_CHANGE,
+                        &transitionalMode, sizeof(transitionalMode));
+            } break;
+            case MDS_STEP_VIDEO_TIMING:
+                // disable dynamic mode setting for presentation mode
+                if (!isHdmiTimingDynamicSettingEnable_l())
+                    break;
+                memset(&timing, 0, sizeof(MDSHDMITiming));
+                timing.width = mVideo.displayW;
+                timing.height = mVideo.displayH;
+                timing.refresh = mVideo.frameRate;
+                timing.interlace = 0;
+                timing.ratio = 0;
+                drm_hdmi_getTiming(DRM_HDMI_VIDEO_EXT, &timing);
+                setHdmiTiming_l((void*)&timing, sizeof(MDSHDMITiming));
+                break;
+            case MDS_STEP_CLONE_TIMING:
+                memset(&timing, 0, sizeof(MDSHDMITiming));
+                drm_hdmi_getTiming(DRM_HDMI_CLONE, &timing);
+                setHdmiTiming_l((void*)&timing, sizeof(MDSHDMITiming));
+                break;
+            case MDS_STEP_BROADCAST:
+                broadcastMessage_l(MDS_MODE_CHANGE, &mMode, sizeof(mMode));
+                break;
+            case MDS_STEP_HDMI_DISCONNECTED:
+                drm_hdmi_onHdmiDisconnected();
+                // The next sink needs its timing
+                mTimingValid = false;
+                break;
+            case MDS_STEP_AUDIO_PLUG:
+                LOGV("Notify HDMI audio drvier hot plug event.");
+                drm_hdmi_notify_audio_hotplug(true);
+                break;
         }
-        mMode |= MDS_HDMI_ON;
-        broadcastMessage_l(MDS_MODE_CHANGE, &mMode, sizeof(mMode));
-    }
-
-    // Common case, notify HWC to turn on Overlay if need
-    if (checkMode(mMode, MDS_HDMI_VIDEO_EXT)) {
-        //Enable overlay lastly
-        mMode &= ~MDS_OVERLAY_OFF;
     }
-    broadcastMessage_l(MDS_MODE_CHANGE, &mMode, sizeof(mMode));
-
-    // Common case, notify audio driver if need
-    if (notify_audio_hotplug && mDrmInit) {
-        // Do not need to notify HDMI audio driver about hotplug during startup.
-        LOGV("Notify HDMI audio drvier hot plug event.");
-        drm_hdmi_notify_audio_hotplug(true);
-    }
-
     LOGV("Leaving %s, new mode is %#x", __func__, mMode);
-    return MDS_NO_ERROR;
+    return plan.result;
 }
 
 void MultiDisplayComposer::broadcastMessage_l(int msg, void* value, int size) {
@@ -367,6 +321,12 @@ void MultiDisplayComposer::broadcastMessage_l(int msg, void* value, int size) {
 
 int MultiDisplayComposer::setHdmiTiming_l(void* value, int size) {
     int ret = MDS_ERROR;
+    // HWC has got the same timing
+    if (mTimingValid && size == sizeof(MDSHDMITiming) &&
+            !memcmp(&mTiming, value, sizeof(MDSHDMITiming))) {
+        LOGV("%s: HDMI timing is not changed", __func__);
+        return MDS_NO_ERROR;
+    }
     sp<IExtendDisplayListener> ielistener = NULL;
     bool hasHwc = false;
     for (unsigned int index = 0; index < mListener.size(); index++) {
@@ -383,21 +343,25 @@ int MultiDisplayComposer::setHdmiTiming_l(void* value, int size) {
             }
         }
     }
-    if (ielistener != NULL)
+    if (ielistener != NULL) {
         ret = ielistener->onMdsMessage(MDS_SET_TIMING, value, size);
-    else if (!hasHwc)
+        if (ret == MDS_NO_ERROR && size == sizeof(MDSHDMITiming)) {
+            memcpy(&mTiming, value, sizeof(MDSHDMITiming));
+            mTimingValid = true;
+        }
+    } else if (!hasHwc)
         ret = MDS_NO_ERROR;
     return ret;
 }
 
 int MultiDisplayComposer::setMipiMode_l(bool on) {
-    Mutex::Autolock _l(mLock);
+    MDS_AUTOLOCK(mLock);
 
     if (mMipiOn == on)
         return MDS_NO_ERROR;
 
     if (on) {
-        drm_mipi_setMode(DRM_MIPI_ON);
+        setMipiTarget_l(true);
         mMode |= MDS_MIPI_ON;
     } else {
         if(!mWidiVideoExt) {
@@ -407,11 +371,11 @@ int MultiDisplayComposer::setMipiMode_l(bool on) {
                 return MDS_ERROR;
             }
             if (mMipiPolicy == MDS_MIPI_OFF_ALLOWED) {
-                drm_mipi_setMode(DRM_MIPI_OFF);
+                setMipiTarget_l(false);
                 mMode &= ~MDS_MIPI_ON;
             }
         } else {
-            drm_mipi_setMode(DRM_MIPI_OFF);
+            setMipiTarget_l(false);
             mMode &= ~MDS_MIPI_ON;
         }
     }
@@ -420,11 +384,26 @@ int MultiDisplayComposer::setMipiMode_l(bool on) {
     return MDS_NO_ERROR;
 }
 
+void MultiDisplayComposer::setMipiTarget_l(bool on) {
+    Mutex::Autolock _l(mMipiPowerLock);
+    mMipiTarget = on;
+}
+
+void MultiDisplayComposer::syncMipi() {
+    Mutex::Autolock _l(mMipiPowerLock);
+    if (mMipiApplied == mMipiTarget)
+        return;
+    if (drm_mipi_setMode(mMipiTarget ? DRM_MIPI_ON : DRM_MIPI_OFF))
+        mMipiApplied = mMipiTarget;
+    else
+        LOGE("%s: Fail to turn %s MIPI", __func__, mMipiTarget ? "on" : "off");
+}
+
 int MultiDisplayComposer::notifyHotPlug() {
     int ret = MDS_ERROR;
     MDC_CHECK_INIT();
     LOGV("%s: mipi policy: %d, hdmi policy: %d, mode: 0x%x", __func__, mMipiPolicy, mHdmiPolicy, mMode);
-    Mutex::Autolock _l(mLock);
+    MDS_AUTOLOCK(mLock);
     ret = setHdmiMode_l();
     if (drm_hdmi_isDeviceChanged(false) && mConnectStatus == DRM_HDMI_CONNECTED)
         setDisplayScalingLocked(0, 0, 0);
@@ -433,7 +412,7 @@ int MultiDisplayComposer::notifyHotPlug() {
 
 int MultiDisplayComposer::setModePolicy(int policy) {
     MDC_CHECK_INIT();
-    Mutex::Autolock _l(mLock);
+    MDS_AUTOLOCK(mLock);
     return setModePolicy_l(policy);
 }
 
@@ -451,7 +430,8 @@ int MultiDisplayComposer::setModePolicy_l(int policy) {
         case MDS_MIPI_OFF_NOT_ALLOWED:
             mMipiPolicy = policy;
             if (!checkMode(mMode, MDS_MIPI_ON)) {
-                drm_mipi_setMode(DRM_MIPI_ON);
+                setMipiTarget_l(true);
+                syncMipi();
             }
             mMode |= MDS_MIPI_ON;
             mMipiOn = true;
@@ -459,7 +439,8 @@ int MultiDisplayComposer::setModePolicy_l(int policy) {
         case MDS_MIPI_OFF_ALLOWED:
             mMipiPolicy = policy;
             if (checkMode(mMode, MDS_MIPI_ON)) {
-                drm_mipi_setMode(DRM_MIPI_OFF);
+                setMipiTarget_l(false);
+                syncMipi();
             }
             mMode &= ~MDS_MIPI_ON;
             mMipiOn = false;
@@ -480,7 +461,7 @@ int MultiDisplayComposer::registerListener(
         LOGE("%s: Failed to register a no-name or no-message client", __func__);
         return MDS_ERROR;
     }
-    Mutex::Autolock _l(mLock);
+    MDS_AUTOLOCK(mLock);
     for (i = 0; i < mListener.size(); i++) {
         if (mListener.keyAt(i) == handle) {
             LOGE("%s register error!", __func__);
@@ -489,18 +470,21 @@ int MultiDisplayComposer::registerListener(
     }
     MultiDisplayListener* tlistener = new  MultiDisplayListener(msg, name, listener);
     mListener.add(handle, tlistener);
+    // It may be a new HWC, which doesn't know the timing
+    mTimingValid = false;
     return MDS_NO_ERROR;
 }
 
 int MultiDisplayComposer::unregisterListener(void *handle) {
     unsigned int i = 0;
     MDC_CHECK_INIT();
-    Mutex::Autolock _l(mLock);
+    MDS_AUTOLOCK(mLock);
     for (i = 0; i < mListener.size(); i++) {
         if (mListener.keyAt(i) == handle) {
             MultiDisplayListener* tlistener = mListener.valueAt(i);
             mListener.removeItem(handle);
             delete tlistener;
+            mTimingValid = false;
             tlistener = NULL;
             break;
         }
@@ -516,7 +500,7 @@ int MultiDisplayComposer::getHdmiModeInfo(int* pWidth, int* pHeight,
                                           int* pRefresh, int* pInterlace,
                                           int *pRatio) {
     MDC_CHECK_INIT();
-    Mutex::Autolock _l(mLock);
+    MDS_AUTOLOCK(mLock);
     LOGV("%s: mMode: 0x%x", __func__, mMode);
     if (pWidth == NULL || pHeight == NULL ||
             pRefresh == NULL || pInterlace == NULL) {
@@ -529,7 +513,7 @@ int MultiDisplayComposer::setHdmiModeInfo(int width, int height,
                             int refresh, int interlace, int ratio) {
     MDSHDMITiming timing;
     MDC_CHECK_INIT();
-    Mutex::Autolock _l(mLock);
+    MDS_AUTOLOCK(mLock);
     LOGV("%s: \
         \n  mMode: %d, \
         \n  width: %d, \
@@ -570,7 +554,7 @@ int MultiDisplayComposer::setDisplayScalingLocked(uint32_t mode,
 
 int MultiDisplayComposer::setHdmiScaleType(int type) {
     MDC_CHECK_INIT();
-    Mutex::Autolock _l(mLock);
+    MDS_AUTOLOCK(mLock);
 
     mScaleMode = type;
     return setDisplayScalingLocked(mScaleMode, mScaleStepX, mScaleStepY);
@@ -578,7 +562,7 @@ int MultiDisplayComposer::setHdmiScaleType(int type) {
 
 int MultiDisplayComposer::setHdmiScaleStep(int hValue, int vValue) {
     MDC_CHECK_INIT();
-    Mutex::Autolock _l(mLock);
+    MDS_AUTOLOCK(mLock);
 
     mScaleStepX = (hValue > 5) ? 0: (5 - hValue);
     mScaleStepY = (vValue > 5) ? 0: (5 - vValue);
@@ -587,7 +571,7 @@ int MultiDisplayComposer::setHdmiScaleStep(int hValue, int vValue) {
 
 int MultiDisplayComposer::getHdmiDeviceChange() {
     MDC_CHECK_INIT();
-    Mutex::Autolock _l(mLock);
+    MDS_AUTOLOCK(mLock);
     return drm_hdmi_isDeviceChanged(true);
 }
 
@@ -631,17 +615,18 @@ int MultiDisplayComposer::getDisplayCapability() {
 
 bool MultiDisplayComposer::threadLoop() {
     bool mipiOn;
-    while(true) {
-        {
-            Mutex::Autolock _l(mMipiLock);
-            if (mMipiReq == NO_MIPI_REQ)
-                mMipiCon.wait(mMipiLock);
-            mipiOn = (mMipiReq == MIPI_ON_REQ) ? true : false;
-            mMipiReq = NO_MIPI_REQ;
-        }
-        setMipiMode_l(mipiOn);
+    {
+        MDS_AUTOLOCK(mMipiLock);
+        while (mMipiReq == NO_MIPI_REQ)
+            mdsWait(mMipiCon, mMipiLock);
+        // Requests queued meanwhile are coalesced, only the last one counts
+        mipiOn = (mMipiReq == MIPI_ON_REQ) ? true : false;
+        mMipiReq = NO_MIPI_REQ;
     }
-    return MDS_NO_ERROR;
+    // Decide under mLock, then apply DPMS without holding it
+    setMipiMode_l(mipiOn);
+    syncMipi();
+    return true;
 }
 
 bool MultiDisplayComposer::isHdmiTimingDynamicSettingEnable_l() {
@@ -22,6 +22,7 @@
 #include <utils/Vector.h>
 #include <display/IExtendDisplayListener.h>
 #include <display/MultiDisplayType.h>
+#include <display/MultiDisplayLockProfile.h>
 
 using namespace android;
 
@@ -56,6 +57,8 @@ public:
     }
 };
 
+struct MDSHdmiModePlan;
+
 class MultiDisplayComposer : public Thread
 {
 public:
@@ -99,11 +102,20 @@ private:
     bool mMipiOn;
     int  mMipiReq;
     bool mWidiVideoExt;
-    mutable Mutex mLock;
+    // Profiled in a build with MDS_LOCK_PROFILE, see MultiDisplayLockProfile.h
+    mutable intel::MultiDisplayMutex mLock;
     Condition mMipiCon;
-    mutable Mutex mMipiLock;
+    mutable intel::MultiDisplayMutex mMipiLock;
+    // The MIPI power state wanted by the composer and the one applied to DRM,
+    // the DPMS call is made outside mLock, the latest target always wins
+    bool mMipiTarget;
+    bool mMipiApplied;
+    mutable Mutex mMipiPowerLock;
     KeyedVector<void *, MultiDisplayListener* > mListener;
     int mConnectStatus;
+    // The last timing set through HWC, a same timing isn't sent again
+    MDSHDMITiming mTiming;
+    bool mTimingValid;
     MDSVideoSourceInfo mVideo;
     int mVideoState;
 
@@ -117,7 +129,11 @@ private:
 
     void initialize_l();
     int setHdmiMode_l();
+    // Run the steps of a plan, @see MultiDisplayModePlan.h
+    int executeHdmiModePlan_l(const MDSHdmiModePlan& plan);
     int setMipiMode_l(bool);
+    void setMipiTarget_l(bool on);
+    void syncMipi();
     int setModePolicy_l(int);
     int getHdmiPlug_l();
     int isHwcSetUp_l();
@@ -126,7 +142,7 @@ private:
     int  setHdmiTiming_l(void* value, int size);
 
     virtual bool threadLoop();
-    inline bool checkMode(int value, int bit) {
+    static inline bool checkMode(int value, int bit) {
         if ((value & bit) == bit)
             return true;
         return false;
@@ -0,0 +1,31 @@
+# Table test of the HDMI mode planner, see mds_plan_test.cpp
+#
+#   mmm vendor/intel/hardware/libmultidisplay/ctp_legacy/tools/mds_plan_test
+#   adb shell /data/local/tmp/mds_plan_test -v
+
+LOCAL_PATH:= $(call my-dir)
+
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES := \
+    mds_plan_test.cpp \
+    ../../native/MultiDisplayModePlan.cpp
+
+LOCAL_MODULE := mds_plan_test
+LOCAL_MODULE_TAGS := optional
+LOCAL_MODULE_PATH := $(TARGET_OUT_DATA)/local/tmp
+
+LOCAL_C_INCLUDES := \
+    $(LOCAL_PATH)/../../native
+
+LOCAL_SHARED_LIBRARIES := \
+    libcutils libutils
+
+LOCAL_CFLAGS := -DLOG_TAG=\"MultiDisplayPlanTest\"
+
+# The steps are planned with the flags of the library
+ifeq ($(ENABLE_IMG_GRAPHICS),true)
+LOCAL_CFLAGS += -DDVI_SUPPORTED
+endif
+
+include $(BUILD_EXECUTABLE)
@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2012-2013, Intel Corporation. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/*
+ * Table test of planHdmiMode: each row is the input of a HDMI mode
+ * transition, and the steps, the final mode and the connect status
+ * expected from it. It is built with the flags of the library.
+ *
+ * usage: mds_plan_test [-v]
+ *   -v  print every row, by default only the failed ones
+ *
+ * The exit status is the number of the failed rows.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "drm_hdmi.h"
+#include "MultiDisplayModePlan.h"
+
+// The end of the expected steps
+static const int END = -1;
+
+// The modes of a connected sink
+static const int CONNECTED = MDS_HDMI_CONNECTED | MDS_HDMI_ON;
+static const int CLONED    = CONNECTED | MDS_HDMI_CLONE;
+static const int EXTENDED  = CONNECTED | MDS_HDMI_VIDEO_EXT | MDS_VIDEO_PLAYING;
+
+typedef struct {
+    const char* name;
+    MDSHdmiModeInput in;
+    int steps[MDS_STEP_MAX + 1];
+    int mode;
+    int connectStatus;
+} PlanCase;
+
+/*
+ * The inputs are in the order of MDSHdmiModeInput: mode, HDMI policy,
+ * MIPI policy, last and probed connect status, DRM ready,
+ * playing, protected.
+ */
+static const PlanCase sCases[] = {
+    { "disconnected, nothing changes",
+      { MDS_MIPI_ON, MDS_HDMI_ON_ALLOWED, MDS_MIPI_OFF_NOT_ALLOWED,
+        DRM_HDMI_DISCONNECTED, DRM_HDMI_DISCONNECTED, true, false, false },
+      { END },
+      MDS_MIPI_ON, DRM_HDMI_DISCONNECTED },
+    { "plug, clone",
+      { MDS_MIPI_ON, MDS_HDMI_ON_ALLOWED, MDS_MIPI_OFF_NOT_ALLOWED,
+        DRM_HDMI_DISCONNECTED, DRM_HDMI_CONNECTED, true, false, false },
+      { MDS_STEP_BROADCAST_TRANSITION, MDS_STEP_CLONE_TIMING,
+        MDS_STEP_HDMI_VIDEO_ON, MDS_STEP_BROADCAST, MDS_STEP_AUDIO_PLUG, END },
+      MDS_MIPI_ON | CLONED | MDS_OVERLAY_OFF, DRM_HDMI_CONNECTED },
+    { "video starts, extended",
+      { MDS_MIPI_ON | CLONED, MDS_HDMI_ON_ALLOWED, MDS_MIPI_OFF_NOT_ALLOWED,
+        DRM_HDMI_CONNECTED, DRM_HDMI_CONNECTED, true, true, false },
+      { MDS_STEP_BROADCAST_TRANSITION, MDS_STEP_VIDEO_TIMING,
+        MDS_STEP_BROADCAST, END },
+      MDS_MIPI_ON | EXTENDED, DRM_HDMI_CONNECTED },
+    { "protected video starts, HDCP on",
+      { MDS_MIPI_ON | CLONED, MDS_HDMI_ON_ALLOWED, MDS_MIPI_OFF_NOT_ALLOWED,
+        DRM_HDMI_CONNECTED, DRM_HDMI_CONNECTED, true, true, true },
+      { MDS_STEP_BROADCAST_TRANSITION, MDS_STEP_VIDEO_TIMING,
+        MDS_STEP_HDCP_ON, MDS_STEP_BROADCAST, END },
+      MDS_MIPI_ON | EXTENDED | MDS_HDCP_ON, DRM_HDMI_CONNECTED },
+    { "video goes on, nothing is broadcast",
+      { MDS_MIPI_ON | EXTENDED, MDS_HDMI_ON_ALLOWED, MDS_MIPI_OFF_ALLOWED,
+        DRM_HDMI_CONNECTED, DRM_HDMI_CONNECTED, true, true, false },
+      { END },
+      MDS_MIPI_ON | EXTENDED, DRM_HDMI_CONNECTED },
+    { "protected video stops, HDCP off, clone",
+      { MDS_MIPI_ON | EXTENDED | MDS_HDCP_ON, MDS_HDMI_ON_ALLOWED, MDS_MIPI_OFF_ALLOWED,
+        DRM_HDMI_CONNECTED, DRM_HDMI_CONNECTED, true, false, false },
+      { MDS_STEP_BROADCAST_TRANSITION, MDS_STEP_HDCP_OFF,
+        MDS_STEP_CLONE_TIMING, MDS_STEP_BROADCAST, END },
+      MDS_MIPI_ON | CLONED | MDS_OVERLAY_OFF, DRM_HDMI_CONNECTED },
+    { "HDMI is not allowed, turned off",
+      { MDS_MIPI_ON | CLONED, MDS_HDMI_ON_NOT_ALLOWED, MDS_MIPI_OFF_NOT_ALLOWED,
+        DRM_HDMI_CONNECTED, DRM_HDMI_CONNECTED, true, false, false },
+      { MDS_STEP_BROADCAST, MDS_STEP_HDMI_VIDEO_OFF, END },
+      MDS_MIPI_ON | MDS_HDMI_CONNECTED, DRM_HDMI_CONNECTED },
+    { "unplug while extended, MIPI on",
+      { EXTENDED, MDS_HDMI_ON_ALLOWED, MDS_MIPI_OFF_ALLOWED,
+        DRM_HDMI_CONNECTED, DRM_HDMI_DISCONNECTED, true, true, false },
+      { MDS_STEP_MIPI_ON, MDS_STEP_AUDIO_UNPLUG, MDS_STEP_HDCP_RESET,
+        MDS_STEP_BROADCAST, MDS_STEP_HDMI_DISCONNECTED, END },
+      MDS_MIPI_ON | MDS_VIDEO_PLAYING,
+      DRM_HDMI_DISCONNECTED },
+};
+
+static void printSteps(const char* label, const int* steps, int count) {
+    printf("  %s:", label);
+    for (int i = 0; i < count; i++)
+        printf(" %d", steps[i]);
+    printf("\n");
+}
+
+static bool runCase(const PlanCase& c, bool verbose) {
+    MDSHdmiModePlan plan;
+    planHdmiMode(c.in, &plan);
+    int count = 0;
+    while (c.steps[count] != END)
+        count++;
+    bool ok = plan.count == count &&
+        memcmp(plan.steps, c.steps, count * sizeof(int)) == 0 &&
+        plan.mode == c.mode && plan.connectStatus == c.connectStatus;
+    if (!ok || verbose) {
+        printf("%s: %s\n", ok ? "ok" : "FAIL", c.name);
+        printSteps("steps", plan.steps, plan.count);
+        if (!ok) {
+            printSteps("expected", c.steps, count);
+            printf("  mode 0x%x, expected 0x%x, connect %d, expected %d\n",
+                    plan.mode, c.mode, plan.connectStatus, c.connectStatus);
+        }
+    }
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    bool verbose = false;
+    int opt;
+    while ((opt = getopt(argc, argv, "v")) != -1) {
+        switch (opt) {
+            case 'v':
+                verbose = true;
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-v]\n", argv[0]);
+                return -1;
+        }
+    }
+    int total = sizeof(sCases) / sizeof(sCases[0]);
+    int failures = 0;
+    for (int i = 0; i < total; i++) {
+        if (!runCase(sCases[i], verbose))
+            failures++;
+    }
+    printf("%d of %d cases passed\n", total - failures, total);
+    return failures;
+}
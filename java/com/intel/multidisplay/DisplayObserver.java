@@ -86,10 +86,8 @@ public class DisplayObserver {
     private final int MSG_AUDIO_ROUTER_CHANGE = 0;
     private final int MSG_EDP_CONNECTION_CHANGE = 1;
     private final int MSG_ENABLE_EDP_SETTING = 2;
-    private final int MSG_INPUT_TIMEOUT = 3;
     private final int MSG_START_MONITORING_INPUT = 4;
     private final int MSG_STOP_MONITORING_INPUT = 5;
-    private final int INPUT_TIMEOUT_MSEC = 5000;
 
     // Broadcast receiver for device connections intent broadcasts
     private final BroadcastReceiver mReceiver = new DisplayObserverBroadcastReceiver();
@@ -111,12 +109,8 @@ public class DisplayObserver {
     private WindowManagerPolicy.WindowManagerFuncs mWindowManagerFuncs;
 
     public void onInputEvent() {
-        logv("input is active");
-        mDs.updateInputState(true);
-        if (mHandler.hasMessages(MSG_INPUT_TIMEOUT))
-            mHandler.removeMessages(MSG_INPUT_TIMEOUT);
-
-        mHandler.sendEmptyMessageDelayed(MSG_INPUT_TIMEOUT, INPUT_TIMEOUT_MSEC);
+        // MDS detects the input idle timeout itself
+        mDs.notifyInputActivity();
     }
 
     private void startMonitoringInput() {
@@ -138,7 +132,7 @@ public class DisplayObserver {
                 mTouchEventListener);
 
         // start "input idle" count down
-        mHandler.sendEmptyMessageDelayed(MSG_INPUT_TIMEOUT, INPUT_TIMEOUT_MSEC);
+        mDs.notifyInputActivity();
     }
 
     private void stopMonitoringInput() {
@@ -150,10 +144,6 @@ public class DisplayObserver {
         mWindowManagerFuncs.unregisterPointerEventListener(
                 mTouchEventListener);
         mTouchEventListener = null;
-
-        if (mHandler.hasMessages(MSG_INPUT_TIMEOUT)) {
-            mHandler.removeMessages(MSG_INPUT_TIMEOUT);
-        }
     }
 
     public DisplayObserver(Context context,
@@ -170,6 +160,7 @@ public class DisplayObserver {
         intentFilter.addAction(mDs.MDS_SET_HDMI_MODE);
         intentFilter.addAction(mDs.MDS_SET_HDMI_SCALE);
         intentFilter.addAction(mDs.MDS_SET_HDMI_STEP_SCALE);
+        intentFilter.addAction(mDs.MDS_SET_DISPLAY_CONFIG);
         intentFilter.addAction(DisplayManager.ACTION_WIFI_DISPLAY_STATUS_CHANGED);
 
         mContext.registerReceiver(mReceiver, intentFilter);
@@ -354,10 +345,6 @@ public class DisplayObserver {
             case MSG_ENABLE_EDP_SETTING:
                 enableHdmiSetting(msg.arg1);
                 break;
-            case MSG_INPUT_TIMEOUT:
-                logv("input is idle");
-                mDs.updateInputState(false);
-                break;
             case MSG_START_MONITORING_INPUT:
                 startMonitoringInput();
                 break;
@@ -396,8 +383,9 @@ public class DisplayObserver {
                 if (!mHDMIConnected && !mDVIConnected) {
                     return;
                 }
-                // Get Number of Timing Info
-                int Count = mDs.getHdmiInfoCount();
+                // Get Timing Info and its count in one call
+                int[] timings = new int[mDs.HDMI_TIMING_MAX * mDs.HDMI_TIMING_STRIDE];
+                int Count = mDs.getHdmiTimings(timings);
                 Intent outIntent = new Intent(mDs.MDS_HDMI_INFO);
                 outIntent.addFlags(Intent.FLAG_RECEIVER_REGISTERED_ONLY);
                 Bundle mBundle = new Bundle();
@@ -407,7 +395,14 @@ public class DisplayObserver {
                 int[] arrRefresh = new int[Count];
                 int[] arrInterlace = new int[Count];
                 int[] arrRatio = new int[Count];
-                mDs.getHdmiTiming(arrWidth, arrHeight, arrRefresh, arrInterlace, arrRatio);
+                for (int i = 0; i < Count; i++) {
+                    int record = i * mDs.HDMI_TIMING_STRIDE;
+                    arrWidth[i] = timings[record + mDs.HDMI_TIMING_WIDTH];
+                    arrHeight[i] = timings[record + mDs.HDMI_TIMING_HEIGHT];
+                    arrRefresh[i] = timings[record + mDs.HDMI_TIMING_REFRESH];
+                    arrInterlace[i] = timings[record + mDs.HDMI_TIMING_INTERLACE];
+                    arrRatio[i] = timings[record + mDs.HDMI_TIMING_RATIO];
+                }
                 mBundle.putSerializable("width", arrWidth);
                 mBundle.putSerializable("height", arrHeight);
                 mBundle.putSerializable("refresh", arrRefresh);
@@ -472,6 +467,36 @@ public class DisplayObserver {
                 logv("set scale info step:" +  Step);
                 if(!mDs.setHdmiOverscan(mHoriRatio, mVertRatio))
                     logv("Set HDMI Step Scale error");
+            } else if (action.equals(mDs.MDS_SET_DISPLAY_CONFIG)) {
+                // Set timing, scale type and overscan in one transaction
+                Bundle extras = intent.getExtras();
+                if (extras == null)
+                     return;
+                int fields = 0;
+                if (extras.containsKey("width"))
+                    fields |= mDs.CONFIG_TIMING;
+                if (extras.containsKey("Type"))
+                    fields |= mDs.CONFIG_SCALING;
+                if (extras.containsKey("hStep") || extras.containsKey("vStep"))
+                    fields |= mDs.CONFIG_OVERSCAN;
+                int Width = extras.getInt("width", 0);
+                int Height = extras.getInt("height", 0);
+                int Refresh = extras.getInt("refresh", 0);
+                int Ratio = extras.getInt("ratio", 0);
+                int Interlace = extras.getInt("interlace", 0);
+                int ScaleType = extras.getInt("Type", 0);
+                int hStep = extras.getInt("hStep", mHoriRatio);
+                int vStep = extras.getInt("vStep", mVertRatio);
+                logv("Set display config " + fields + ": " + Width + "x" + Height + "@"
+                        + Refresh + "," + Interlace + "," + Ratio + ", scale " + ScaleType
+                        + ", step " + hStep + "," + vStep);
+                if (!mDs.applyDisplayConfig(fields, Width, Height, Refresh,
+                            Interlace, Ratio, ScaleType, hStep, vStep)) {
+                    logv("Set display config error");
+                } else if ((fields & mDs.CONFIG_OVERSCAN) != 0) {
+                    mHoriRatio = hStep;
+                    mVertRatio = vStep;
+                }
             } else if(action.equals(DisplayManager.ACTION_WIFI_DISPLAY_STATUS_CHANGED)) {
                 boolean connected = false;
                 WifiDisplayStatus status = (WifiDisplayStatus)intent.getParcelableExtra(DisplayManager.EXTRA_WIFI_DISPLAY_STATUS);
@@ -45,12 +45,28 @@ public class DisplaySetting {
     /// MDS message type
     public static final int MDS_MSG_MODE_CHANGE = 1 << 1;
     public static final int MDS_MSG_HOT_PLUG    = 1 << 2;
+    public static final int MDS_MSG_READY       = 1 << 3;
+    public static final int MDS_MSG_DISPLAY_STATE = 1 << 4;
 
     /// MDS display capability
     public static final int DISPLAY_PRIMARY  = 0;
     public static final int DISPLAY_EXTERNAL = 1;
     public static final int DISPLAY_VIRTUAL  = 2;
 
+    /// Display config fields
+    public static final int CONFIG_TIMING   = 1;
+    public static final int CONFIG_SCALING  = 1 << 1;
+    public static final int CONFIG_OVERSCAN = 1 << 2;
+
+    /// HDMI timing list, the max count and the packed record layout
+    public static final int HDMI_TIMING_MAX       = 128;
+    public static final int HDMI_TIMING_WIDTH     = 0;
+    public static final int HDMI_TIMING_HEIGHT    = 1;
+    public static final int HDMI_TIMING_REFRESH   = 2;
+    public static final int HDMI_TIMING_INTERLACE = 3;
+    public static final int HDMI_TIMING_RATIO     = 4;
+    public static final int HDMI_TIMING_STRIDE    = 5;
+
     /// External display device type
     public static final int EDP_HDMI    = 1;
     public static final int EDP_DVI     = 2;
@@ -61,6 +77,7 @@ public class DisplaySetting {
     public static final String MDS_HDMI_INFO           = "android.intel.mds.HDMI_INFO";
     public static final String MDS_SET_HDMI_SCALE      = "android.intel.mds.SET.HDMI_SCALE";
     public static final String MDS_SET_HDMI_STEP_SCALE = "android.intel.mds.SET.HDMI_STEP_SCALE";
+    public static final String MDS_SET_DISPLAY_CONFIG  = "android.intel.mds.SET.DISPLAY_CONFIG";
     public static final String MDS_GET_BOOT_STATUS     = "android.intel.mds.GET.BOOT_STATUS";
     public static final String MDS_BOOT_STATUS         = "android.intel.mds.BOOT_STATUS";
     public static final String MDS_ALLOW_MODE_SET       = "android.intel.mds.ALLOW_MODE_SET";
@@ -74,13 +91,19 @@ public class DisplaySetting {
     private static native int     native_getHdmiTiming(int width[],
                                                 int height[], int refresh[],
                                                 int interlace[], int ratio[]);
+    private static native int     native_getHdmiTimings(int timings[]);
     private static native boolean native_setHdmiTiming(int width, int height,
                             int refresh, int interlace, int ratio);
     private static native int     native_getHdmiInfoCount();
     private static native boolean native_setHdmiScaleType(int Type);
     private static native boolean native_setHdmiOverscan(int h, int v);
+    private static native boolean native_applyDisplayConfig(int fields,
+                            int width, int height, int refresh,
+                            int interlace, int ratio,
+                            int type, int h, int v);
     private static native int     native_updatePhoneCallState(boolean state);
     private static native int     native_updateInputState(boolean state);
+    private static native int     native_notifyInputActivity();
     private static native int     native_setVppState(int dpyId, boolean state);
 
     public DisplaySetting() {
@@ -113,6 +136,15 @@ public class DisplaySetting {
                                     refresh, interlace, ratio);
     }
 
+    /**
+     * Get the HDMI timings in one call, each timing is a record of
+     * HDMI_TIMING_STRIDE ints, @see HDMI_TIMING_WIDTH etc.
+     * @return the count of timings written into "timings"
+     */
+    public int getHdmiTimings(int timings[]) {
+        return native_getHdmiTimings(timings);
+    }
+
     public boolean setHdmiTiming(int width, int height,
                         int refresh, int interlace, int ratio) {
         return native_setHdmiTiming(width, height,
@@ -135,6 +167,14 @@ public class DisplaySetting {
         return native_setHdmiOverscan(hValue, vValue);
     }
 
+    public boolean applyDisplayConfig(int fields,
+                        int width, int height, int refresh,
+                        int interlace, int ratio,
+                        int type, int hValue, int vValue) {
+        return native_applyDisplayConfig(fields, width, height, refresh,
+                            interlace, ratio, type, hValue, vValue);
+    }
+
     public int updatePhoneCallState(boolean phoneState) {
         return native_updatePhoneCallState(phoneState);
     }
@@ -143,6 +183,15 @@ public class DisplaySetting {
         return native_updateInputState(inputState);
     }
 
+    /**
+     * Report input activity, MDS sends the input idle and active
+     * transitions to the display by itself. It is rate limited and
+     * doesn't wait for MDS, so it is cheap to call on every input event.
+     */
+    public int notifyInputActivity() {
+        return native_notifyInputActivity();
+    }
+
     public int setVppState(int dpyId, boolean state) {
         return native_setVppState(dpyId, state);
     }
@@ -24,12 +24,15 @@
 #include <utils/Log.h>
 #include <utils/Errors.h>
 #include <utils/threads.h>
+#include <utils/Vector.h>
+#include <cutils/atomic.h>
 
 #include <binder/Parcel.h>
 #include <binder/ProcessState.h>
 #include <binder/IServiceManager.h>
 
 #include <display/MultiDisplayService.h>
+#include "MultiDisplayTrace.h"
 
 namespace android {
 namespace intel {
@@ -37,29 +40,90 @@ namespace intel {
 
 #define CLASS_PATH_NAME  "com/intel/multidisplay/DisplaySetting"
 
-sp<IMDService>  gMds = NULL;
+// MDS proxies, they are fetched once at init and not changed until deinit,
+// so the native methods can use them concurrently without a lock.
+class MDSClient : public RefBase {
+public:
+    sp<IMDService>                  mds;
+    sp<IMultiDisplayHdmiControl>    hdmiControl;
+    sp<IMultiDisplayInfoProvider>   infoProvider;
+    sp<IMultiDisplayEventMonitor>   eventMonitor;
+    sp<IMultiDisplaySinkRegistrar>  sinkRegistrar;
+#ifdef TARGET_HAS_VPP
+    sp<IMultiDisplayVppConfig>      vppConfig;
+#endif
+};
+
+// gMutex serializes init and deinit only,
+// gClientLock protects the publication of gClient.
 static Mutex    gMutex;
+static RWLock   gClientLock;
+static sp<MDSClient> gClient = NULL;
 static sp<class JNIMDSListener>    gListener = NULL;
 static int32_t  gListenerId = -1;
+// Input activity is reported to MDS at most once in this period
+static const int INPUT_ACTIVITY_INTERVAL_MS = 500;
+static volatile int32_t gLastInputActivity = 0;
 
+static sp<MDSClient> getClient() {
+    RWLock::AutoRLock _l(gClientLock);
+    return gClient;
+}
 
-class JNIMDSListener : public BnMultiDisplayListener
+static void setClient(const sp<MDSClient>& client) {
+    sp<MDSClient> old;
+    {
+        RWLock::AutoWLock _l(gClientLock);
+        old = gClient;
+        gClient = client;
+    }
+    // The old proxies are released out of the lock
+    old = NULL;
+}
+
+
+// Delivers MDS messages to Java on its own thread, which stays
+// attached to the VM, so the binder thread of MDS never waits on Java.
+class JNIMDSDeliveryThread : public Thread
 {
 public:
-    JNIMDSListener(JNIEnv* env, jobject thiz, jobject serviceObj);
-    ~JNIMDSListener();
-    status_t onMdsMessage(int msg, void* value, int size);
+    JNIMDSDeliveryThread(JNIEnv* env, jobject serviceObj);
+    void post(int msg, int value);
+    void stop();
 
 private:
-    jobject mServiceObj; // reference to DisplaySetting Java object to call back
+    struct Message {
+        int msg;
+        int value;
+#ifdef MDS_TRACE
+        // The trace flow from the binder thread to Java
+        int traceId;
+#endif
+    };
+    Mutex     mLock;
+    Condition mCondition;
+    Vector<Message> mQueue;
+#ifdef MDS_TRACE
+    int       mTraceId;
+#endif
+    JNIEnv*   mEnv;
+    jobject   mServiceObj; // reference to DisplaySetting Java object to call back
     jmethodID mOnMdsMessageMethodID; // onMdsMessage method id
+
+    virtual status_t readyToRun();
+    virtual bool threadLoop();
 };
 
-JNIMDSListener::JNIMDSListener(JNIEnv* env, jobject thiz, jobject serviceObj)
+JNIMDSDeliveryThread::JNIMDSDeliveryThread(JNIEnv* env, jobject serviceObj)
+    : Thread(true),
+      mEnv(NULL),
+      mServiceObj(NULL),
+      mOnMdsMessageMethodID(NULL)
 {
-    LOGI("Creating JNI MDS listener.");
+#ifdef MDS_TRACE
+    mTraceId = 0;
+#endif
     jclass clazz = env->FindClass(CLASS_PATH_NAME);
-    mOnMdsMessageMethodID = NULL;
     if (clazz == NULL) {
         LOGE("%s: Fail to find class %s", __func__, CLASS_PATH_NAME);
     } else {
@@ -67,6 +131,7 @@ JNIMDSListener::JNIMDSListener(JNIEnv* env, jobject thiz, jobject serviceObj)
         if (mOnMdsMessageMethodID == NULL) {
             LOGE("%s: Fail to find onMdsMessage method.", __func__);
         }
+        env->DeleteLocalRef(clazz);
     }
 
     mServiceObj  = env->NewGlobalRef(serviceObj);
@@ -75,38 +140,114 @@ JNIMDSListener::JNIMDSListener(JNIEnv* env, jobject thiz, jobject serviceObj)
     }
 }
 
-JNIMDSListener::~JNIMDSListener() {
-    LOGI("%s: Releasing MDS listener.", __func__);
-    JNIEnv *env = AndroidRuntime::getJNIEnv();
-    if (env) {
-        // remove global reference
-        env->DeleteGlobalRef(mServiceObj);
+void JNIMDSDeliveryThread::post(int msg, int value) {
+    Mutex::Autolock _l(mLock);
+    // Only the latest mode matters, so a pending mode change is replaced
+    size_t size = mQueue.size();
+    if (msg == (int)MDS_MSG_MODE_CHANGE && size > 0 &&
+            mQueue[size - 1].msg == msg) {
+        mQueue.editItemAt(size - 1).value = value;
+        return;
     }
+    Message m;
+    m.msg   = msg;
+    m.value = value;
+#ifdef MDS_TRACE
+    m.traceId = ++mTraceId;
+    MDS_TRACE_ASYNC_BEGIN("MDS message", m.traceId);
+#endif
+    mQueue.push(m);
+    mCondition.signal();
 }
 
-status_t JNIMDSListener::onMdsMessage(int msg, void* value, int size)
-{
-    JNIEnv *env = AndroidRuntime::getJNIEnv();
-    if (env == NULL) {
+void JNIMDSDeliveryThread::stop() {
+    {
+        Mutex::Autolock _l(mLock);
+        requestExit();
+        mCondition.signal();
+    }
+    requestExitAndWait();
+}
+
+status_t JNIMDSDeliveryThread::readyToRun() {
+    mEnv = AndroidRuntime::getJNIEnv();
+    if (mEnv == NULL) {
         LOGE("%s: Faild to get JNI Env.", __func__);
         return NO_INIT;
     }
+    return NO_ERROR;
+}
+
+bool JNIMDSDeliveryThread::threadLoop() {
+    Message m;
+    {
+        Mutex::Autolock _l(mLock);
+        while (mQueue.isEmpty() && !exitPending())
+            mCondition.wait(mLock);
+        if (exitPending()) {
+            mQueue.clear();
+            if (mServiceObj) {
+                mEnv->DeleteGlobalRef(mServiceObj);
+                mServiceObj = NULL;
+            }
+            return false;
+        }
+        m = mQueue[0];
+        mQueue.removeAt(0);
+    }
 
     if (!mServiceObj || !mOnMdsMessageMethodID) {
         LOGE("%s: Invalid service object or method ID", __func__);
-        return NO_INIT;
+        return true;
     }
 
-    if (msg == (int)MDS_MSG_MODE_CHANGE) {
-        LOGV("Get a MDS mode change message %d, 0x%x", msg, *((int*)value));
-        env->CallVoidMethod(mServiceObj, mOnMdsMessageMethodID, (int)msg, *((int*)value));
+    LOGV("Deliver a MDS message %d, 0x%x", m.msg, m.value);
+    MDS_TRACE_ASYNC_END("MDS message", m.traceId);
+    MDS_TRACE_NAME("DisplaySetting.onMdsMessage");
+    mEnv->CallVoidMethod(mServiceObj, mOnMdsMessageMethodID, m.msg, m.value);
+    if (mEnv->ExceptionCheck()) {
+        LOGW("%s: Exception occurred while posting message.", __func__);
+        mEnv->ExceptionClear();
     }
+    return true;
+}
 
-    if (env->ExceptionCheck()) {
-        LOGW("%s: Exception occurred while posting message.", __func__);
-        env->ExceptionClear();
+class JNIMDSListener : public BnMultiDisplayListener
+{
+public:
+    JNIMDSListener(JNIEnv* env, jobject thiz, jobject serviceObj);
+    ~JNIMDSListener();
+    status_t onMdsMessage(int msg, void* value, int size);
+
+private:
+    sp<JNIMDSDeliveryThread> mDelivery;
+};
+
+JNIMDSListener::JNIMDSListener(JNIEnv* env, jobject thiz, jobject serviceObj)
+{
+    LOGI("Creating JNI MDS listener.");
+    mDelivery = new JNIMDSDeliveryThread(env, serviceObj);
+    if (mDelivery->run("MDSJNIDelivery", PRIORITY_FOREGROUND) != NO_ERROR) {
+        LOGE("%s: Fail to start MDS message delivery thread", __func__);
     }
+}
 
+JNIMDSListener::~JNIMDSListener() {
+    LOGI("%s: Releasing MDS listener.", __func__);
+    // The global reference is removed by the delivery thread
+    mDelivery->stop();
+    mDelivery = NULL;
+}
+
+status_t JNIMDSListener::onMdsMessage(int msg, void* value, int size)
+{
+    if (value == NULL || size < (int)sizeof(int))
+        return BAD_VALUE;
+
+    if (msg == (int)MDS_MSG_MODE_CHANGE) {
+        LOGV("Get a MDS mode change message %d, 0x%x", msg, *((int*)value));
+        mDelivery->post(msg, *((int*)value));
+    }
     return NO_ERROR;
 }
 
@@ -123,21 +264,29 @@ static jboolean MDS_InitMDSClient(JNIEnv* env, jobject thiz, jobject serviceObj)
         LOGE("%s: Fail to get service manager", __func__);
         return false;
     }
-    gMds = interface_cast<IMDService>(sm->getService(String16(INTEL_MDS_SERVICE_NAME)));
-    if (gMds == NULL) {
+    sp<MDSClient> client = new MDSClient();
+    client->mds = interface_cast<IMDService>(sm->getService(String16(INTEL_MDS_SERVICE_NAME)));
+    if (client->mds == NULL) {
         LOGE("%s: Failed to get MDS service", __func__);
         return false;
     }
+    client->hdmiControl   = client->mds->getHdmiControl();
+    client->infoProvider  = client->mds->getInfoProvider();
+    client->eventMonitor  = client->mds->getEventMonitor();
+    client->sinkRegistrar = client->mds->getSinkRegistrar();
+#ifdef TARGET_HAS_VPP
+    client->vppConfig     = client->mds->getVppConfig();
+#endif
+    setClient(client);
 
     gListener = new JNIMDSListener(env, thiz, serviceObj);
     if (gListener == NULL) {
         LOGE("%s: Failed to create JNIMDSListener instance.", __func__);
         return false;
     }
-    sp<IMultiDisplaySinkRegistrar> sinkRegistrar = NULL;
-    if ((sinkRegistrar = gMds->getSinkRegistrar()) == NULL)
+    if (client->sinkRegistrar == NULL)
         return false;
-    gListenerId = sinkRegistrar->registerListener(gListener,
+    gListenerId = client->sinkRegistrar->registerListener(gListener,
             "DisplaySetting", MDS_MSG_MODE_CHANGE);
     ALOGV("MDS JNI listener ID %d", gListenerId);
     return true;
@@ -146,26 +295,37 @@ static jboolean MDS_InitMDSClient(JNIEnv* env, jobject thiz, jobject serviceObj)
 static jboolean MDS_DeInitMDSClient(JNIEnv* env, jobject obj)
 {
     AutoMutex _l(gMutex);
-    sp<IMultiDisplaySinkRegistrar> sinkRegistrar = NULL;
-    if (gListenerId >= 0 && gListener != NULL && gMds != NULL &&
-            (sinkRegistrar = gMds->getSinkRegistrar()) != NULL) {
-        sinkRegistrar->unregisterListener(gListenerId);
+    sp<MDSClient> client = getClient();
+    if (gListenerId >= 0 && gListener != NULL && client != NULL &&
+            client->sinkRegistrar != NULL) {
+        client->sinkRegistrar->unregisterListener(gListenerId);
     }
     gListenerId = -1;
     gListener   = NULL;
+    // The calls made after this see no client, and the proxies are freed
+    setClient(NULL);
     LOGI("%s: Release MultiDisplay JNI client.", __func__);
     return true;
 }
 
 static jint MDS_getMode(JNIEnv* env, jobject obj)
 {
-    AutoMutex _l(gMutex);
-    if (gMds == NULL) return 0;
-    sp<IMultiDisplayInfoProvider> infoProvider = gMds->getInfoProvider();
-    if (infoProvider == NULL) return 0;
+    sp<MDSClient> client = getClient();
+    if (client == NULL || client->infoProvider == NULL) return 0;
+    sp<IMultiDisplayInfoProvider> infoProvider = client->infoProvider;
     return infoProvider->getDisplayMode(true);
 }
 
+// The fields of a timing record in the packed timing array
+enum {
+    HDMI_TIMING_WIDTH = 0,
+    HDMI_TIMING_HEIGHT,
+    HDMI_TIMING_REFRESH,
+    HDMI_TIMING_INTERLACE,
+    HDMI_TIMING_RATIO,
+    HDMI_TIMING_STRIDE,
+};
+
 static jint MDS_getHdmiTiming(
     JNIEnv* env,
     jobject obj,
@@ -175,52 +335,61 @@ static jint MDS_getHdmiTiming(
     jintArray interlace,
     jintArray ratio)
 {
-    AutoMutex _l(gMutex);
-    if (gMds == NULL) return 0;
-    sp<IMultiDisplayHdmiControl> hdmiControl = gMds->getHdmiControl();
-    if (hdmiControl == NULL) return 0;
-    int32_t* pWidth = env->GetIntArrayElements(width, NULL);
-    int32_t* pHeight = env->GetIntArrayElements(height, NULL);
-    int32_t* pRefresh = env->GetIntArrayElements(refresh, NULL);
-    int32_t* pInterlace = env->GetIntArrayElements(interlace, NULL);
-    int32_t* pRatio = env->GetIntArrayElements(ratio, NULL);
-    // The total supported timing count
-    jint iCount = hdmiControl->getHdmiTimingCount();
-
-    if (iCount > 0) {
-        jint i,j;
-        MDSHdmiTiming *list[iCount];
-        memset(list, 0, iCount * sizeof(MDSHdmiTiming*));
-        for (i = 0; i < iCount; i++) {
-            list[i] = (MDSHdmiTiming *)malloc(sizeof(MDSHdmiTiming));
-            if (list[i] == NULL) {
-                for (j = 0; j < i; j++)
-                    if (list[j]) free(list[j]);
-                return 0;
-            }
-            memset(list[i], 0, sizeof(MDSHdmiTiming));
-        }
-
-        hdmiControl->getHdmiTimingList(iCount, list);
-        for (i = 0; i < iCount; i++) {
-            pRatio[i]     = list[i]->ratio;
-            pWidth[i]     = list[i]->width;
-            pHeight[i]    = list[i]->height;
-            pRefresh[i]   = list[i]->refresh;
-            pInterlace[i] = list[i]->interlace;
-        }
-
-        for (i = 0; i < iCount; i++) {
-            if (list[i]) free(list[i]);
-        }
+    sp<MDSClient> client = getClient();
+    if (client == NULL || client->hdmiControl == NULL) return 0;
+    // Don't write beyond the shortest array
+    jintArray arrays[] = { width, height, refresh, interlace, ratio };
+    jint max = MDS_HDMI_TIMING_MAX;
+    for (size_t i = 0; i < NELEM(arrays); i++) {
+        if (arrays[i] == NULL) return 0;
+        jint length = env->GetArrayLength(arrays[i]);
+        if (length < max) max = length;
     }
+    if (max <= 0) return 0;
+
+    MDSHdmiTiming list[MDS_HDMI_TIMING_MAX];
+    jint count = client->hdmiControl->getHdmiTimings(list, max);
+    if (count <= 0) return 0;
+
+    jint field[MDS_HDMI_TIMING_MAX];
+    for (jint i = 0; i < count; i++) field[i] = list[i].width;
+    env->SetIntArrayRegion(width, 0, count, field);
+    for (jint i = 0; i < count; i++) field[i] = list[i].height;
+    env->SetIntArrayRegion(height, 0, count, field);
+    for (jint i = 0; i < count; i++) field[i] = list[i].refresh;
+    env->SetIntArrayRegion(refresh, 0, count, field);
+    for (jint i = 0; i < count; i++) field[i] = list[i].interlace;
+    env->SetIntArrayRegion(interlace, 0, count, field);
+    for (jint i = 0; i < count; i++) field[i] = list[i].ratio;
+    env->SetIntArrayRegion(ratio, 0, count, field);
+    return count;
+}
 
-    env->ReleaseIntArrayElements(width, pWidth, 0);
-    env->ReleaseIntArrayElements(height, pHeight, 0);
-    env->ReleaseIntArrayElements(refresh, pRefresh, 0);
-    env->ReleaseIntArrayElements(interlace, pInterlace, 0);
-    env->ReleaseIntArrayElements(ratio, pRatio, 0);
-    return iCount;
+static jint MDS_getHdmiTimings(JNIEnv* env, jobject obj, jintArray timings)
+{
+    sp<MDSClient> client = getClient();
+    if (client == NULL || client->hdmiControl == NULL) return 0;
+    if (timings == NULL) return 0;
+    jint max = env->GetArrayLength(timings) / HDMI_TIMING_STRIDE;
+    if (max > MDS_HDMI_TIMING_MAX) max = MDS_HDMI_TIMING_MAX;
+    if (max <= 0) return 0;
+
+    // The count and the list come from one transaction
+    MDSHdmiTiming list[MDS_HDMI_TIMING_MAX];
+    jint count = client->hdmiControl->getHdmiTimings(list, max);
+    if (count <= 0) return 0;
+
+    jint packed[MDS_HDMI_TIMING_MAX * HDMI_TIMING_STRIDE];
+    for (jint i = 0; i < count; i++) {
+        jint* record = packed + i * HDMI_TIMING_STRIDE;
+        record[HDMI_TIMING_WIDTH]     = list[i].width;
+        record[HDMI_TIMING_HEIGHT]    = list[i].height;
+        record[HDMI_TIMING_REFRESH]   = list[i].refresh;
+        record[HDMI_TIMING_INTERLACE] = list[i].interlace;
+        record[HDMI_TIMING_RATIO]     = list[i].ratio;
+    }
+    env->SetIntArrayRegion(timings, 0, count * HDMI_TIMING_STRIDE, packed);
+    return count;
 }
 
 static jboolean MDS_setHdmiTiming(
@@ -232,10 +401,9 @@ static jboolean MDS_setHdmiTiming(
     jint interlace,
     jint ratio)
 {
-    AutoMutex _l(gMutex);
-    if (gMds == NULL) return false;
-    sp<IMultiDisplayHdmiControl> hdmiControl = gMds->getHdmiControl();
-    if (hdmiControl == NULL) return 0;
+    sp<MDSClient> client = getClient();
+    if (client == NULL || client->hdmiControl == NULL) return 0;
+    sp<IMultiDisplayHdmiControl> hdmiControl = client->hdmiControl;
 
     MDSHdmiTiming timing;
     timing.ratio = ratio;
@@ -250,58 +418,98 @@ static jboolean MDS_setHdmiTiming(
 
 static jint MDS_getHdmiInfoCount(JNIEnv* env, jobject obj)
 {
-    AutoMutex _l(gMutex);
-    if (gMds == NULL) return 0;
-    sp<IMultiDisplayHdmiControl> hdmiControl = gMds->getHdmiControl();
-    if (hdmiControl == NULL) return 0;
+    sp<MDSClient> client = getClient();
+    if (client == NULL || client->hdmiControl == NULL) return 0;
+    sp<IMultiDisplayHdmiControl> hdmiControl = client->hdmiControl;
     return hdmiControl->getHdmiTimingCount();
 }
 
 static jboolean MDS_setHdmiScaleType(JNIEnv* env, jobject obj, jint type)
 {
-    AutoMutex _l(gMutex);
-    if (gMds == NULL) return false;
-    sp<IMultiDisplayHdmiControl> hdmiControl = gMds->getHdmiControl();
-    if (hdmiControl == NULL) return false;
+    sp<MDSClient> client = getClient();
+    if (client == NULL || client->hdmiControl == NULL) return false;
+    sp<IMultiDisplayHdmiControl> hdmiControl = client->hdmiControl;
     status_t ret = hdmiControl->setHdmiScalingType((MDS_SCALING_TYPE)type);
     return (ret == NO_ERROR ? true : false);
 }
 
 static jboolean MDS_setHdmiOverscan(JNIEnv* env, jobject obj, jint hValue, jint vValue)
 {
-    AutoMutex _l(gMutex);
-    if (gMds == NULL) return false;
-    sp<IMultiDisplayHdmiControl> hdmiControl = gMds->getHdmiControl();
-    if (hdmiControl == NULL) return false;
+    sp<MDSClient> client = getClient();
+    if (client == NULL || client->hdmiControl == NULL) return false;
+    sp<IMultiDisplayHdmiControl> hdmiControl = client->hdmiControl;
     status_t ret = hdmiControl->setHdmiOverscan(hValue, vValue);
     return (ret == NO_ERROR ? true : false);
 }
 
+static jboolean MDS_applyDisplayConfig(
+    JNIEnv* env,
+    jobject obj,
+    jint fields,
+    jint width,
+    jint height,
+    jint refresh,
+    jint interlace,
+    jint ratio,
+    jint type,
+    jint hValue,
+    jint vValue)
+{
+    sp<MDSClient> client = getClient();
+    if (client == NULL || client->hdmiControl == NULL) return false;
+    sp<IMultiDisplayHdmiControl> hdmiControl = client->hdmiControl;
+
+    MDSDisplayConfig config;
+    memset(&config, 0, sizeof(MDSDisplayConfig));
+    config.fields = fields;
+    config.timing.ratio = ratio;
+    config.timing.width = width;
+    config.timing.height = height;
+    config.timing.refresh = refresh;
+    config.timing.interlace = interlace;
+    config.scaling = (MDS_SCALING_TYPE)type;
+    config.hOverscan = hValue;
+    config.vOverscan = vValue;
+
+    status_t ret = hdmiControl->applyDisplayConfig(config);
+    return (ret == NO_ERROR ? true : false);
+}
+
 static jint MDS_updatePhoneCallState(JNIEnv* env, jobject obj, jboolean state)
 {
-    AutoMutex _l(gMutex);
-    if (gMds == NULL) return 0;
-    sp<IMultiDisplayEventMonitor> eventMonitor = gMds->getEventMonitor();
-    if (eventMonitor == NULL) return 0;
+    sp<MDSClient> client = getClient();
+    if (client == NULL || client->eventMonitor == NULL) return 0;
+    sp<IMultiDisplayEventMonitor> eventMonitor = client->eventMonitor;
     return eventMonitor->updatePhoneCallState(state);
 }
 
 static jint MDS_updateInputState(JNIEnv* env, jobject obj, jboolean state)
 {
-    AutoMutex _l(gMutex);
-    if (gMds == NULL) return 0;
-    sp<IMultiDisplayEventMonitor> eventMonitor = gMds->getEventMonitor();
-    if (eventMonitor == NULL) return 0;
+    sp<MDSClient> client = getClient();
+    if (client == NULL || client->eventMonitor == NULL) return 0;
+    sp<IMultiDisplayEventMonitor> eventMonitor = client->eventMonitor;
     return eventMonitor->updateInputState(state);
 }
 
+static jint MDS_notifyInputActivity(JNIEnv* env, jobject obj)
+{
+    // Millisecond time stamps, the subtraction is safe on wrap around
+    int32_t now = (int32_t)ns2ms(systemTime());
+    if (now - android_atomic_acquire_load(&gLastInputActivity) <
+            INPUT_ACTIVITY_INTERVAL_MS)
+        return 0;
+    sp<MDSClient> client = getClient();
+    if (client == NULL || client->eventMonitor == NULL) return 0;
+    android_atomic_release_store(now, &gLastInputActivity);
+    return client->eventMonitor->notifyInputActivity();
+}
+
 static jint MDS_setVppState(JNIEnv* env, jobject obj, int dpyId, jboolean state)
 {
 #ifdef TARGET_HAS_VPP
-    AutoMutex _l(gMutex);
-    if (gMds == NULL) return 0;
-    sp<IMultiDisplayVppConfig> vppConfig = gMds->getVppConfig();
-    if (vppConfig == NULL) return 0;
+    sp<MDSClient> client = getClient();
+    if (client == NULL || client->vppConfig == NULL) return 0;
+    sp<IMultiDisplayVppConfig> vppConfig = client->vppConfig;
     return vppConfig->setVppState((MDS_DISPLAY_ID)dpyId, state);
 #else
     return 0;
@@ -315,11 +523,14 @@ static JNINativeMethod sMethods[] = {
     {"native_getMode", "()I", (void*)MDS_getMode},
     {"native_setHdmiTiming", "(IIIII)Z", (void*)MDS_setHdmiTiming},
     {"native_getHdmiTiming", "([I[I[I[I[I)I", (void*)MDS_getHdmiTiming},
+    {"native_getHdmiTimings", "([I)I", (void*)MDS_getHdmiTimings},
     {"native_getHdmiInfoCount", "()I", (void*)MDS_getHdmiInfoCount},
     {"native_setHdmiScaleType", "(I)Z", (void*)MDS_setHdmiScaleType},
     {"native_setHdmiOverscan", "(II)Z", (void*)MDS_setHdmiOverscan},
+    {"native_applyDisplayConfig", "(IIIIIIIII)Z", (void*)MDS_applyDisplayConfig},
     {"native_updatePhoneCallState", "(Z)I", (void*)MDS_updatePhoneCallState},
     {"native_updateInputState", "(Z)I", (void*)MDS_updateInputState},
+    {"native_notifyInputActivity", "()I", (void*)MDS_notifyInputActivity},
     {"native_setVppState", "(IZ)I", (void*)MDS_setVppState},
 };
 
@@ -22,6 +22,7 @@
 #include <binder/Parcel.h>
 
 #include <display/IMultiDisplayCallback.h>
+#include "MultiDisplayMarshal.h"
 
 namespace android {
 namespace intel {
@@ -34,6 +35,8 @@ enum {
     MDS_CB_SET_HDMI_SCALING_TYPE,
     MDS_CB_SET_HDMI_OVERSCAN,
     MDS_CB_SET_INPUT_STATE,
+    MDS_CB_SET_DISPLAY_CONFIG,
+    MDS_CB_GET_CAPABILITIES,
 };
 
 class BpMultiDisplayCallback : public BpInterface<IMultiDisplayCallback>
@@ -45,144 +48,92 @@ public:
     }
 
     virtual status_t blankSecondaryDisplay(bool blank) {
-        Parcel data, reply;
-        data.writeInterfaceToken(IMultiDisplayCallback::getInterfaceDescriptor());
-        data.writeInt32(blank ? 1 : 0);
-        status_t result = remote()->transact(
-                MDS_CB_BLANK_SECONDARY_DISPLAY, data, &reply);
-        if (result != NO_ERROR) {
-            return result;
-        }
-        result = reply.readInt32();
-        return result;
+        return mdsCall(remote(), getInterfaceDescriptor(),
+                MDS_CB_BLANK_SECONDARY_DISPLAY, blank);
     }
 
     virtual status_t updateVideoState(int videoSessionId, MDS_VIDEO_STATE state) {
-        Parcel data, reply;
-        data.writeInterfaceToken(IMultiDisplayCallback::getInterfaceDescriptor());
-        data.writeInt32(videoSessionId);
-        data.writeInt32(state);
-        status_t result = remote()->transact(
-                MDS_CB_UPDATE_VIDEO_PLAYBACK_STATE, data, &reply);
-        if (result != NO_ERROR) {
-            return result;
-        }
-        result = reply.readInt32();
-        return result;
+        return mdsCall(remote(), getInterfaceDescriptor(),
+                MDS_CB_UPDATE_VIDEO_PLAYBACK_STATE, videoSessionId, state);
     }
 
     virtual status_t setHdmiTiming(const MDSHdmiTiming& timing) {
-        Parcel data, reply;
-        data.writeInterfaceToken(IMultiDisplayCallback::getInterfaceDescriptor());
-
-        data.write(&timing, sizeof(MDSHdmiTiming));
-        status_t result = remote()->transact(
-                MDS_CB_SET_HDMI_TIMING, data, &reply);
-        if (result != NO_ERROR) {
-            return result;
-        }
-        result = reply.readInt32();
-        return result;
+        return mdsCall(remote(), getInterfaceDescriptor(),
+                MDS_CB_SET_HDMI_TIMING, timing);
     }
+
     virtual status_t setHdmiScalingType(MDS_SCALING_TYPE type) {
-        Parcel data, reply;
-        data.writeInterfaceToken(IMultiDisplayCallback::getInterfaceDescriptor());
-        data.writeInt32(type);
-        status_t result = remote()->transact(
-                MDS_CB_SET_HDMI_SCALING_TYPE, data, &reply);
-        if (result != NO_ERROR) {
-            return result;
-        }
-        result = reply.readInt32();
-        return result;
+        return mdsCall(remote(), getInterfaceDescriptor(),
+                MDS_CB_SET_HDMI_SCALING_TYPE, type);
     }
 
     virtual status_t setHdmiOverscan(int hValue, int vValue) {
-        Parcel data, reply;
-        data.writeInterfaceToken(IMultiDisplayCallback::getInterfaceDescriptor());
-        data.writeInt32(hValue);
-        data.writeInt32(vValue);
-        status_t result = remote()->transact(
-                MDS_CB_SET_HDMI_OVERSCAN, data, &reply);
-        if (result != NO_ERROR) {
-            return result;
-        }
-        result = reply.readInt32();
-        return result;
+        return mdsCall(remote(), getInterfaceDescriptor(),
+                MDS_CB_SET_HDMI_OVERSCAN, hValue, vValue);
     }
 
     virtual status_t updateInputState(bool state) {
-        Parcel data, reply;
-        data.writeInterfaceToken(IMultiDisplayCallback::getInterfaceDescriptor());
-        data.writeInt32(state ? 1 : 0);
-        status_t result = remote()->transact(
-                MDS_CB_SET_INPUT_STATE, data, &reply);
-        if (result != NO_ERROR) {
-            return result;
-        }
-        result = reply.readInt32();
-        return result;
+        return mdsCall(remote(), getInterfaceDescriptor(),
+                MDS_CB_SET_INPUT_STATE, state);
+    }
+
+    virtual status_t setDisplayConfig(const MDSDisplayConfig& config) {
+        return mdsCall(remote(), getInterfaceDescriptor(),
+                MDS_CB_SET_DISPLAY_CONFIG, config);
     }
 
+    virtual uint32_t getCapabilities() {
+        // An old callback doesn't know this transaction
+        return mdsCallValue(remote(), getInterfaceDescriptor(),
+                MDS_CB_GET_CAPABILITIES, (uint32_t)MDS_CB_CAP_LEGACY);
+    }
 };
 
 IMPLEMENT_META_INTERFACE(MultiDisplayCallback, "com.intel.MultiDisplayCallback");
 
+status_t IMultiDisplayCallback::setDisplayConfig(const MDSDisplayConfig& config) {
+    return INVALID_OPERATION;
+}
+
+uint32_t IMultiDisplayCallback::getCapabilities() {
+    return MDS_CB_CAP_LEGACY;
+}
+
 status_t BnMultiDisplayCallback::onTransact(
     uint32_t code, const Parcel& data, Parcel* reply, uint32_t flags)
 {
     switch (code) {
         case MDS_CB_BLANK_SECONDARY_DISPLAY: {
             CHECK_INTERFACE(IMultiDisplayCallback, data, reply);
-            int32_t blank = data.readInt32();
-            ALOGV("%s: Set phone state %d", __func__, blank);
-            int32_t ret = blankSecondaryDisplay(blank ? true : false);
-            reply->writeInt32(ret);
-            return NO_ERROR;
+            return mdsDispatch(this, &IMultiDisplayCallback::blankSecondaryDisplay, data, reply);
         } break;
         case MDS_CB_UPDATE_VIDEO_PLAYBACK_STATE: {
             CHECK_INTERFACE(IMultiDisplayCallback, data, reply);
-            int32_t vsessionId = data.readInt32();
-            int32_t state = data.readInt32();
-            ALOGV("%s: Set video playback[%d] state %d", __func__,  vsessionId, state);
-            int32_t ret = updateVideoState(vsessionId, (MDS_VIDEO_STATE)state);
-            reply->writeInt32(ret);
-            return NO_ERROR;
+            return mdsDispatch(this, &IMultiDisplayCallback::updateVideoState, data, reply);
         } break;
         case MDS_CB_SET_HDMI_TIMING: {
             CHECK_INTERFACE(IMultiDisplayCallback, data, reply);
-            MDSHdmiTiming timing;
-            data.read(&timing, sizeof(MDSHdmiTiming));
-            ALOGV("%s: set HDMI timing, %dx%d@%dx%dx%d", __func__,
-                    timing.width, timing.height, timing.refresh, timing.ratio);
-            int32_t ret = setHdmiTiming(timing);
-            reply->writeInt32(ret);
-            return NO_ERROR;
+            return mdsDispatch(this, &IMultiDisplayCallback::setHdmiTiming, data, reply);
         } break;
         case MDS_CB_SET_HDMI_SCALING_TYPE: {
             CHECK_INTERFACE(IMultiDisplayCallback, data, reply);
-            int32_t type = data.readInt32();
-            ALOGV("%s: set HDMI scaling type to:%d", __func__, type);
-            int32_t ret = setHdmiScalingType((MDS_SCALING_TYPE)type);
-            reply->writeInt32(ret);
-            return NO_ERROR;
+            return mdsDispatch(this, &IMultiDisplayCallback::setHdmiScalingType, data, reply);
         } break;
         case MDS_CB_SET_HDMI_OVERSCAN: {
             CHECK_INTERFACE(IMultiDisplayCallback, data, reply);
-            int32_t hValue = data.readInt32();
-            int32_t vValue = data.readInt32();
-            ALOGV("%s: set HDMI overscan h:%d v:%d", __func__,  hValue, vValue);
-            int32_t ret = setHdmiOverscan(hValue, vValue);
-            reply->writeInt32(ret);
-            return NO_ERROR;
+            return mdsDispatch(this, &IMultiDisplayCallback::setHdmiOverscan, data, reply);
         } break;
         case MDS_CB_SET_INPUT_STATE: {
             CHECK_INTERFACE(IMultiDisplayCallback, data, reply);
-            bool state = (data.readInt32() == 1 ? true : false);
-            ALOGV("%s: Set input state %d", __func__, state);
-            int32_t ret = updateInputState(state);
-            reply->writeInt32(ret);
-            return NO_ERROR;
+            return mdsDispatch(this, &IMultiDisplayCallback::updateInputState, data, reply);
+        } break;
+        case MDS_CB_SET_DISPLAY_CONFIG: {
+            CHECK_INTERFACE(IMultiDisplayCallback, data, reply);
+            return mdsDispatch(this, &IMultiDisplayCallback::setDisplayConfig, data, reply);
+        } break;
+        case MDS_CB_GET_CAPABILITIES: {
+            CHECK_INTERFACE(IMultiDisplayCallback, data, reply);
+            return mdsDispatch(this, &IMultiDisplayCallback::getCapabilities, data, reply);
         } break;
     }
     return BBinder::onTransact(code, data, reply, flags);
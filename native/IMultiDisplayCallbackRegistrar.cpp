@@ -23,6 +23,7 @@
 #include <binder/Parcel.h>
 
 #include <display/IMultiDisplayCallbackRegistrar.h>
+#include "MultiDisplayMarshal.h"
 
 namespace android {
 namespace intel {
@@ -41,29 +42,13 @@ public:
     }
 
     virtual status_t registerCallback(const sp<IMultiDisplayCallback>& cbk) {
-        Parcel data, reply;
-        data.writeInterfaceToken(IMultiDisplayCallbackRegistrar::getInterfaceDescriptor());
-        data.writeStrongBinder(cbk->asBinder());
-        status_t result = remote()->transact(
-                MDS_SERVER_REGISTER_CALLBACK, data, &reply);
-        if (result != NO_ERROR) {
-            return result;
-        }
-        result = reply.readInt32();
-        return result;
+        return mdsCall(remote(), getInterfaceDescriptor(),
+                MDS_SERVER_REGISTER_CALLBACK, cbk);
     }
 
     virtual status_t unregisterCallback(const sp<IMultiDisplayCallback>& cbk) {
-        Parcel data, reply;
-        data.writeInterfaceToken(IMultiDisplayCallbackRegistrar::getInterfaceDescriptor());
-        data.writeStrongBinder(cbk->asBinder());
-        status_t result = remote()->transact(
-                MDS_SERVER_UNREGISTER_CALLBACK, data, &reply);
-        if (result != NO_ERROR) {
-            return result;
-        }
-        result = reply.readInt32();
-        return result;
+        return mdsCall(remote(), getInterfaceDescriptor(),
+                MDS_SERVER_UNREGISTER_CALLBACK, cbk);
     }
 };
 
@@ -75,23 +60,14 @@ status_t BnMultiDisplayCallbackRegistrar::onTransact(
     switch (code) {
         case MDS_SERVER_REGISTER_CALLBACK: {
             CHECK_INTERFACE(IMultiDisplayCallbackRegistrar, data, reply);
-            sp<IBinder> cbk = data.readStrongBinder();
-            status_t ret = registerCallback(
-                    interface_cast<IMultiDisplayCallback>(cbk));
-            reply->writeInt32(ret);
-            return NO_ERROR;
+            return mdsDispatch(this, &IMultiDisplayCallbackRegistrar::registerCallback, data, reply);
         } break;
         case MDS_SERVER_UNREGISTER_CALLBACK: {
             CHECK_INTERFACE(IMultiDisplayCallbackRegistrar, data, reply);
-            sp<IBinder> cbk = data.readStrongBinder();
-            status_t ret = unregisterCallback(
-                    interface_cast<IMultiDisplayCallback>(cbk));
-            reply->writeInt32(ret);
-            return NO_ERROR;
+            return mdsDispatch(this, &IMultiDisplayCallbackRegistrar::unregisterCallback, data, reply);
         } break;
-        default:
-            return BBinder::onTransact(code, data, reply, flags);
     } // switch
+    return BBinder::onTransact(code, data, reply, flags);
 }
 
 }; // namespace intel
@@ -23,6 +23,7 @@
 #include <binder/Parcel.h>
 
 #include <display/IMultiDisplayConnectionObserver.h>
+#include "MultiDisplayMarshal.h"
 
 namespace android {
 namespace intel {
@@ -41,20 +42,12 @@ public:
     }
 
     virtual status_t updateHdmiConnectionStatus(bool connected) {
-        Parcel data, reply;
-        data.writeInterfaceToken(IMultiDisplayConnectionObserver::getInterfaceDescriptor());
-        data.writeInt32((connected ? 1 : 0));
-        status_t result = remote()->transact(
-                MDS_SERVER_UPDATE_HDMI_CONNECTION_STATUS, data, &reply);
-        return result;
+        return mdsCall(remote(), getInterfaceDescriptor(),
+                MDS_SERVER_UPDATE_HDMI_CONNECTION_STATUS, connected);
     }
     virtual status_t updateWidiConnectionStatus(bool connected) {
-        Parcel data, reply;
-        data.writeInterfaceToken(IMultiDisplayConnectionObserver::getInterfaceDescriptor());
-        data.writeInt32((connected ? 1 : 0));
-        status_t result = remote()->transact(
-                MDS_SERVER_UPDATE_WIDI_CONNECTION_STATUS, data, &reply);
-        return result;
+        return mdsCall(remote(), getInterfaceDescriptor(),
+                MDS_SERVER_UPDATE_WIDI_CONNECTION_STATUS, connected);
     }
 };
 
@@ -66,17 +59,11 @@ status_t BnMultiDisplayConnectionObserver::onTransact(
     switch (code) {
         case MDS_SERVER_UPDATE_HDMI_CONNECTION_STATUS: {
             CHECK_INTERFACE(IMultiDisplayConnectionObserver, data, reply);
-            bool state = (data.readInt32() == 1 ? true : false);
-            status_t ret = updateHdmiConnectionStatus(state);
-            reply->writeInt32(ret);
-            return NO_ERROR;
+            return mdsDispatch(this, &IMultiDisplayConnectionObserver::updateHdmiConnectionStatus, data, reply);
         } break;
         case MDS_SERVER_UPDATE_WIDI_CONNECTION_STATUS: {
             CHECK_INTERFACE(IMultiDisplayConnectionObserver, data, reply);
-            bool state = (data.readInt32() == 1 ? true : false);
-            status_t ret = updateWidiConnectionStatus(state);
-            reply->writeInt32(ret);
-            return NO_ERROR;
+            return mdsDispatch(this, &IMultiDisplayConnectionObserver::updateWidiConnectionStatus, data, reply);
         } break;
     } // switch
     return BBinder::onTransact(code, data, reply, flags);
@@ -23,6 +23,7 @@
 #include <binder/Parcel.h>
 
 #include <display/IMultiDisplayDecoderConfig.h>
+#include "MultiDisplayMarshal.h"
 
 namespace android {
 namespace intel {
@@ -41,21 +42,12 @@ public:
 
     virtual status_t setDecoderOutputResolution(
             int videoSessionId, int32_t width, int32_t height) {
-        Parcel data, reply;
-        data.writeInterfaceToken(IMultiDisplayDecoderConfig::getInterfaceDescriptor());
         if (width <= 0 || height <= 0) {
             return BAD_VALUE;
         }
-        data.writeInt32(videoSessionId);
-        data.writeInt32(width);
-        data.writeInt32(height);
-        status_t result = remote()->transact(
-                MDS_SERVER_SET_DECODER_OUTPUT_RESOLUTION, data, &reply);
-        if (result != NO_ERROR) {
-            return result;
-        }
-        result = reply.readInt32();
-        return result;
+        return mdsCall(remote(), getInterfaceDescriptor(),
+                MDS_SERVER_SET_DECODER_OUTPUT_RESOLUTION,
+                videoSessionId, width, height);
     }
 };
 
@@ -67,12 +59,7 @@ status_t BnMultiDisplayDecoderConfig::onTransact(
     switch (code) {
         case MDS_SERVER_SET_DECODER_OUTPUT_RESOLUTION: {
             CHECK_INTERFACE(IMultiDisplayDecoderConfig, data, reply);
-            int sessionId  = data.readInt32();
-            int32_t width  = data.readInt32();
-            int32_t height = data.readInt32();
-            status_t ret = setDecoderOutputResolution(sessionId, width, height);
-            reply->writeInt32(ret);
-            return NO_ERROR;
+            return mdsDispatch(this, &IMultiDisplayDecoderConfig::setDecoderOutputResolution, data, reply);
         } break;
     } // switch
     return BBinder::onTransact(code, data, reply, flags);
@@ -24,6 +24,7 @@
 
 
 #include <display/IMultiDisplayEventMonitor.h>
+#include "MultiDisplayMarshal.h"
 
 namespace android {
 namespace intel {
@@ -32,6 +33,7 @@ namespace intel {
 enum {
     MDS_SERVER_SET_PHONE_CALL_STATE = IBinder::FIRST_CALL_TRANSACTION,
     MDS_SERVER_SET_INPUT_STATE,
+    MDS_SERVER_NOTIFY_INPUT_ACTIVITY,
 };
 
 class BpMultiDisplayEventMonitor:public BpInterface<IMultiDisplayEventMonitor> {
@@ -42,29 +44,18 @@ public:
     }
 
     virtual status_t updatePhoneCallState(bool state) {
-        Parcel data, reply;
-        data.writeInterfaceToken(IMultiDisplayEventMonitor::getInterfaceDescriptor());
-        data.writeInt32(state ? 1 : 0);
-        status_t result = remote()->transact(
-                MDS_SERVER_SET_PHONE_CALL_STATE, data, &reply);
-        if (result != NO_ERROR) {
-            return result;
-        }
-        result = reply.readInt32();
-        return result;
+        return mdsCall(remote(), getInterfaceDescriptor(),
+                MDS_SERVER_SET_PHONE_CALL_STATE, state);
     }
 
     virtual status_t updateInputState(bool state) {
-        Parcel data, reply;
-        data.writeInterfaceToken(IMultiDisplayEventMonitor::getInterfaceDescriptor());
-        data.writeInt32(state ? 1 : 0);
-        status_t result = remote()->transact(
-                MDS_SERVER_SET_INPUT_STATE, data, &reply);
-        if (result != NO_ERROR) {
-            return result;
-        }
-        result = reply.readInt32();
-        return result;
+        return mdsCall(remote(), getInterfaceDescriptor(),
+                MDS_SERVER_SET_INPUT_STATE, state);
+    }
+
+    virtual status_t notifyInputActivity() {
+        return mdsCallOneway(remote(), getInterfaceDescriptor(),
+                MDS_SERVER_NOTIFY_INPUT_ACTIVITY);
     }
 };
 
@@ -76,17 +67,15 @@ status_t BnMultiDisplayEventMonitor::onTransact(
     switch (code) {
         case MDS_SERVER_SET_PHONE_CALL_STATE: {
             CHECK_INTERFACE(IMultiDisplayEventMonitor, data, reply);
-            bool state = (data.readInt32() == 1 ? true : false);
-            status_t ret = updatePhoneCallState(state);
-            reply->writeInt32(ret);
-            return NO_ERROR;
+            return mdsDispatch(this, &IMultiDisplayEventMonitor::updatePhoneCallState, data, reply);
         } break;
         case MDS_SERVER_SET_INPUT_STATE: {
             CHECK_INTERFACE(IMultiDisplayEventMonitor, data, reply);
-            bool state = (data.readInt32() == 1 ? true : false);
-            status_t ret = updateInputState(state);
-            reply->writeInt32(ret);
-            return NO_ERROR;
+            return mdsDispatch(this, &IMultiDisplayEventMonitor::updateInputState, data, reply);
+        } break;
+        case MDS_SERVER_NOTIFY_INPUT_ACTIVITY: {
+            CHECK_INTERFACE(IMultiDisplayEventMonitor, data, reply);
+            return mdsDispatch(this, &IMultiDisplayEventMonitor::notifyInputActivity, data, reply);
         } break;
     } // switch
     return BBinder::onTransact(code, data, reply, flags);
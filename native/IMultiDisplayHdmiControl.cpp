@@ -23,6 +23,7 @@
 #include <binder/Parcel.h>
 
 #include <display/IMultiDisplayHdmiControl.h>
+#include "MultiDisplayMarshal.h"
 #include "drm_hdmi.h"
 
 namespace android {
@@ -37,6 +38,8 @@ enum {
     MDS_SERVER_GET_CURRENT_HDMI_TIMING_INDEX,
     MDS_SERVER_SET_HDMI_SCALING_TYPE,
     MDS_SERVER_SET_HDMI_OVER_SCAN,
+    MDS_SERVER_APPLY_DISPLAY_CONFIG,
+    MDS_SERVER_GET_HDMI_TIMINGS,
 };
 
 class BpMultiDisplayHdmiControl : public BpInterface<IMultiDisplayHdmiControl> {
@@ -46,118 +49,98 @@ public:
     {
     }
     virtual status_t setHdmiTiming(const MDSHdmiTiming& timing) {
-        Parcel data, reply;
-        data.writeInterfaceToken(IMultiDisplayHdmiControl::getInterfaceDescriptor());
-        data.write(&timing, sizeof(MDSHdmiTiming));
-        status_t result = remote()->transact(
-                MDS_SERVER_SET_HDMI_TIMING, data, &reply);
-        if (result != NO_ERROR) {
-            return result;
-        }
-        result = reply.readInt32();
-        return result;
+        return mdsCall(remote(), getInterfaceDescriptor(),
+                MDS_SERVER_SET_HDMI_TIMING, timing);
     }
 
     virtual int getHdmiTimingCount() {
-        Parcel data, reply;
-        data.writeInterfaceToken(IMultiDisplayHdmiControl::getInterfaceDescriptor());
-        status_t result = remote()->transact(
-                MDS_SERVER_GET_HDMI_TIMING_COUNT, data, &reply);
-        if (result != NO_ERROR) {
-            return result;
-        }
-        int count = reply.readInt32();
-        return count;
+        return mdsCall(remote(), getInterfaceDescriptor(),
+                MDS_SERVER_GET_HDMI_TIMING_COUNT);
     }
 
     virtual status_t getHdmiTimingList(int timingCount, MDSHdmiTiming** list) {
-        Parcel data, reply;
-        data.writeInterfaceToken(IMultiDisplayHdmiControl::getInterfaceDescriptor());
         if (list == NULL || timingCount <= 0 || timingCount > HDMI_TIMING_MAX) {
             return BAD_VALUE;
         }
-        data.writeInt32(timingCount);
-        status_t result = remote()->transact(
-                MDS_SERVER_GET_HDMI_TIMING_LIST, data, &reply);
+        for (int i = 0; i < timingCount; i++) {
+            if (list[i] == NULL)
+                return BAD_VALUE;
+        }
+        Parcel reply;
+        status_t result = mdsTransact(remote(), getInterfaceDescriptor(),
+                MDS_SERVER_GET_HDMI_TIMING_LIST, &reply, 0, timingCount);
         if (result != NO_ERROR) {
             return result;
         }
         for (int i = 0; i < timingCount; i++) {
-            if (list[i] == NULL)
-                return BAD_VALUE;
-
-            reply.read((void*)list[i], sizeof(MDSHdmiTiming));
+            if (mdsRead(reply, list[i]) != NO_ERROR)
+                return NOT_ENOUGH_DATA;
+        }
+        if (mdsRead(reply, &result) != NO_ERROR) {
+            return NOT_ENOUGH_DATA;
         }
-        result = reply.readInt32();
         return result;
     }
 
     virtual status_t getCurrentHdmiTiming(MDSHdmiTiming* timing) {
-        Parcel data, reply;
-        data.writeInterfaceToken(IMultiDisplayHdmiControl::getInterfaceDescriptor());
         if (timing == NULL) {
             return BAD_VALUE;
         }
-        status_t result = remote()->transact(
-                MDS_SERVER_GET_CURRENT_HDMI_TIMING, data, &reply);
+        Parcel reply;
+        status_t result = mdsTransact(remote(), getInterfaceDescriptor(),
+                MDS_SERVER_GET_CURRENT_HDMI_TIMING, &reply, 0);
         if (result != NO_ERROR) {
             return result;
         }
-        reply.read((void *)timing, sizeof(MDSHdmiTiming));
-        result = reply.readInt32();
+        if (mdsRead(reply, timing, &result) != NO_ERROR) {
+            return NOT_ENOUGH_DATA;
+        }
         return result;
     }
 
     virtual status_t setHdmiTimingByIndex(int index) {
-        Parcel data, reply;
-        data.writeInterfaceToken(IMultiDisplayHdmiControl::getInterfaceDescriptor());
-        data.writeInt32(index);
-        status_t result = remote()->transact(
-                MDS_SERVER_SET_HDMI_TIMING_BY_INDEX, data, &reply);
-        if (result != NO_ERROR) {
-            return result;
-        }
-        result = reply.readInt32();
-        return result;
+        return mdsCall(remote(), getInterfaceDescriptor(),
+                MDS_SERVER_SET_HDMI_TIMING_BY_INDEX, index);
     }
 
     virtual int getCurrentHdmiTimingIndex() {
-        Parcel data, reply;
-        data.writeInterfaceToken(IMultiDisplayHdmiControl::getInterfaceDescriptor());
-        status_t result = remote()->transact(
-                MDS_SERVER_GET_CURRENT_HDMI_TIMING_INDEX, data, &reply);
-        if (result != NO_ERROR) {
-            return result;
-        }
-        int32_t index = reply.readInt32();
-        return index;
+        return mdsCall(remote(), getInterfaceDescriptor(),
+                MDS_SERVER_GET_CURRENT_HDMI_TIMING_INDEX);
     }
 
     virtual status_t setHdmiScalingType(MDS_SCALING_TYPE type) {
-        Parcel data, reply;
-        data.writeInterfaceToken(IMultiDisplayHdmiControl::getInterfaceDescriptor());
-        data.writeInt32(type);
-        status_t result = remote()->transact(
-                MDS_SERVER_SET_HDMI_SCALING_TYPE, data, &reply);
-        if (result != NO_ERROR) {
-            return result;
-        }
-        result = reply.readInt32();
-        return result;
+        return mdsCall(remote(), getInterfaceDescriptor(),
+                MDS_SERVER_SET_HDMI_SCALING_TYPE, type);
     }
 
     virtual status_t setHdmiOverscan(int hValue, int vValue) {
-        Parcel data, reply;
-        data.writeInterfaceToken(IMultiDisplayHdmiControl::getInterfaceDescriptor());
-        data.writeInt32(hValue);
-        data.writeInt32(vValue);
-        status_t result = remote()->transact(
-                MDS_SERVER_SET_HDMI_OVER_SCAN, data, &reply);
-        if (result != NO_ERROR) {
-            return result;
+        return mdsCall(remote(), getInterfaceDescriptor(),
+                MDS_SERVER_SET_HDMI_OVER_SCAN, hValue, vValue);
+    }
+
+    virtual status_t applyDisplayConfig(const MDSDisplayConfig& config) {
+        return mdsCall(remote(), getInterfaceDescriptor(),
+                MDS_SERVER_APPLY_DISPLAY_CONFIG, config);
+    }
+
+    virtual int getHdmiTimings(MDSHdmiTiming* list, int max) {
+        if (list == NULL || max <= 0) {
+            return 0;
         }
-        result = reply.readInt32();
-        return result;
+        Parcel reply;
+        if (mdsTransact(remote(), getInterfaceDescriptor(),
+                MDS_SERVER_GET_HDMI_TIMINGS, &reply, 0, max) != NO_ERROR) {
+            return 0;
+        }
+        int32_t count = 0;
+        if (mdsRead(reply, &count) != NO_ERROR || count < 0 || count > max) {
+            return 0;
+        }
+        for (int i = 0; i < count; i++) {
+            if (mdsRead(reply, list + i) != NO_ERROR)
+                return 0;
+        }
+        return count;
     }
 };
 
@@ -169,80 +152,80 @@ status_t BnMultiDisplayHdmiControl::onTransact(
     switch (code) {
         case MDS_SERVER_SET_HDMI_TIMING: {
             CHECK_INTERFACE(IMultiDisplayHdmiControl, data, reply);
-            MDSHdmiTiming timing;
-            data.read(&timing, sizeof(MDSHdmiTiming));
-            status_t ret = setHdmiTiming(timing);
-            reply->writeInt32(ret);
-            return NO_ERROR;
+            return mdsDispatch(this, &IMultiDisplayHdmiControl::setHdmiTiming, data, reply);
         } break;
         case MDS_SERVER_GET_HDMI_TIMING_COUNT: {
             CHECK_INTERFACE(IMultiDisplayHdmiControl, data, reply);
-            int32_t ret = getHdmiTimingCount();
-            reply->writeInt32(ret);
-            return NO_ERROR;
+            return mdsDispatch(this, &IMultiDisplayHdmiControl::getHdmiTimingCount, data, reply);
         } break;
         case MDS_SERVER_GET_HDMI_TIMING_LIST: {
             CHECK_INTERFACE(IMultiDisplayHdmiControl, data, reply);
-            const int count = data.readInt32();
-            MDSHdmiTiming *list[count];
-            memset(list, 0, count * sizeof(MDSHdmiTiming *));
-            for (int i = 0; i < count; i++) {
-                list[i] = (MDSHdmiTiming *)malloc(sizeof(MDSHdmiTiming));
-                if (list[i] == NULL) {
-                    for (int j = 0; j < i; j++)
-                        if (list[j]) free(list[j]);
-                    return NO_ERROR;
-                }
-                memset(list[i], 0, sizeof(MDSHdmiTiming));
-            }
-
-            int ret = getHdmiTimingList(count, (MDSHdmiTiming **)list);
-
+            int32_t count = 0;
+            status_t err = mdsRead(data, &count);
+            if (err != NO_ERROR)
+                return err;
+            if (count <= 0 || count > HDMI_TIMING_MAX)
+                return BAD_VALUE;
+            MDSHdmiTiming timings[HDMI_TIMING_MAX];
+            MDSHdmiTiming* list[HDMI_TIMING_MAX];
+            memset(timings, 0, sizeof(timings));
+            for (int i = 0; i < count; i++)
+                list[i] = &timings[i];
+            status_t ret = getHdmiTimingList(count, list);
             for (int i = 0; i < count; i++) {
-                reply->write((const void*)list[i], sizeof(MDSHdmiTiming));
-                free(list[i]);
-                list[i] = NULL;
+                err = mdsWrite(*reply, timings[i]);
+                if (err != NO_ERROR)
+                    return err;
             }
-            reply->writeInt32(ret);
-            return NO_ERROR;
+            return mdsWrite(*reply, ret);
+        } break;
+        case MDS_SERVER_GET_HDMI_TIMINGS: {
+            CHECK_INTERFACE(IMultiDisplayHdmiControl, data, reply);
+            int32_t max = 0;
+            status_t err = mdsRead(data, &max);
+            if (err != NO_ERROR)
+                return err;
+            if (max > MDS_HDMI_TIMING_MAX)
+                max = MDS_HDMI_TIMING_MAX;
+            MDSHdmiTiming list[MDS_HDMI_TIMING_MAX];
+            int32_t count = 0;
+            if (max > 0)
+                count = getHdmiTimings(list, max);
+            if (count < 0 || count > max)
+                count = 0;
+            err = mdsWrite(*reply, count);
+            for (int i = 0; i < count && err == NO_ERROR; i++)
+                err = mdsWrite(*reply, list[i]);
+            return err;
         } break;
         case MDS_SERVER_GET_CURRENT_HDMI_TIMING: {
             CHECK_INTERFACE(IMultiDisplayHdmiControl, data, reply);
             MDSHdmiTiming timing;
+            memset(&timing, 0, sizeof(MDSHdmiTiming));
             status_t ret = getCurrentHdmiTiming(&timing);
-            reply->write((const void *)&timing, sizeof(MDSHdmiTiming));
-            reply->writeInt32(ret);
-            return NO_ERROR;
+            return mdsWrite(*reply, timing, ret);
         } break;
         case MDS_SERVER_SET_HDMI_TIMING_BY_INDEX: {
             CHECK_INTERFACE(IMultiDisplayHdmiControl, data, reply);
-            int32_t index = data.readInt32();
-            status_t ret = setHdmiTimingByIndex(index);
-            reply->writeInt32(ret);
-            return NO_ERROR;
+            return mdsDispatch(this, &IMultiDisplayHdmiControl::setHdmiTimingByIndex, data, reply);
         } break;
         case MDS_SERVER_GET_CURRENT_HDMI_TIMING_INDEX: {
             CHECK_INTERFACE(IMultiDisplayHdmiControl, data, reply);
-            int32_t index = getCurrentHdmiTimingIndex();
-            reply->writeInt32(index);
-            return NO_ERROR;
+            return mdsDispatch(this, &IMultiDisplayHdmiControl::getCurrentHdmiTimingIndex, data, reply);
         } break;
         case MDS_SERVER_SET_HDMI_SCALING_TYPE: {
             CHECK_INTERFACE(IMultiDisplayHdmiControl, data, reply);
-            MDS_SCALING_TYPE type = (MDS_SCALING_TYPE)data.readInt32();
-            status_t ret = setHdmiScalingType(type);
-            reply->writeInt32(ret);
-            return NO_ERROR;
+            return mdsDispatch(this, &IMultiDisplayHdmiControl::setHdmiScalingType, data, reply);
         } break;
         case MDS_SERVER_SET_HDMI_OVER_SCAN: {
             CHECK_INTERFACE(IMultiDisplayHdmiControl, data, reply);
-            int32_t hValue = data.readInt32();
-            int32_t vValue = data.readInt32();
-            status_t ret = setHdmiOverscan(hValue, vValue);
-            reply->writeInt32(ret);
-            return NO_ERROR;
+            return mdsDispatch(this, &IMultiDisplayHdmiControl::setHdmiOverscan, data, reply);
         } break;
-    }
+        case MDS_SERVER_APPLY_DISPLAY_CONFIG: {
+            CHECK_INTERFACE(IMultiDisplayHdmiControl, data, reply);
+            return mdsDispatch(this, &IMultiDisplayHdmiControl::applyDisplayConfig, data, reply);
+        } break;
+    } // switch
     return BBinder::onTransact(code, data, reply, flags);
 }
 
@@ -23,10 +23,12 @@
 #include <binder/Parcel.h>
 
 #include <display/IMultiDisplayInfoProvider.h>
+#include "MultiDisplayMarshal.h"
 
 namespace android {
 namespace intel {
 
+MDS_WIRE_ENUM(MDS_DISPLAY_MODE);
 
 enum {
     MDS_SERVER_GET_VIDEO_STATE = IBinder::FIRST_CALL_TRANSACTION,
@@ -35,6 +37,9 @@ enum {
     MDS_SERVER_GET_DISPLAY_MODE,
     MDS_SERVER_GET_DECODER_OUTPUT_RESOLUTION,
     MDS_SERVER_GET_VPP_STATE,
+    MDS_SERVER_IS_READY,
+    MDS_SERVER_GET_EXTERNAL_DISPLAY_COUNT,
+    MDS_SERVER_GET_DISPLAY_STATE,
 };
 
 class BpMultiDisplayInfoProvider:public BpInterface<IMultiDisplayInfoProvider> {
@@ -45,86 +50,81 @@ public:
     }
 
     virtual int getVideoSessionNumber() {
-        Parcel data, reply;
-        data.writeInterfaceToken(IMultiDisplayInfoProvider::getInterfaceDescriptor());
-        status_t result = remote()->transact(
-                MDS_SERVER_GET_VIDEO_SESSION_NUM, data, &reply);
-        if (result != NO_ERROR) {
-            return 0;
-        }
-        return reply.readInt32();
+        return mdsCallValue(remote(), getInterfaceDescriptor(),
+                MDS_SERVER_GET_VIDEO_SESSION_NUM, 0);
     }
 
     virtual MDS_VIDEO_STATE getVideoState(int sessionId) {
-        Parcel data, reply;
-        data.writeInterfaceToken(IMultiDisplayInfoProvider::getInterfaceDescriptor());
-        data.writeInt32(sessionId);
-        status_t result = remote()->transact(
-                MDS_SERVER_GET_VIDEO_STATE, data, &reply);
-        if (result != NO_ERROR) {
-            return MDS_VIDEO_STATE_UNKNOWN;
-        }
-        MDS_VIDEO_STATE state = (MDS_VIDEO_STATE)reply.readInt32();
-        return state;
+        return mdsCallValue(remote(), getInterfaceDescriptor(),
+                MDS_SERVER_GET_VIDEO_STATE, MDS_VIDEO_STATE_UNKNOWN, sessionId);
     }
 
     virtual status_t getVideoSourceInfo(int sessionId, MDSVideoSourceInfo* info) {
-        Parcel data, reply;
-        data.writeInterfaceToken(IMultiDisplayInfoProvider::getInterfaceDescriptor());
         if (info == NULL) {
             return BAD_VALUE;
         }
-        data.writeInt32(sessionId);
-        status_t result = remote()->transact(
-                MDS_SERVER_GET_VIDEO_SOURCE_INFO, data, &reply);
+        Parcel reply;
+        status_t result = mdsTransact(remote(), getInterfaceDescriptor(),
+                MDS_SERVER_GET_VIDEO_SOURCE_INFO, &reply, 0, sessionId);
         if (result != NO_ERROR) {
             return result;
         }
-        reply.read((void *)info, sizeof(MDSVideoSourceInfo));
-        result = reply.readInt32();
+        if (mdsRead(reply, info, &result) != NO_ERROR) {
+            return NOT_ENOUGH_DATA;
+        }
         return result;
     }
 
     virtual MDS_DISPLAY_MODE getDisplayMode(bool wait) {
-        Parcel data, reply;
-        data.writeInterfaceToken(IMultiDisplayInfoProvider::getInterfaceDescriptor());
-        data.writeInt32(wait ? 1 : 0);
-        status_t result = remote()->transact(
-                MDS_SERVER_GET_DISPLAY_MODE, data, &reply);
-        if (result != NO_ERROR) {
-            return MDS_MODE_NONE;
-        }
-        MDS_DISPLAY_MODE mode = (MDS_DISPLAY_MODE)reply.readInt32();
-        return mode;
+        return mdsCallValue(remote(), getInterfaceDescriptor(),
+                MDS_SERVER_GET_DISPLAY_MODE, MDS_MODE_NONE, wait);
     }
 
     virtual status_t getDecoderOutputResolution(int sessionId, int32_t* width, int32_t* height) {
-        Parcel data, reply;
-        data.writeInterfaceToken(IMultiDisplayInfoProvider::getInterfaceDescriptor());
         if (width == NULL || height == NULL) {
             return BAD_VALUE;
         }
-        data.writeInt32(sessionId);
-        status_t result = remote()->transact(
-                MDS_SERVER_GET_DECODER_OUTPUT_RESOLUTION, data, &reply);
+        Parcel reply;
+        status_t result = mdsTransact(remote(), getInterfaceDescriptor(),
+                MDS_SERVER_GET_DECODER_OUTPUT_RESOLUTION, &reply, 0, sessionId);
         if (result != NO_ERROR) {
             return result;
         }
-        *width  = reply.readInt32();
-        *height = reply.readInt32();
-        result  = reply.readInt32();
+        if (mdsRead(reply, width, height, &result) != NO_ERROR) {
+            return NOT_ENOUGH_DATA;
+        }
         return result;
     }
 
     virtual bool getVppState() {
-        Parcel data, reply;
-        data.writeInterfaceToken(IMultiDisplayInfoProvider::getInterfaceDescriptor());
-        status_t result = remote()->transact(
-                MDS_SERVER_GET_VPP_STATE, data, &reply);
+        return mdsCallValue(remote(), getInterfaceDescriptor(),
+                MDS_SERVER_GET_VPP_STATE, false);
+    }
+
+    virtual bool isReady() {
+        return mdsCallValue(remote(), getInterfaceDescriptor(),
+                MDS_SERVER_IS_READY, false);
+    }
+
+    virtual int getExternalDisplayCount() {
+        return mdsCallValue(remote(), getInterfaceDescriptor(),
+                MDS_SERVER_GET_EXTERNAL_DISPLAY_COUNT, 0);
+    }
+
+    virtual status_t getDisplayState(MDS_DISPLAY_ID id, int connector, MDSDisplayState* state) {
+        if (state == NULL) {
+            return BAD_VALUE;
+        }
+        Parcel reply;
+        status_t result = mdsTransact(remote(), getInterfaceDescriptor(),
+                MDS_SERVER_GET_DISPLAY_STATE, &reply, 0, id, connector);
         if (result != NO_ERROR) {
-            return 0;
+            return result;
+        }
+        if (mdsRead(reply, state, &result) != NO_ERROR) {
+            return NOT_ENOUGH_DATA;
         }
-        return (reply.readInt32() == 1 ? true : false);
+        return result;
     }
 };
 
@@ -136,49 +136,61 @@ status_t BnMultiDisplayInfoProvider::onTransact(
     switch (code) {
         case MDS_SERVER_GET_VIDEO_STATE: {
             CHECK_INTERFACE(IMultiDisplayInfoProvider, data, reply);
-            int32_t sessionId = data.readInt32();
-            MDS_VIDEO_STATE ret = getVideoState(sessionId);
-            reply->writeInt32(ret);
-            return NO_ERROR;
+            return mdsDispatch(this, &IMultiDisplayInfoProvider::getVideoState, data, reply);
         } break;
         case MDS_SERVER_GET_VIDEO_SESSION_NUM: {
             CHECK_INTERFACE(IMultiDisplayInfoProvider, data, reply);
-            int ret = getVideoSessionNumber();
-            reply->writeInt32(ret);
-            return NO_ERROR;
+            return mdsDispatch(this, &IMultiDisplayInfoProvider::getVideoSessionNumber, data, reply);
+        } break;
+        case MDS_SERVER_GET_DISPLAY_MODE: {
+            CHECK_INTERFACE(IMultiDisplayInfoProvider, data, reply);
+            return mdsDispatch(this, &IMultiDisplayInfoProvider::getDisplayMode, data, reply);
         } break;
         case MDS_SERVER_GET_VIDEO_SOURCE_INFO: {
             CHECK_INTERFACE(IMultiDisplayInfoProvider, data, reply);
+            int32_t sessionId = -1;
+            status_t err = mdsRead(data, &sessionId);
+            if (err != NO_ERROR)
+                return err;
             MDSVideoSourceInfo info;
-            int32_t sessionId = data.readInt32();
+            memset(&info, 0, sizeof(MDSVideoSourceInfo));
             status_t ret = getVideoSourceInfo(sessionId, &info);
-            reply->write((const void *)&info, sizeof(MDSVideoSourceInfo));
-            reply->writeInt32(ret);
-            return NO_ERROR;
-        } break;
-        case MDS_SERVER_GET_DISPLAY_MODE: {
-            CHECK_INTERFACE(IMultiDisplayInfoProvider, data, reply);
-            bool wait = (data.readInt32() == 0 ? false : true);
-            MDS_DISPLAY_MODE ret = getDisplayMode(wait);
-            reply->writeInt32(ret);
-            return NO_ERROR;
+            return mdsWrite(*reply, info, ret);
         } break;
         case MDS_SERVER_GET_DECODER_OUTPUT_RESOLUTION: {
             CHECK_INTERFACE(IMultiDisplayInfoProvider, data, reply);
+            int32_t sessionId = -1;
+            status_t err = mdsRead(data, &sessionId);
+            if (err != NO_ERROR)
+                return err;
             int32_t width  = 0;
             int32_t height = 0;
-            int32_t sessionId = data.readInt32();
             status_t ret = getDecoderOutputResolution(sessionId, &width, &height);
-            reply->writeInt32(width);
-            reply->writeInt32(height);
-            reply->writeInt32(ret);
-            return NO_ERROR;
+            return mdsWrite(*reply, width, height, ret);
         } break;
         case MDS_SERVER_GET_VPP_STATE: {
             CHECK_INTERFACE(IMultiDisplayInfoProvider, data, reply);
-            bool ret = getVppState();
-            reply->writeInt32(ret ? 1 : 0);
-            return NO_ERROR;
+            return mdsDispatch(this, &IMultiDisplayInfoProvider::getVppState, data, reply);
+        } break;
+        case MDS_SERVER_IS_READY: {
+            CHECK_INTERFACE(IMultiDisplayInfoProvider, data, reply);
+            return mdsDispatch(this, &IMultiDisplayInfoProvider::isReady, data, reply);
+        } break;
+        case MDS_SERVER_GET_EXTERNAL_DISPLAY_COUNT: {
+            CHECK_INTERFACE(IMultiDisplayInfoProvider, data, reply);
+            return mdsDispatch(this, &IMultiDisplayInfoProvider::getExternalDisplayCount, data, reply);
+        } break;
+        case MDS_SERVER_GET_DISPLAY_STATE: {
+            CHECK_INTERFACE(IMultiDisplayInfoProvider, data, reply);
+            MDS_DISPLAY_ID id = MDS_DISPLAY_PRIMARY;
+            int32_t connector = 0;
+            status_t err = mdsRead(data, &id, &connector);
+            if (err != NO_ERROR)
+                return err;
+            MDSDisplayState state;
+            memset(&state, 0, sizeof(MDSDisplayState));
+            status_t ret = getDisplayState(id, connector, &state);
+            return mdsWrite(*reply, state, ret);
         } break;
     } // switch
     return BBinder::onTransact(code, data, reply, flags);
@@ -22,6 +22,7 @@
 #include <binder/Parcel.h>
 
 #include <display/IMultiDisplayListener.h>
+#include "MultiDisplayMarshal.h"
 
 
 namespace android {
@@ -41,22 +42,23 @@ public:
     }
 
     virtual status_t onMdsMessage(int msg, void* value, int size) {
-        Parcel data, reply;
-        data.writeInterfaceToken(IMultiDisplayListener::getInterfaceDescriptor());
         if (value == NULL || (uint32_t)size < sizeof(int))
             return BAD_VALUE;
 
-        data.writeInt32(msg);
-        data.writeInt32(size);
-        data.write(value, size);
-
         ALOGV("%s: mode %d, 0x%x", __func__, msg, *((int*)value));
 
-        status_t result = remote()->transact(ON_MDS_EVENT, data, &reply);
+        Parcel data, reply;
+        data.writeInterfaceToken(getInterfaceDescriptor());
+        status_t result = mdsWriteMessage(data, msg, value, size);
+        if (result != NO_ERROR)
+            return result;
+        result = remote()->transact(ON_MDS_EVENT, data, &reply);
         if (result != NO_ERROR) {
             return result;
         }
-        result = reply.readInt32();
+        if (mdsRead(reply, &result) != NO_ERROR) {
+            return NOT_ENOUGH_DATA;
+        }
         return result;
     }
 };
@@ -68,22 +70,17 @@ status_t BnMultiDisplayListener::onTransact(
 {
     switch (code) {
         case ON_MDS_EVENT: {
-            ALOGV("%s", __func__);
             CHECK_INTERFACE(IMultiDisplayListener, data, reply);
-            int32_t msg = data.readInt32();
-            int32_t size = data.readInt32();
-            void* value = (void *)malloc(size);
-            if (value == NULL)
-                return NO_MEMORY;
-            data.read(value, size);
+            int32_t msg = 0;
+            int32_t size = 0;
+            void* value = NULL;
+            MDSDisplayState state;
+            status_t err = mdsReadMessage(data, &msg, &value, &size, &state);
+            if (err != NO_ERROR)
+                return err;
             ALOGV("%s: mode %d, 0x%x", __func__, msg, *((int*)value));
             status_t ret = onMdsMessage(msg, value, size);
-            reply->writeInt32(ret);
-            if (value) {
-                free(value);
-                value = NULL;
-            }
-            return NO_ERROR;
+            return mdsWrite(*reply, ret);
        } break;
     }
     return BBinder::onTransact(code, data, reply, flags);
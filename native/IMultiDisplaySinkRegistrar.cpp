@@ -23,6 +23,7 @@
 #include <binder/Parcel.h>
 
 #include <display/IMultiDisplaySinkRegistrar.h>
+#include "MultiDisplayMarshal.h"
 
 namespace android {
 namespace intel {
@@ -42,39 +43,22 @@ public:
 
     virtual int32_t registerListener(const sp<IMultiDisplayListener>& listener,
             const char* name, int msg) {
-        Parcel data, reply;
         if (listener.get() == NULL || name == NULL) {
             return -1;
         }
-        data.writeInterfaceToken(IMultiDisplaySinkRegistrar::getInterfaceDescriptor());
-        data.writeStrongBinder(listener->asBinder());
-        data.writeCString(name);
-        data.writeInt32(msg);
-        status_t result = remote()->transact(
-                MDS_SERVER_REGISTER_LISTENER, data, &reply);
-        if (result != NO_ERROR) {
-            return -1;
-        }
-        int32_t id = reply.readInt32();
+        int32_t id = mdsCallValue(remote(), getInterfaceDescriptor(),
+                MDS_SERVER_REGISTER_LISTENER, (int32_t)-1, listener, name, msg);
         ALOGV("%s, %d, %p", __func__, id, listener.get());
         return id;
     }
 
     virtual status_t unregisterListener(int32_t listenerId) {
-        Parcel data, reply;
         if (listenerId < 0) {
             return BAD_VALUE;
         }
         ALOGV("%s, %d", __func__, listenerId);
-        data.writeInterfaceToken(IMultiDisplaySinkRegistrar::getInterfaceDescriptor());
-        data.writeInt32(listenerId);
-        status_t result = remote()->transact(
-                MDS_SERVER_UNREGISTER_LISTENER, data, &reply);
-        if (result != NO_ERROR) {
-            return result;
-        }
-        result = reply.readInt32();
-        return result;
+        return mdsCall(remote(), getInterfaceDescriptor(),
+                MDS_SERVER_UNREGISTER_LISTENER, listenerId);
     }
 };
 
@@ -86,26 +70,14 @@ status_t BnMultiDisplaySinkRegistrar::onTransact(
     switch (code) {
         case MDS_SERVER_REGISTER_LISTENER: {
             CHECK_INTERFACE(IMultiDisplaySinkRegistrar, data, reply);
-            sp<IMultiDisplayListener> listener =
-                interface_cast<IMultiDisplayListener>(data.readStrongBinder());
-            const char* client = data.readCString();
-            int msg = data.readInt32();
-            int32_t listenerId = registerListener(listener, client, msg);
-            ALOGV("%s, %d, %p", __func__, listenerId, listener.get());
-            reply->writeInt32(listenerId);
-            return NO_ERROR;
+            return mdsDispatch(this, &IMultiDisplaySinkRegistrar::registerListener, data, reply);
         } break;
         case MDS_SERVER_UNREGISTER_LISTENER: {
             CHECK_INTERFACE(IMultiDisplaySinkRegistrar, data, reply);
-            int32_t listenerId = data.readInt32();
-            ALOGV("%s, %d", __func__, listenerId);
-            status_t ret = unregisterListener(listenerId);
-            reply->writeInt32(ret);
-            return NO_ERROR;
+            return mdsDispatch(this, &IMultiDisplaySinkRegistrar::unregisterListener, data, reply);
         } break;
-        default:
-            return BBinder::onTransact(code, data, reply, flags);
     } // switch
+    return BBinder::onTransact(code, data, reply, flags);
 }
 
 }; // namespace intel
@@ -24,6 +24,7 @@
 
 
 #include <display/IMultiDisplayVideoControl.h>
+#include "MultiDisplayMarshal.h"
 
 namespace android {
 namespace intel {
@@ -34,6 +35,7 @@ enum {
     MDS_SERVER_RESET_VIDEO_PLAYBACK,
     MDS_SERVER_UPDATE_VIDEO_STATE,
     MDS_SERVER_UPDATE_VIDEO_SOURCE_INFO,
+    MDS_SERVER_ALLOCATE_VIDEO_SESSION,
 };
 
 class BpMultiDisplayVideoControl : public BpInterface<IMultiDisplayVideoControl> {
@@ -44,54 +46,28 @@ public:
     }
 
     virtual status_t resetVideoPlayback() {
-        Parcel data, reply;
-        data.writeInterfaceToken(IMultiDisplayVideoControl::getInterfaceDescriptor());
-        status_t result = remote()->transact(
-                MDS_SERVER_RESET_VIDEO_PLAYBACK, data, &reply);
-        if (result != NO_ERROR) {
-            return result;
-        }
-        result = reply.readInt32();
-        return result;
+        return mdsCall(remote(), getInterfaceDescriptor(),
+                MDS_SERVER_RESET_VIDEO_PLAYBACK);
     }
 
     virtual int allocateVideoSessionId() {
-        Parcel data, reply;
-        data.writeInterfaceToken(IMultiDisplayVideoControl::getInterfaceDescriptor());
-        status_t result = remote()->transact(
-                MDS_SERVER_ALLOCATE_VIDEO_SESSIONID, data, &reply);
-        if (result != NO_ERROR) {
-            return -1;
-        }
-        return reply.readInt32();
+        return mdsCallValue(remote(), getInterfaceDescriptor(),
+                MDS_SERVER_ALLOCATE_VIDEO_SESSIONID, -1);
     }
 
     virtual status_t updateVideoState(int sessionId, MDS_VIDEO_STATE state) {
-        Parcel data, reply;
-        data.writeInterfaceToken(IMultiDisplayVideoControl::getInterfaceDescriptor());
-        data.writeInt32(sessionId);
-        data.writeInt32(state);
-        status_t result = remote()->transact(
-                MDS_SERVER_UPDATE_VIDEO_STATE, data, &reply);
-        if (result != NO_ERROR) {
-            return result;
-        }
-        result = reply.readInt32();
-        return result;
+        return mdsCall(remote(), getInterfaceDescriptor(),
+                MDS_SERVER_UPDATE_VIDEO_STATE, sessionId, state);
     }
 
     virtual status_t updateVideoSourceInfo(int sessionId, const MDSVideoSourceInfo& info) {
-        Parcel data, reply;
-        data.writeInterfaceToken(IMultiDisplayVideoControl::getInterfaceDescriptor());
-        data.writeInt32(sessionId);
-        data.write(&info, sizeof(MDSVideoSourceInfo));
-        status_t result = remote()->transact(
-                MDS_SERVER_UPDATE_VIDEO_SOURCE_INFO, data, &reply);
-        if (result != NO_ERROR) {
-            return result;
-        }
-        result = reply.readInt32();
-        return result;
+        return mdsCall(remote(), getInterfaceDescriptor(),
+                MDS_SERVER_UPDATE_VIDEO_SOURCE_INFO, sessionId, info);
+    }
+
+    virtual int allocateVideoSession(const sp<IBinder>& token) {
+        return mdsCallValue(remote(), getInterfaceDescriptor(),
+                MDS_SERVER_ALLOCATE_VIDEO_SESSION, -1, token);
     }
 
 };
@@ -104,32 +80,23 @@ status_t BnMultiDisplayVideoControl::onTransact(
     switch (code) {
         case MDS_SERVER_ALLOCATE_VIDEO_SESSIONID: {
             CHECK_INTERFACE(IMultiDisplayVideoControl, data, reply);
-            int32_t sessionId = allocateVideoSessionId();
-            reply->writeInt32(sessionId);
-            return NO_ERROR;
-            } break;
+            return mdsDispatch(this, &IMultiDisplayVideoControl::allocateVideoSessionId, data, reply);
+        } break;
         case MDS_SERVER_RESET_VIDEO_PLAYBACK: {
             CHECK_INTERFACE(IMultiDisplayVideoControl, data, reply);
-            status_t ret = resetVideoPlayback();
-            reply->writeInt32(ret);
-            return NO_ERROR;
-            } break;
+            return mdsDispatch(this, &IMultiDisplayVideoControl::resetVideoPlayback, data, reply);
+        } break;
         case MDS_SERVER_UPDATE_VIDEO_STATE: {
             CHECK_INTERFACE(IMultiDisplayVideoControl, data, reply);
-            int32_t sessionId = data.readInt32();
-            MDS_VIDEO_STATE state = (MDS_VIDEO_STATE)data.readInt32();
-            status_t ret = updateVideoState(sessionId, state);
-            reply->writeInt32(ret);
-            return NO_ERROR;
+            return mdsDispatch(this, &IMultiDisplayVideoControl::updateVideoState, data, reply);
         } break;
         case MDS_SERVER_UPDATE_VIDEO_SOURCE_INFO: {
             CHECK_INTERFACE(IMultiDisplayVideoControl, data, reply);
-            int32_t sessionId = data.readInt32();
-            MDSVideoSourceInfo info;
-            data.read(&info, sizeof(MDSVideoSourceInfo));
-            status_t ret = updateVideoSourceInfo(sessionId, info);
-            reply->writeInt32(ret);
-            return NO_ERROR;
+            return mdsDispatch(this, &IMultiDisplayVideoControl::updateVideoSourceInfo, data, reply);
+        } break;
+        case MDS_SERVER_ALLOCATE_VIDEO_SESSION: {
+            CHECK_INTERFACE(IMultiDisplayVideoControl, data, reply);
+            return mdsDispatch(this, &IMultiDisplayVideoControl::allocateVideoSession, data, reply);
         } break;
     } // switch
     return BBinder::onTransact(code, data, reply, flags);
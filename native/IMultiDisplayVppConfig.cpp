@@ -23,6 +23,7 @@
 #include <binder/Parcel.h>
 
 #include <display/IMultiDisplayVppConfig.h>
+#include "MultiDisplayMarshal.h"
 
 namespace android {
 namespace intel {
@@ -40,17 +41,8 @@ public:
     }
 
     virtual status_t setVppState(MDS_DISPLAY_ID dpyId, bool isOn) {
-        Parcel data, reply;
-        data.writeInterfaceToken(IMultiDisplayVppConfig::getInterfaceDescriptor());
-        data.writeInt32(dpyId);
-        data.writeInt32(isOn ? 1 : 0);
-        status_t result = remote()->transact(
-                MDS_SERVER_SET_VPP_STATE, data, &reply);
-        if (result != NO_ERROR) {
-            return result;
-        }
-        result = reply.readInt32();
-        return result;
+        return mdsCall(remote(), getInterfaceDescriptor(),
+                MDS_SERVER_SET_VPP_STATE, dpyId, isOn);
     }
 };
 
@@ -62,11 +54,7 @@ status_t BnMultiDisplayVppConfig::onTransact(
     switch (code) {
         case MDS_SERVER_SET_VPP_STATE: {
             CHECK_INTERFACE(IMultiDisplayVppConfig, data, reply);
-            MDS_DISPLAY_ID dpyId = (MDS_DISPLAY_ID)(data.readInt32());
-            bool isOn  = (data.readInt32() == 1 ? true : false);
-            status_t ret = setVppState(dpyId, isOn);
-            reply->writeInt32(ret);
-            return NO_ERROR;
+            return mdsDispatch(this, &IMultiDisplayVppConfig::setVppState, data, reply);
         } break;
     } // switch
     return BBinder::onTransact(code, data, reply, flags);
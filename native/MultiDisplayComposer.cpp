@@ -21,10 +21,19 @@
 #include <utils/Log.h>
 #include <utils/RefBase.h>
 #include <binder/Parcel.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
 
 #include <binder/IServiceManager.h>
 #include <binder/IPCThreadState.h>
+#include <cutils/properties.h>
+#include <cutils/atomic.h>
 #include "MultiDisplayComposer.h"
+#include "MultiDisplayLatency.h"
+#include "MultiDisplayTrace.h"
 #include "drm_hdmi.h"
 #ifdef TARGET_HAS_VPP
 #include "VPPSetting.h"
@@ -49,6 +58,98 @@ do { \
     } \
 } while(0)
 
+// The directory of the persisted state, a benchmark build moves it away
+#ifndef MDS_DATA_DIR
+#define MDS_DATA_DIR "/data/system"
+#endif
+
+// The snapshot is a binary record of MultiDisplaySnapshot
+const char* MultiDisplayComposer::SNAPSHOT_PATH = MDS_DATA_DIR "/mds.state";
+static const uint32_t SNAPSHOT_MAGIC   = 0x5344534d; // "MDSS"
+static const uint32_t SNAPSHOT_VERSION = 2;
+static const char* BOOT_ID_PATH = "/proc/sys/kernel/random/boot_id";
+const char* MultiDisplayComposer::PREFERENCES_PATH = MDS_DATA_DIR "/mds.sinks";
+const char* MultiDisplayComposer::RECORD_PATH = MDS_DATA_DIR "/mds.rec";
+const char* MultiDisplayComposer::RECORD_PROPERTY = "mds.record";
+
+// The latency of the calls made to HWC and the listeners
+static MultiDisplayLatency sCbGetCapabilities("IMultiDisplayCallback::getCapabilities");
+static MultiDisplayLatency sCbBlankSecondaryDisplay("IMultiDisplayCallback::blankSecondaryDisplay");
+static MultiDisplayLatency sCbUpdateVideoState("IMultiDisplayCallback::updateVideoState");
+static MultiDisplayLatency sCbSetHdmiTiming("IMultiDisplayCallback::setHdmiTiming");
+static MultiDisplayLatency sCbSetHdmiScalingType("IMultiDisplayCallback::setHdmiScalingType");
+static MultiDisplayLatency sCbSetHdmiOverscan("IMultiDisplayCallback::setHdmiOverscan");
+static MultiDisplayLatency sCbUpdateInputState("IMultiDisplayCallback::updateInputState");
+static MultiDisplayLatency sCbSetDisplayConfig("IMultiDisplayCallback::setDisplayConfig");
+static MultiDisplayLatency sListenerOnMdsMessage("IMultiDisplayListener::onMdsMessage");
+
+// The persisted state of an external display
+typedef struct {
+    int32_t       connection;
+    uint32_t      edidHash;
+    int32_t       timingSelected;
+    MDSHdmiTiming timing;
+    int32_t       scaleType;
+    uint32_t      hStep;
+    uint32_t      vStep;
+} MultiDisplayExternalRecord;
+
+struct MultiDisplaySnapshot {
+    // A snapshot is only valid in the boot where it is written
+    char    bootId[40];
+    int32_t mode;
+    int32_t virtualConnection;
+    int32_t externalCount;
+    int32_t hdmiIndex;
+    MultiDisplayExternalRecord external[MDS_EXTERNAL_DISPLAY_MAX];
+    MultiDisplaySessionRecord  sessions[MDS_VIDEO_SESSION_MAX_VALUE];
+};
+
+static void readBootId(char* id, size_t size) {
+    memset(id, 0, size);
+    int fd = open(BOOT_ID_PATH, O_RDONLY);
+    if (fd < 0) {
+        ALOGW("Fail to read boot id, %s", strerror(errno));
+        return;
+    }
+    ssize_t n = read(fd, id, size - 1);
+    close(fd);
+    // Strip the line break
+    for (ssize_t i = 0; i < n; i++) {
+        if (id[i] == '\n') {
+            id[i] = '\0';
+            break;
+        }
+    }
+}
+
+// The start time of a process in clock ticks since the boot, 0 if it is gone
+static uint64_t readProcessStartTime(pid_t pid) {
+    if (pid <= 0)
+        return 0;
+    char path[32];
+    snprintf(path, sizeof(path), "/proc/%d/stat", pid);
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return 0;
+    char buf[512];
+    ssize_t n = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    if (n <= 0)
+        return 0;
+    buf[n] = '\0';
+    // The name may hold spaces, the fields are counted from its end,
+    // the start time is the field 22
+    char* p = strrchr(buf, ')');
+    for (int field = 2; p != NULL && field < 22; field++)
+        p = strchr(p + 1, ' ');
+    return (p != NULL ? strtoull(p + 1, NULL, 10) : 0);
+}
+
+// A pid may be reused, the owner is alive if it is the same process
+static bool isOwnerAlive(pid_t pid, uint64_t startTime) {
+    return startTime != 0 && readProcessStartTime(pid) == startTime;
+}
 
 MultiDisplayListener::MultiDisplayListener(int msg, int32_t id,
         const char* client, sp<IMultiDisplayListener> listener) {
@@ -76,6 +177,75 @@ void MultiDisplayListener::dump() {
 }
 
 
+void MultiDisplayState::init(MDS_DISPLAY_ID dpyId, int index) {
+    id         = dpyId;
+    connector  = index;
+    connection = (dpyId == MDS_DISPLAY_PRIMARY ?
+            MDS_DISPLAY_CONNECTED : MDS_DISPLAY_DISCONNECTED);
+    edidHash   = 0;
+    scaleType  = MDS_SCALING_NONE;
+    hStep      = 0;
+    vStep      = 0;
+    timingCount = 0;
+    timingSelected = false;
+    memset(&timing, 0, sizeof(timing));
+    // The default Vpp policy: HDMI/MIPI is enabled, WIDI is disabled
+#ifdef TARGET_HAS_VPP
+    vpp        = (dpyId != MDS_DISPLAY_VIRTUAL);
+#else
+    vpp        = false;
+#endif
+}
+
+void MultiDisplayState::get(MDSDisplayState* state) const {
+    memset(state, 0, sizeof(MDSDisplayState));
+    state->id          = id;
+    state->connector   = connector;
+    state->connection  = connection;
+    state->timingCount = timingCount;
+    state->scaling     = scaleType;
+    // Report the values in the unit of setHdmiOverscan
+    state->hOverscan   = overscan_max - hStep;
+    state->vOverscan   = overscan_max - vStep;
+    state->vpp         = vpp;
+}
+
+void MultiDisplayVideoSession::save(MultiDisplaySessionRecord* record) {
+    memset(record, 0, sizeof(MultiDisplaySessionRecord));
+    record->state = mState;
+    if (mState == MDS_VIDEO_UNPREPARED)
+        return;
+    record->owner = mOwner;
+    if (mOwnerStartTime == 0)
+        mOwnerStartTime = readProcessStartTime(mOwner);
+    record->ownerStartTime = mOwnerStartTime;
+    record->infoValid = mInfoValid;
+    // Field by field, the padding stays zero
+    record->info.frameRate    = mInfo.frameRate;
+    record->info.displayW     = mInfo.displayW;
+    record->info.displayH     = mInfo.displayH;
+    record->info.isInterlaced = mInfo.isInterlaced;
+    record->info.isProtected  = mInfo.isProtected;
+    record->decoderConfigValid  = mDecoderConfigValid;
+    record->decoderConfigWidth  = mDecoderConfigWidth;
+    record->decoderConfigHeight = mDecoderConfigHeight;
+}
+
+void MultiDisplayVideoSession::restore(const MultiDisplaySessionRecord& record) {
+    init();
+    if (setState((MDS_VIDEO_STATE)record.state) != NO_ERROR ||
+            mState == MDS_VIDEO_UNPREPARED)
+        return;
+    mOwner = record.owner;
+    mOwnerStartTime = record.ownerStartTime;
+    mRestored = true;
+    if (record.infoValid)
+        setInfo(record.info);
+    if (record.decoderConfigValid)
+        setDecoderOutputResolution(
+                record.decoderConfigWidth, record.decoderConfigHeight);
+}
+
 void MultiDisplayVideoSession::dump(int index) {
     if (mState < MDS_VIDEO_PREPARING ||
             mState >= MDS_VIDEO_UNPREPARED)
@@ -84,160 +254,898 @@ void MultiDisplayVideoSession::dump(int index) {
             mInfo.displayW, mInfo.displayH, mInfo.frameRate);
 }
 
+void MultiDisplayVideoSession::dump(int index, String8& out) {
+    // An allocated session is shown till it is prepared
+    if (mState == MDS_VIDEO_UNPREPARED && mToken == NULL)
+        return;
+    out.appendFormat("  [%d] state %d, owner %d%s", index, mState, mOwner,
+            (mToken != NULL ? ", linked" : (mRestored ? ", restored" : "")));
+    if (mInfoValid)
+        out.appendFormat(", %dx%d@%d%s%s", mInfo.displayW, mInfo.displayH,
+                mInfo.frameRate, mInfo.isInterlaced ? "i" : "",
+                mInfo.isProtected ? ", protected" : "");
+    if (mDecoderConfigValid)
+        out.appendFormat(", decoder %dx%d",
+                mDecoderConfigWidth, mDecoderConfigHeight);
+    out.append("\n");
+}
+
+MultiDisplayInputMonitor::MultiDisplayInputMonitor(MultiDisplayComposer* com) :
+    Thread(false),
+    mComposer(com),
+    mLastActivity(0),
+    mActive(false),
+    mReported(false)
+{
+}
+
+void MultiDisplayInputMonitor::notifyActivity() {
+    Mutex::Autolock lock(mLock);
+    mLastActivity = systemTime();
+    if (!mActive) {
+        mActive = true;
+        mCondition.signal();
+    }
+}
+
+void MultiDisplayInputMonitor::stop() {
+    {
+        Mutex::Autolock lock(mLock);
+        requestExit();
+        mCondition.signal();
+    }
+    requestExitAndWait();
+}
+
+bool MultiDisplayInputMonitor::threadLoop() {
+    bool state;
+    {
+        Mutex::Autolock lock(mLock);
+        while (!exitPending() && mActive == mReported) {
+            if (!mActive) {
+                mCondition.wait(mLock);
+                continue;
+            }
+            nsecs_t now = systemTime();
+            nsecs_t idle = mLastActivity + ms2ns(INPUT_IDLE_TIMEOUT_MS);
+            if (now >= idle) {
+                mActive = false;
+                break;
+            }
+            mCondition.waitRelative(mLock, idle - now);
+        }
+        if (exitPending())
+            return false;
+        state = mActive;
+        mReported = mActive;
+    }
+    ALOGV("input is %s", state ? "active" : "idle");
+    mComposer->updateInputState(state);
+    return true;
+}
+
+const char* MultiDisplayHotplugDebouncer::SETTLE_TIME_PROPERTY = "mds.hotplug.settle_ms";
+
+MultiDisplayHotplugDebouncer::MultiDisplayHotplugDebouncer(
+        MultiDisplayComposer* com, int settleMs) :
+    Thread(false),
+    mComposer(com),
+    mSettleTime(ms2ns(settleMs)),
+    mDeadline(0),
+    mPending(false),
+    mConnected(false)
+{
+}
+
+void MultiDisplayHotplugDebouncer::post(bool connected) {
+    Mutex::Autolock lock(mLock);
+    // Every new hotplug restarts the settle window
+    mConnected = connected;
+    mDeadline = systemTime() + mSettleTime;
+    if (!mPending) {
+        mPending = true;
+        mCondition.signal();
+    }
+}
+
+void MultiDisplayHotplugDebouncer::stop() {
+    {
+        Mutex::Autolock lock(mLock);
+        requestExit();
+        mCondition.signal();
+    }
+    requestExitAndWait();
+}
+
+bool MultiDisplayHotplugDebouncer::threadLoop() {
+    bool connected;
+    {
+        Mutex::Autolock lock(mLock);
+        while (!exitPending()) {
+            if (!mPending) {
+                mCondition.wait(mLock);
+                continue;
+            }
+            nsecs_t now = systemTime();
+            if (now >= mDeadline)
+                break;
+            mCondition.waitRelative(mLock, mDeadline - now);
+        }
+        if (exitPending())
+            return false;
+        mPending = false;
+        connected = mConnected;
+    }
+    mComposer->commitHdmiHotplug(connected);
+    return true;
+}
+
+const char* MultiDisplayVideoLeaseMonitor::LEASE_TIME_PROPERTY = "mds.video.lease_ms";
+
+MultiDisplayVideoLeaseMonitor::MultiDisplayVideoLeaseMonitor(
+        MultiDisplayComposer* com, int leaseMs) :
+    Thread(false),
+    mComposer(com),
+    mLeaseTime(ms2ns(leaseMs)),
+    mDeadline(0)
+{
+}
+
+void MultiDisplayVideoLeaseMonitor::schedule(nsecs_t deadline) {
+    Mutex::Autolock lock(mLock);
+    if (mDeadline == 0 || deadline < mDeadline) {
+        mDeadline = deadline;
+        mCondition.signal();
+    }
+}
+
+void MultiDisplayVideoLeaseMonitor::stop() {
+    {
+        Mutex::Autolock lock(mLock);
+        requestExit();
+        mCondition.signal();
+    }
+    requestExitAndWait();
+}
+
+bool MultiDisplayVideoLeaseMonitor::threadLoop() {
+    {
+        Mutex::Autolock lock(mLock);
+        while (!exitPending()) {
+            if (mDeadline == 0) {
+                mCondition.wait(mLock);
+                continue;
+            }
+            nsecs_t now = systemTime();
+            if (now >= mDeadline)
+                break;
+            mCondition.waitRelative(mLock, mDeadline - now);
+        }
+        if (exitPending())
+            return false;
+        mDeadline = 0;
+    }
+    // The next check is scheduled for the sessions still in the lease
+    mComposer->expireVideoSessions();
+    return true;
+}
+
+MultiDisplaySnapshotWriter::MultiDisplaySnapshotWriter(MultiDisplayComposer* com) :
+    Thread(false),
+    mComposer(com),
+    mDeadline(0),
+    mPending(false)
+{
+}
+
+void MultiDisplaySnapshotWriter::post() {
+    Mutex::Autolock lock(mLock);
+    // A change posted before the write is in it
+    if (!mPending) {
+        mPending = true;
+        mDeadline = systemTime() + ms2ns(WRITE_DELAY_MS);
+        mCondition.signal();
+    }
+}
+
+void MultiDisplaySnapshotWriter::stop() {
+    {
+        Mutex::Autolock lock(mLock);
+        requestExit();
+        mCondition.signal();
+    }
+    requestExitAndWait();
+}
+
+bool MultiDisplaySnapshotWriter::threadLoop() {
+    {
+        Mutex::Autolock lock(mLock);
+        while (!exitPending()) {
+            if (!mPending) {
+                mCondition.wait(mLock);
+                continue;
+            }
+            nsecs_t now = systemTime();
+            if (now >= mDeadline)
+                break;
+            mCondition.waitRelative(mLock, mDeadline - now);
+        }
+        // The last change is not lost on exit
+        if (!mPending)
+            return false;
+        mPending = false;
+    }
+    mComposer->writeSnapshot();
+    return !exitPending();
+}
+
+bool MultiDisplayInitThread::threadLoop() {
+    mComposer->init();
+    return false;
+}
+
+void MultiDisplaySurfaceComposerObserver::binderDied(const wp<IBinder>& who) {
+    mComposer->onSurfaceComposerDied(who);
+}
+
+void MultiDisplayClientObserver::binderDied(const wp<IBinder>& who) {
+    mComposer->onClientDied(who);
+}
+
+void MultiDisplayVideoOwnerObserver::binderDied(const wp<IBinder>& who) {
+    mComposer->onVideoOwnerDied(who);
+}
+
 MultiDisplayComposer::MultiDisplayComposer() :
+    mDisplayLock("mDisplayLock"),
+    mVideoNotifyLock("mVideoNotifyLock"),
+    mVideoLock("mVideoLock"),
+    mCallbackLock("mCallbackLock"),
+    mListenerLock("mListenerLock"),
     mDrmInit(false),
-#ifdef TARGET_HAS_VPP
-    mDisplayId(MDS_DISPLAY_PRIMARY),
-#endif
-    mListenerId(0),
+    mReady(false),
     mMode(MDS_MODE_NONE),
-    mScaleType(MDS_SCALING_NONE),
-    mHorizontalStep(0),
-    mVerticalStep(0),
+    mBroadcastMode(MDS_MODE_NONE),
+    mListenerBitmap(0),
+    mListenerCount(0),
+    mExternalCount(0),
+    mHdmiIndex(0),
     mSurfaceComposer(NULL),
-    mMDSCallback(NULL)
+    mMDSCallback(NULL),
+    mCallbackCaps(0),
+    mSnapshotStore(SNAPSHOT_PATH, SNAPSHOT_MAGIC, SNAPSHOT_VERSION),
+    mSnapshot(NULL),
+    mSinkPreferences(PREFERENCES_PATH)
 {
-    init();
+    mPrimary.init(MDS_DISPLAY_PRIMARY, 0);
+    mVirtual.init(MDS_DISPLAY_VIRTUAL, 0);
+    for (int i = 0; i < MDS_EXTERNAL_DISPLAY_MAX; i++)
+        mExternal[i].init(MDS_DISPLAY_EXTERNAL, i);
+    memset(mListeners, 0, sizeof(mListeners));
+    memset(mListenerGenerations, 0, sizeof(mListenerGenerations));
+    mSurfaceComposerObserver = new MultiDisplaySurfaceComposerObserver(this);
+    mClientObserver = new MultiDisplayClientObserver(this);
+    mVideoOwnerObserver = new MultiDisplayVideoOwnerObserver(this);
+    initVideoSessions_l();
+    mSnapshot = new MultiDisplaySnapshot;
+    memset(mSnapshot, 0, sizeof(MultiDisplaySnapshot));
+    readBootId(mBootId, sizeof(mBootId));
+#ifdef MDS_TRACE
+    mHotplugTraceId = 0;
+    mHotplugTraceDone = 0;
+#endif
+    // Clients see the last state until DRM is validated by init()
+    restoreSnapshot();
+    mSnapshotWriter = new MultiDisplaySnapshotWriter(this);
+    if (mSnapshotWriter->run("MDSSnapshotWriter", PRIORITY_BACKGROUND) != NO_ERROR) {
+        ALOGW("Fail to start snapshot writer, the state isn't saved");
+        mSnapshotWriter = NULL;
+    }
+    // Record from the start, the early registrations are in the log
+    char value[PROPERTY_VALUE_MAX];
+    if (property_get(RECORD_PROPERTY, value, "0") > 0 && atoi(value) != 0)
+        startRecording();
+    // DRM bring-up may be blocked by a slow DDC probe,
+    // it mustn't delay the service registration.
+    mInitThread = new MultiDisplayInitThread(this);
+    if (mInitThread->run("MDSInit", PRIORITY_DEFAULT) != NO_ERROR) {
+        ALOGW("Fail to start init thread, bring up DRM synchronously");
+        mInitThread = NULL;
+        init();
+    }
+    mInputMonitor = new MultiDisplayInputMonitor(this);
+    mInputMonitor->run("MDSInputMonitor", PRIORITY_DEFAULT);
+
+    int settleMs = MultiDisplayHotplugDebouncer::SETTLE_TIME_DEFAULT_MS;
+    if (property_get(MultiDisplayHotplugDebouncer::SETTLE_TIME_PROPERTY, value, NULL) > 0)
+        settleMs = atoi(value);
+    if (settleMs > 0) {
+        mHotplugDebouncer = new MultiDisplayHotplugDebouncer(this, settleMs);
+        mHotplugDebouncer->run("MDSHotplugDebouncer", PRIORITY_DEFAULT);
+    }
+    ALOGI("HDMI hotplug settle window %d ms", settleMs);
+
+    int leaseMs = MultiDisplayVideoLeaseMonitor::LEASE_TIME_DEFAULT_MS;
+    if (property_get(MultiDisplayVideoLeaseMonitor::LEASE_TIME_PROPERTY, value, NULL) > 0)
+        leaseMs = atoi(value);
+    if (leaseMs < 0)
+        leaseMs = 0;
+    // Run without a lease too, for the owners of the restored sessions
+    mVideoLeaseMonitor = new MultiDisplayVideoLeaseMonitor(this, leaseMs);
+    if (mVideoLeaseMonitor->run("MDSVideoLease", PRIORITY_DEFAULT) != NO_ERROR) {
+        ALOGW("Fail to start video lease monitor");
+        mVideoLeaseMonitor = NULL;
+    } else {
+        // The restored sessions are in the lease too
+        expireVideoSessions();
+    }
+    ALOGI("Video session lease %d ms", leaseMs);
 }
 
 MultiDisplayComposer::~MultiDisplayComposer() {
+    if (mInitThread != NULL) {
+        mInitThread->requestExitAndWait();
+        mInitThread = NULL;
+    }
+    if (mInputMonitor != NULL) {
+        mInputMonitor->stop();
+        mInputMonitor = NULL;
+    }
+    if (mHotplugDebouncer != NULL) {
+        mHotplugDebouncer->stop();
+        mHotplugDebouncer = NULL;
+    }
+    if (mVideoLeaseMonitor != NULL) {
+        mVideoLeaseMonitor->stop();
+        mVideoLeaseMonitor = NULL;
+    }
+    // After the threads which save the state
+    if (mSnapshotWriter != NULL) {
+        mSnapshotWriter->stop();
+        mSnapshotWriter = NULL;
+    }
     drm_cleanup();
 
-    // Remove all the listeners.
-    size_t size = mListeners.size();
-    if (size > 0) {
-        MultiDisplayListener* listener = NULL;
-        for (size_t i = 0; i < size; i++) {
-            listener = mListeners.valueAt(i);
-            delete listener;
-        }
-        mListeners.clear();
+    for (int i = 0; i < MDS_VIDEO_SESSION_MAX_VALUE; i++) {
+        if (mVideos[i].getToken() != NULL)
+            mVideos[i].getToken()->unlinkToDeath(mVideoOwnerObserver);
+        mVideos[i].init();
     }
 
+    // Remove all the listeners.
+    while (mListenerBitmap != 0)
+        removeListener_l(__builtin_ctzll(mListenerBitmap))->unlinkToDeath(mClientObserver);
+
+    if (mSurfaceComposer != NULL)
+        mSurfaceComposer->unlinkToDeath(mSurfaceComposerObserver);
     mSurfaceComposer = NULL;
+    if (mMDSCallback != NULL)
+        mMDSCallback->asBinder()->unlinkToDeath(mClientObserver);
     mMDSCallback = NULL;
+    delete mSnapshot;
+    mSnapshot = NULL;
 }
 
 void MultiDisplayComposer::init() {
-    if (!drm_init()) {
+    MDS_TRACE_CALL();
+    // Open the device out of the lock, nothing touches DRM until mDrmInit
+    bool drmInit = drm_init();
+    if (!drmInit)
         LOGE("Fail to init drm");
+
+    MDS_AUTOLOCK(mDisplayLock);
+    {
+        RWLock::AutoWLock stateLock(mStateLock);
+        mDrmInit = drmInit;
+        // Forget the restored external displays if DRM is unavailable
+        mExternalCount = (mDrmInit ? drm_hdmi_getConnectorCount() : 0);
+        if (mHdmiIndex >= mExternalCount)
+            mHdmiIndex = 0;
+    }
+    if (mDrmInit) {
+        // The hotplugs before are dropped, read the current state here
+        updateHdmiConnectStatusLocked();
+        for (int i = 0; i < mExternalCount; i++) {
+            MultiDisplayState& state = mExternal[i];
+            uint32_t edidHash = drm_hdmi_getEdidHash(i);
+            bool broadcasted = false;
+            if (edidHash != state.edidHash) {
+                // The restored settings belong to another sink
+                {
+                    RWLock::AutoWLock stateLock(mStateLock);
+                    state.edidHash = edidHash;
+                }
+                broadcasted = applySinkPreferenceLocked(i);
+            } else if (state.timingSelected) {
+                // The same sink, restore the timing selected by the user
+                MDSHdmiTiming timing = state.timing;
+                int index = drm_hdmi_findTiming(i, &timing);
+                if (index >= 0)
+                    drm_hdmi_selectTiming(i, index);
+            }
+            if (!broadcasted && state.isConnected())
+                broadcastDisplayState(state);
+        }
+        // TODO: if HDMI is connected, update vpp policy
+        //setDisplayState_l(MDS_DISPLAY_EXTERNAL, VPPSetting::isVppOn());
+    } else {
+        updateMode(0, MDS_HDMI_CONNECTED | MDS_DVI_CONNECTED);
+    }
+    {
+        RWLock::AutoWLock stateLock(mStateLock);
+        mReady = true;
+    }
+    int32_t mode = android_atomic_acquire_load(&mMode);
+    ALOGI("MDS is ready, drm %d, mode 0x%x", mDrmInit, mode);
+
+    // The listeners registered early have got a provisional mode
+    broadcastModeChange(false);
+    broadcastMessage((int)MDS_MSG_READY, &mode, sizeof(mode), false);
+    saveSnapshot();
+}
+
+void MultiDisplayComposer::restoreSnapshot() {
+    MultiDisplaySnapshot snapshot;
+    if (mSnapshotStore.load(&snapshot, sizeof(snapshot)) != NO_ERROR)
+        return;
+    // A new boot starts from scratch
+    if (mBootId[0] == '\0' ||
+            memcmp(snapshot.bootId, mBootId, sizeof(mBootId)) != 0) {
+        ALOGI("Drop the snapshot of another boot");
+        mSnapshotStore.remove();
         return;
     }
 
-    mDrmInit = true;
-#ifdef TARGET_HAS_VPP
-    setVppState_l(MDS_DISPLAY_PRIMARY, VPPSetting::isVppOn());
-#endif
+    // No other thread is running yet, nothing needs a lock.
+    // The sessions of the players which are gone are not restored,
+    // the others are released by mVideoLeaseMonitor once their owner is gone.
+    int sessions = 0;
+    for (int i = 0; i < MDS_VIDEO_SESSION_MAX_VALUE; i++) {
+        const MultiDisplaySessionRecord& record = snapshot.sessions[i];
+        if (!isOwnerAlive(record.owner, record.ownerStartTime))
+            continue;
+        mVideos[i].restore(record);
+        if (mVideos[i].getState() != MDS_VIDEO_UNPREPARED)
+            sessions++;
+    }
 
-    initVideoSessions_l();
-    updateHdmiConnectStatusLocked();
-    // TODO: if HDMI is connected, update vpp policy
-    //setDisplayState_l(MDS_DISPLAY_EXTERNAL, VPPSetting::isVppOn());
+    mVirtual.connection = (snapshot.virtualConnection == MDS_DISPLAY_CONNECTED ?
+            MDS_DISPLAY_CONNECTED : MDS_DISPLAY_DISCONNECTED);
+    mExternalCount = snapshot.externalCount;
+    if (mExternalCount < 0 || mExternalCount > MDS_EXTERNAL_DISPLAY_MAX)
+        mExternalCount = 0;
+    mHdmiIndex = snapshot.hdmiIndex;
+    if (mHdmiIndex < 0 || mHdmiIndex >= mExternalCount)
+        mHdmiIndex = 0;
+    // The values are validated against DRM by init()
+    for (int i = 0; i < mExternalCount; i++) {
+        const MultiDisplayExternalRecord& record = snapshot.external[i];
+        MultiDisplayState& state = mExternal[i];
+        state.connection = (MDS_DISPLAY_CONNECTION)record.connection;
+        state.edidHash = record.edidHash;
+        state.timingSelected = record.timingSelected;
+        state.timing = record.timing;
+        state.scaleType = (MDS_SCALING_TYPE)record.scaleType;
+        state.hStep = record.hStep;
+        state.vStep = record.vStep;
+    }
+
+    int mode = snapshot.mode & ~MDS_VIDEO_ON;
+    if (hasVideoPlaying_l())
+        mode |= MDS_VIDEO_ON;
+    mMode = mode;
+    mBroadcastMode = mode;
+    memcpy(mSnapshot, &snapshot, sizeof(snapshot));
+    ALOGI("Restore the snapshot, mode 0x%x, %d video sessions", mode, sessions);
+}
+
+void MultiDisplayComposer::saveSnapshot() {
+    if (mSnapshotWriter != NULL)
+        mSnapshotWriter->post();
+}
+
+void MultiDisplayComposer::writeSnapshot() {
+    MultiDisplaySnapshot snapshot;
+    memset(&snapshot, 0, sizeof(snapshot));
+    memcpy(snapshot.bootId, mBootId, sizeof(snapshot.bootId));
+    snapshot.mode = android_atomic_acquire_load(&mMode);
+    {
+        MDS_AUTOLOCK(mVideoLock);
+        for (int i = 0; i < MDS_VIDEO_SESSION_MAX_VALUE; i++)
+            mVideos[i].save(&snapshot.sessions[i]);
+    }
+    {
+        RWLock::AutoRLock stateLock(mStateLock);
+        snapshot.virtualConnection = mVirtual.connection;
+        snapshot.externalCount = mExternalCount;
+        snapshot.hdmiIndex = mHdmiIndex;
+        for (int i = 0; i < mExternalCount; i++) {
+            const MultiDisplayState& state = mExternal[i];
+            MultiDisplayExternalRecord& record = snapshot.external[i];
+            record.connection = state.connection;
+            record.edidHash = state.edidHash;
+            record.timingSelected = state.timingSelected;
+            if (state.timingSelected)
+                record.timing = state.timing;
+            record.scaleType = state.scaleType;
+            record.hStep = state.hStep;
+            record.vStep = state.vStep;
+        }
+    }
+    // Nothing is changed since the last write
+    if (memcmp(&snapshot, mSnapshot, sizeof(snapshot)) == 0)
+        return;
+    if (mSnapshotStore.save(&snapshot, sizeof(snapshot)) == NO_ERROR)
+        memcpy(mSnapshot, &snapshot, sizeof(snapshot));
+}
+
+bool MultiDisplayComposer::isReady() {
+    RWLock::AutoRLock lock(mStateLock);
+    return mReady;
 }
 
 status_t MultiDisplayComposer::updateHdmiConnectStatusLocked() {
+    MDS_TRACE_CALL();
     MDC_CHECK_INIT();
 
-    int connectStatus = drm_hdmi_getConnectionStatus();
-    if (connectStatus == DRM_HDMI_CONNECTED) {
-        mMode |= MDS_HDMI_CONNECTED;
-    } else if (connectStatus == DRM_DVI_CONNECTED) {
-        mMode |= MDS_DVI_CONNECTED;
-    } else {
-        mMode &= ~(MDS_HDMI_CONNECTED | MDS_DVI_CONNECTED);
-        drm_hdmi_onHdmiDisconnected();
+    // Probe out of mStateLock, a slow DDC transfer mustn't block the readers.
+    // The mode bits summarize all the HDMI and DVI connectors,
+    // a DisplayPort sink is only reported by its display state.
+    MDS_DISPLAY_CONNECTION connection[MDS_EXTERNAL_DISPLAY_MAX];
+    int timingCount[MDS_EXTERNAL_DISPLAY_MAX];
+    int mode = 0;
+    for (int i = 0; i < mExternalCount; i++) {
+        int connectStatus = drm_hdmi_getConnectionStatus(i);
+        if (connectStatus == DRM_HDMI_CONNECTED) {
+            mode |= MDS_HDMI_CONNECTED;
+        } else if (connectStatus == DRM_DVI_CONNECTED) {
+            mode |= MDS_DVI_CONNECTED;
+        } else if (connectStatus == DRM_HDMI_DISCONNECTED) {
+            drm_hdmi_onHdmiDisconnected(i);
+        }
+        // The DRM status values are aligned with MDS_DISPLAY_CONNECTION
+        connection[i] = (MDS_DISPLAY_CONNECTION)connectStatus;
+        timingCount[i] = 0;
+        if (connectStatus != DRM_HDMI_DISCONNECTED)
+            timingCount[i] = drm_hdmi_getTimingNumber(i);
+        ALOGI("Display %d ConnectStatus is %d", i, connectStatus);
+    }
+
+    {
+        RWLock::AutoWLock lock(mStateLock);
+        for (int i = 0; i < mExternalCount; i++) {
+            mExternal[i].connection  = connection[i];
+            mExternal[i].timingCount = timingCount[i];
+        }
+        // The HDMI control addresses the first connected external display
+        if (!hdmiState_l().isConnected()) {
+            for (int i = 0; i < mExternalCount; i++) {
+                if (mExternal[i].isConnected()) {
+                    mHdmiIndex = i;
+                    break;
+                }
+            }
+        }
     }
-    ALOGI("ConnectStatus is %d, mode is 0x%x", connectStatus, mMode);
+    updateMode(mode, MDS_HDMI_CONNECTED | MDS_DVI_CONNECTED);
+    ALOGI("mode is 0x%x, HDMI control display %d", mMode, mHdmiIndex);
+    return NO_ERROR;
+}
+
+MultiDisplayState* MultiDisplayComposer::getDisplayState_l(
+        MDS_DISPLAY_ID id, int connector) {
+    switch (id) {
+        case MDS_DISPLAY_PRIMARY:
+            return (connector == 0 ? &mPrimary : NULL);
+        case MDS_DISPLAY_VIRTUAL:
+            return (connector == 0 ? &mVirtual : NULL);
+        case MDS_DISPLAY_EXTERNAL:
+            if (connector < 0 || connector >= mExternalCount)
+                return NULL;
+            return &mExternal[connector];
+    }
+    return NULL;
+}
+
+int MultiDisplayComposer::getExternalDisplayCount() {
+    RWLock::AutoRLock lock(mStateLock);
+    return mExternalCount;
+}
+
+status_t MultiDisplayComposer::getDisplayState(
+        MDS_DISPLAY_ID id, int connector, MDSDisplayState* state) {
+    if (state == NULL)
+        return BAD_VALUE;
+    // The timing count is cached by the probe, no DRM access here
+    RWLock::AutoRLock lock(mStateLock);
+    MultiDisplayState* entry = getDisplayState_l(id, connector);
+    if (entry == NULL)
+        return BAD_VALUE;
+    entry->get(state);
+#ifdef TARGET_HAS_VPP
+    state->vpp = entry->vpp && VPPSetting::isVppOn();
+#endif
     return NO_ERROR;
 }
 
+void MultiDisplayComposer::broadcastDisplayState(const MultiDisplayState& state) {
+    MDSDisplayState value;
+    state.get(&value);
+    ALOGV("Display %d:%d state %d", value.id, value.connector, value.connection);
+    broadcastMessage((int)MDS_MSG_DISPLAY_STATE, &value, sizeof(value), false);
+}
+
 status_t MultiDisplayComposer::registerCallback(const sp<IMultiDisplayCallback>& cbk) {
-    Mutex::Autolock lock(mMutex);
+    mRecorder.record(MDS_REC_REGISTER_CALLBACK);
     if (cbk.get() == NULL) {
         ALOGE("Callback is null");
         return BAD_VALUE;
     }
-    mMDSCallback = cbk;
+    // Query it out of the lock, it is a binder call
+    uint32_t caps = 0;
+    {
+        MDS_LATENCY_SCOPE(sCbGetCapabilities);
+        caps = cbk->getCapabilities();
+    }
+    ALOGI("Callback capabilities 0x%x", caps);
+    sp<IMultiDisplayCallback> old;
+    {
+        MDS_AUTOLOCK(mCallbackLock);
+        old = mMDSCallback;
+        mMDSCallback = cbk;
+        mCallbackCaps = caps;
+    }
+    if (old != cbk) {
+        if (old != NULL)
+            old->asBinder()->unlinkToDeath(mClientObserver);
+        // A callback of this process never dies alone
+        if (cbk->asBinder()->linkToDeath(mClientObserver) == DEAD_OBJECT) {
+            ALOGW("The callback is dead");
+            onClientDied(cbk->asBinder());
+            return DEAD_OBJECT;
+        }
+    }
 
     // Make sure the hdmi status is aligned
     // between MDS and hwc.
+    MDS_AUTOLOCK(mDisplayLock);
     updateHdmiConnectStatusLocked();
     return NO_ERROR;
 }
 
 status_t MultiDisplayComposer::unregisterCallback(const sp<IMultiDisplayCallback>& cbk) {
-    Mutex::Autolock lock(mMutex);
-    mMDSCallback = NULL;
+    mRecorder.record(MDS_REC_UNREGISTER_CALLBACK);
+    sp<IMultiDisplayCallback> old;
+    {
+        MDS_AUTOLOCK(mCallbackLock);
+        old = mMDSCallback;
+        mMDSCallback = NULL;
+        mCallbackCaps = 0;
+    }
+    if (old != NULL)
+        old->asBinder()->unlinkToDeath(mClientObserver);
     return NO_ERROR;
 }
 
+sp<IMultiDisplayCallback> MultiDisplayComposer::getCallback(uint32_t caps) {
+    // A snapshot, the callback is called out of mCallbackLock
+    MDS_AUTOLOCK(mCallbackLock);
+    if ((mCallbackCaps & caps) != caps)
+        return NULL;
+    return mMDSCallback;
+}
+
+void MultiDisplayComposer::updateCallbackCap(
+        const sp<IMultiDisplayCallback>& cbk, uint32_t cap, status_t result) {
+    if (result != INVALID_OPERATION && result != UNKNOWN_TRANSACTION)
+        return;
+    MDS_AUTOLOCK(mCallbackLock);
+    // The callback may be replaced during the call
+    if (mMDSCallback != cbk)
+        return;
+    // The callback doesn't implement it, don't try it again
+    ALOGI("Callback doesn't support 0x%x", cap);
+    mCallbackCaps &= ~cap;
+}
+
 status_t MultiDisplayComposer::updateHdmiConnectionStatus(bool connected) {
-    Mutex::Autolock lock(mMutex);
+    mRecorder.record(MDS_REC_UPDATE_HDMI_CONNECTION, connected);
+#ifdef MDS_TRACE
+    // A flow per event, the ones merged by the debouncer end together
+    MDS_TRACE_ASYNC_BEGIN("HDMI hotplug", android_atomic_inc(&mHotplugTraceId) + 1);
+#endif
+    if (mHotplugDebouncer != NULL) {
+        mHotplugDebouncer->post(connected);
+        return NO_ERROR;
+    }
+    MDS_AUTOLOCK(mDisplayLock);
+    return notifyHotplugLocked(MDS_DISPLAY_EXTERNAL, connected);
+}
+
+status_t MultiDisplayComposer::commitHdmiHotplug(bool connected) {
+    MDS_AUTOLOCK(mDisplayLock);
     return notifyHotplugLocked(MDS_DISPLAY_EXTERNAL, connected);
 }
 
 status_t MultiDisplayComposer::updateWidiConnectionStatus(bool connected) {
-    Mutex::Autolock lock(mMutex);
+    mRecorder.record(MDS_REC_UPDATE_WIDI_CONNECTION, connected);
+    MDS_AUTOLOCK(mDisplayLock);
     return notifyHotplugLocked(MDS_DISPLAY_VIRTUAL, connected);
 }
 
 status_t MultiDisplayComposer::notifyHotplugLocked(
         MDS_DISPLAY_ID dispId, bool connected) {
+    MDS_TRACE_CALL();
     ALOGI("Display ID:%d, connected state:%d", dispId, connected);
-    // Notify widi video extended mode
-    int mode = mMode;
     // update vpp policy
     //setVppState_l(dispId, connected);
     if (dispId == MDS_DISPLAY_VIRTUAL) {
+        // Notify widi video extended mode
+        {
+            RWLock::AutoWLock lock(mStateLock);
+            mVirtual.connection = (connected ?
+                    MDS_DISPLAY_CONNECTED : MDS_DISPLAY_DISCONNECTED);
+        }
         if (connected)
-            mMode |= MDS_WIDI_ON;
+            updateMode(MDS_WIDI_ON, 0);
         else
-            mMode &= ~MDS_WIDI_ON;
-        broadcastMessageLocked((int)MDS_MSG_MODE_CHANGE, &mMode, sizeof(mMode), false);
+            updateMode(0, MDS_WIDI_ON);
+        broadcastModeChange(false);
+        broadcastDisplayState(mVirtual);
+        saveSnapshot();
         return NO_ERROR;
     }
-    // Notify hdmi hotplug and switch audio
-    if (hasVideoPlaying_l()) {
-        mMode |= MDS_VIDEO_ON;
-    } else {
-        mMode &= ~MDS_VIDEO_ON;
+#ifdef MDS_TRACE
+    // The flows end here, the commit is the section of this function
+    int32_t traceId = android_atomic_acquire_load(&mHotplugTraceId);
+    for (; mHotplugTraceDone < traceId; mHotplugTraceDone++)
+        MDS_TRACE_ASYNC_END("HDMI hotplug", mHotplugTraceDone + 1);
+#endif
+    // The bring-up reads the HDMI state when it finishes
+    if (!mReady) {
+        ALOGI("Drop the HDMI hotplug before MDS is ready");
+        return NO_INIT;
     }
+    // Notify hdmi hotplug and switch audio.
+    // The event doesn't tell which connector, check all of them
+    const int hdmiMode = MDS_HDMI_CONNECTED | MDS_DVI_CONNECTED;
+    int mode = android_atomic_acquire_load(&mMode) & hdmiMode;
+    MDS_DISPLAY_CONNECTION previous[MDS_EXTERNAL_DISPLAY_MAX];
+    for (int i = 0; i < mExternalCount; i++)
+        previous[i] = mExternal[i].connection;
     updateHdmiConnectStatusLocked();
 
-    if (mode != mMode) {
-        int connection = connected ? 1 : 0;
-        broadcastMessageLocked((int)MDS_MSG_MODE_CHANGE, &mMode, sizeof(mMode), false);
-        drm_hdmi_notify_audio_hotplug(connected);
+    // Nothing to do if the same sink is still connected,
+    // or it is still disconnected
+    bool changed = false;
+    bool swapped = false;
+    for (int i = 0; i < mExternalCount; i++) {
+        MultiDisplayState& state = mExternal[i];
+        uint32_t edidHash = drm_hdmi_getEdidHash(i);
+        if (state.connection == previous[i] && edidHash == state.edidHash)
+            continue;
+        // The debouncer merges an unplug and a replug of another sink
+        if (state.edidHash != 0 && edidHash != 0)
+            swapped = true;
+        {
+            RWLock::AutoWLock lock(mStateLock);
+            state.edidHash = edidHash;
+        }
+        changed = true;
+        if (!applySinkPreferenceLocked(i))
+            broadcastDisplayState(state);
     }
-    // set oversan compensation and scaling type
-    status_t result = UNKNOWN_ERROR;
-    // Check the callback implementation
-    if (mMDSCallback != NULL) {
-        if (mScaleType != MDS_SCALING_NONE)
-            result = mMDSCallback->setHdmiScalingType(MDS_SCALING_NONE);
-        if (result == NO_ERROR &&
-                (mHorizontalStep != 0 || mVerticalStep != 0))
-            result = mMDSCallback->setHdmiOverscan(0, 0);
+    bool modeChanged = (mode != (android_atomic_acquire_load(&mMode) & hdmiMode));
+    if (!changed && !modeChanged) {
+        ALOGI("HDMI state is not changed, 0x%x", mMode);
+        return NO_ERROR;
     }
-    // If not implemented in callback, call SurfaceFlinger directly!
-    if (result != NO_ERROR) {
-        if (mScaleType != MDS_SCALING_NONE ||
-                mHorizontalStep != 0 || mVerticalStep != 0)
+
+    if (modeChanged)
+        broadcastModeChange(false);
+    if (swapped) {
+        // The audio reads the ELD of the new sink on a plug
+        ALOGI("HDMI sink is swapped");
+        drm_hdmi_notify_audio_hotplug(false);
+        drm_hdmi_notify_audio_hotplug(true);
+    } else if (modeChanged) {
+        drm_hdmi_notify_audio_hotplug(connected);
+    }
+    saveSnapshot();
+    return NO_ERROR;
+}
+
+status_t MultiDisplayComposer::resetScalingLocked(MultiDisplayState& state) {
+    // Only the display of the HDMI control has a scaling pipe,
+    // the others just forget the values.
+    status_t result = NO_ERROR;
+    if (&state == &hdmiState_l()) {
+        result = UNKNOWN_ERROR;
+        // Check the callback implementation
+        sp<IMultiDisplayCallback> cbk =
+            getCallback(MDS_CB_CAP_SCALING_TYPE | MDS_CB_CAP_OVERSCAN);
+        if (cbk != NULL) {
+            result = NO_ERROR;
+            if (state.scaleType != MDS_SCALING_NONE) {
+                MDS_LATENCY_SCOPE(sCbSetHdmiScalingType);
+                result = cbk->setHdmiScalingType(MDS_SCALING_NONE);
+                updateCallbackCap(cbk, MDS_CB_CAP_SCALING_TYPE, result);
+            }
+            if (result == NO_ERROR && (state.hStep != 0 || state.vStep != 0)) {
+                MDS_LATENCY_SCOPE(sCbSetHdmiOverscan);
+                result = cbk->setHdmiOverscan(0, 0);
+                updateCallbackCap(cbk, MDS_CB_CAP_OVERSCAN, result);
+            }
+        }
+        // If not implemented in callback, call SurfaceFlinger directly!
+        if (result != NO_ERROR)
             result = setDisplayScalingLocked(MDS_SCALING_NONE, 0, 0);
     }
 
     if (result == NO_ERROR) {
-        mScaleType = MDS_SCALING_NONE;
-        mHorizontalStep = 0;
-        mVerticalStep = 0;
+        RWLock::AutoWLock lock(mStateLock);
+        state.scaleType = MDS_SCALING_NONE;
+        state.hStep = 0;
+        state.vStep = 0;
     }
+    return result;
+}
 
-    return NO_ERROR;
+bool MultiDisplayComposer::applySinkPreferenceLocked(int index) {
+    MDS_TRACE_CALL();
+    MultiDisplayState& state = mExternal[index];
+    {
+        RWLock::AutoWLock lock(mStateLock);
+        state.timingSelected = false;
+    }
+    // A known sink comes up with its last settings in one config,
+    // only the display of the HDMI control has the scaling pipe.
+    uint8_t sink[DRM_HDMI_SINK_ID_LEN];
+    MultiDisplaySinkPreference pref;
+    if (state.isConnected() && &state == &hdmiState_l() &&
+            drm_hdmi_getSinkId(index, sink) &&
+            mSinkPreferences.find(sink, &pref)) {
+        MDSDisplayConfig config;
+        memset(&config, 0, sizeof(config));
+        config.fields    = MDS_CONFIG_SCALING | MDS_CONFIG_OVERSCAN;
+        config.scaling   = (MDS_SCALING_TYPE)pref.scaleType;
+        config.hOverscan = pref.hStep;
+        config.vOverscan = pref.vStep;
+        int timingIndex = -1;
+        if (pref.timingSelected && getCallback(0) != NULL) {
+            config.timing = pref.timing;
+            timingIndex = drm_hdmi_findTiming(index, &config.timing);
+            if (timingIndex >= 0)
+                config.fields |= MDS_CONFIG_TIMING;
+        }
+        if (commitDisplayConfigLocked(config, timingIndex) == NO_ERROR) {
+            ALOGI("Apply the preference of sink %d, 0x%x", index, config.fields);
+            return true;
+        }
+    }
+    // A new sink starts without scaling and overscan compensation
+    if (state.hasScaling())
+        resetScalingLocked(state);
+    return false;
+}
+
+void MultiDisplayComposer::saveSinkPreferenceLocked() {
+    uint8_t sink[DRM_HDMI_SINK_ID_LEN];
+    if (!mDrmInit || !drm_hdmi_getSinkId(mHdmiIndex, sink))
+        return;
+    const MultiDisplayState& hdmi = hdmiState_l();
+    MultiDisplaySinkPreference pref;
+    memset(&pref, 0, sizeof(pref));
+    pref.timingSelected = hdmi.timingSelected;
+    pref.timing    = hdmi.timing;
+    pref.scaleType = hdmi.scaleType;
+    pref.hStep     = hdmi.hStep;
+    pref.vStep     = hdmi.vStep;
+    mSinkPreferences.update(sink, pref);
 }
 
 status_t MultiDisplayComposer::updateVideoState(int sessionId, MDS_VIDEO_STATE state) {
-    Mutex::Autolock lock(mMutex);
-    status_t result = NO_ERROR;
+    mRecorder.record(MDS_REC_UPDATE_VIDEO_STATE, sessionId, state);
     //FIXME: Video user space driver works at different process,
     // When MDS receive a UNPREPARING or UNPREPARED state,
     // video driver may has been unloaded,
@@ -248,189 +1156,452 @@ status_t MultiDisplayComposer::updateVideoState(int sessionId, MDS_VIDEO_STATE s
     ALOGV("set Video Session [%d] state:%d", sessionId, state);
     // Check video session
     CHECK_VIDEO_SESSION_ID(sessionId, UNKNOWN_ERROR);
-    if (mVideos[sessionId].getState() == state) {
-        ALOGW("same video playback state %d for session %d", state, sessionId);
-        return NO_ERROR;
-    }
-
-    if (mVideos[sessionId].setState(state) != NO_ERROR) {
-        ALOGW("failed to update state %d for session %d", state, sessionId);
-        return UNKNOWN_ERROR;
+    // HWC sees the state changes in the order they are made
+    MDS_AUTOLOCK(mVideoNotifyLock);
+    bool changed = false;
+    bool playing = false;
+    // The binder of a closed session, unlinked out of mVideoLock
+    sp<IBinder> token;
+    nsecs_t leaseDeadline = 0;
+    {
+        MDS_AUTOLOCK(mVideoLock);
+        MultiDisplayVideoSession& session = mVideos[sessionId];
+        if (session.getState() == state) {
+            // An allocated session is given up before it is prepared
+            if (state == MDS_VIDEO_UNPREPARED && session.getToken() != NULL) {
+                token = session.getToken();
+                session.init();
+            }
+            ALOGW("same video playback state %d for session %d", state, sessionId);
+        } else if (session.setState(state) != NO_ERROR) {
+            ALOGW("failed to update state %d for session %d", state, sessionId);
+            return UNKNOWN_ERROR;
+        } else {
+            changed = true;
+            session.setOwner(IPCThreadState::self()->getCallingPid());
+            // Reset video session if player is closed
+            if (state >= MDS_VIDEO_UNPREPARED) {
+                token = session.getToken();
+                session.init();
+                ignoreVideoDriver = true;
+            } else if (state != MDS_VIDEO_PREPARED && mVideoLeaseMonitor != NULL &&
+                    mVideoLeaseMonitor->getLeaseTime() > 0) {
+                leaseDeadline = session.getStateTime() +
+                        mVideoLeaseMonitor->getLeaseTime();
+            }
+            playing = hasVideoPlaying_l();
+        }
     }
+    if (token != NULL)
+        token->unlinkToDeath(mVideoOwnerObserver);
+    if (!changed)
+        return NO_ERROR;
+    if (leaseDeadline != 0)
+        mVideoLeaseMonitor->schedule(leaseDeadline);
 
-    // Reset video session if player is closed
-    if (state >= MDS_VIDEO_UNPREPARED) {
-        mVideos[sessionId].init();
-        ignoreVideoDriver = true;
-    }
+    return notifyVideoState(sessionId, state, playing, ignoreVideoDriver);
+}
 
-    int mode = mMode;
-    if (hasVideoPlaying_l())
-        mMode |= MDS_VIDEO_ON;
+status_t MultiDisplayComposer::notifyVideoState(int sessionId,
+        MDS_VIDEO_STATE state, bool playing, bool ignoreVideoDriver) {
+    status_t result = NO_ERROR;
+    if (playing)
+        updateMode(MDS_VIDEO_ON, 0);
     else
-        mMode &= ~MDS_VIDEO_ON;
+        updateMode(0, MDS_VIDEO_ON);
 
-    if (mMDSCallback != NULL)
-        result = mMDSCallback->updateVideoState(sessionId, state);
-    if (mode != mMode) {
-        broadcastMessageLocked((int)MDS_MSG_MODE_CHANGE,
-                &mMode, sizeof(mMode), ignoreVideoDriver);
+    // HWC may query MDS from the callback, only mVideoNotifyLock is held
+    sp<IMultiDisplayCallback> cbk = getCallback(0);
+    if (cbk != NULL) {
+        MDS_LATENCY_SCOPE(sCbUpdateVideoState);
+        result = cbk->updateVideoState(sessionId, state);
     }
+    broadcastModeChange(ignoreVideoDriver);
+    saveSnapshot();
 
     return result;
 }
 
 MDS_VIDEO_STATE MultiDisplayComposer::getVideoState(int sessionId) {
-    Mutex::Autolock lock(mMutex);
     // Check video session
     CHECK_VIDEO_SESSION_ID(sessionId, MDS_VIDEO_STATE_UNKNOWN);
+    MDS_AUTOLOCK(mVideoLock);
     ALOGV("get Video Session [%d] state %d", sessionId, mVideos[sessionId].getState());
     return mVideos[sessionId].getState();
 }
 
 int MultiDisplayComposer::getVideoSessionNumber() {
-    //TODO: avoid deadlock issue in HWC
-    //Mutex::Autolock lock(mMutex);
+    // HWC calls it from the video state callback, which is made
+    // without mVideoLock
+    MDS_AUTOLOCK(mVideoLock);
     return getVideoSessionSize_l();
 }
 
 status_t MultiDisplayComposer::updateVideoSourceInfo(int sessionId, const MDSVideoSourceInfo& info) {
-    MDC_CHECK_INIT();
-    Mutex::Autolock lock(mMutex);
+    mRecorder.record(MDS_REC_UPDATE_VIDEO_SOURCE_INFO, sessionId, info);
+    {
+        RWLock::AutoRLock lock(mStateLock);
+        MDC_CHECK_INIT();
+    }
     ALOGV("mode[0x%x]protected[%d]w[%d]h[%d]fps[%d]interlace[%d]",
         mMode, info.isProtected, info.displayW,
         info.displayH, info.frameRate, info.isInterlaced);
 
     // Check video session
     CHECK_VIDEO_SESSION_ID(sessionId, UNKNOWN_ERROR);
-    if (mVideos[sessionId].setInfo(info) != NO_ERROR)
-        return UNKNOWN_ERROR;
-    dumpVideoSession_l();
+    {
+        MDS_AUTOLOCK(mVideoLock);
+        if (mVideos[sessionId].setInfo(info) != NO_ERROR)
+            return UNKNOWN_ERROR;
+        dumpVideoSession_l();
+    }
+    saveSnapshot();
     return NO_ERROR;
 }
 
 status_t MultiDisplayComposer::getVideoSourceInfo(int sessionId, MDSVideoSourceInfo *info) {
     if (info == NULL)
         return BAD_VALUE;
-    Mutex::Autolock lock(mMutex);
     // Check video session
     CHECK_VIDEO_SESSION_ID(sessionId, UNKNOWN_ERROR);
+    MDS_AUTOLOCK(mVideoLock);
     if (mVideos[sessionId].getState() != MDS_VIDEO_PREPARED)
         return UNKNOWN_ERROR;
     return mVideos[sessionId].getInfo(info);
 }
 
 status_t MultiDisplayComposer::updatePhoneCallState(bool blank) {
-    Mutex::Autolock lock(mMutex);
+    mRecorder.record(MDS_REC_UPDATE_PHONE_CALL_STATE, blank);
     ALOGV("the phone call state : %d", blank);
-    if (mMDSCallback == NULL)
+    sp<IMultiDisplayCallback> cbk = getCallback(0);
+    if (cbk == NULL)
         return NO_INIT;
-    return mMDSCallback->blankSecondaryDisplay(blank);
+    MDS_LATENCY_SCOPE(sCbBlankSecondaryDisplay);
+    return cbk->blankSecondaryDisplay(blank);
 }
 
 status_t MultiDisplayComposer::updateInputState(bool state) {
-    Mutex::Autolock lock(mMutex);
+    mRecorder.record(MDS_REC_UPDATE_INPUT_STATE, state);
     ALOGV("the input state:%d", state);
-    if (mMDSCallback == NULL)
+    sp<IMultiDisplayCallback> cbk = getCallback(0);
+    if (cbk == NULL)
+        return NO_INIT;
+    MDS_LATENCY_SCOPE(sCbUpdateInputState);
+    return cbk->updateInputState(state);
+}
+
+status_t MultiDisplayComposer::notifyInputActivity() {
+    mRecorder.record(MDS_REC_NOTIFY_INPUT_ACTIVITY);
+    if (mInputMonitor == NULL)
         return NO_INIT;
-    return mMDSCallback->updateInputState(state);
+    mInputMonitor->notifyActivity();
+    return NO_ERROR;
 }
 
 status_t MultiDisplayComposer::setHdmiTiming(const MDSHdmiTiming& timing) {
-    Mutex::Autolock lock(mMutex);
+    mRecorder.record(MDS_REC_SET_HDMI_TIMING, timing);
+    MDS_AUTOLOCK(mDisplayLock);
+    MDC_CHECK_INIT();
 
-    if (mMDSCallback == NULL)
+    sp<IMultiDisplayCallback> cbk = getCallback(0);
+    if (cbk == NULL)
         return NO_INIT;
     MDSHdmiTiming real;
     memcpy(&real, &timing, sizeof(MDSHdmiTiming));
-    if (!drm_hdmi_checkTiming(&real))
+    if (!drm_hdmi_checkTiming(mHdmiIndex, &real))
         return UNKNOWN_ERROR;
 
-    return mMDSCallback->setHdmiTiming(real);
+    status_t result = NO_ERROR;
+    {
+        MDS_LATENCY_SCOPE(sCbSetHdmiTiming);
+        result = cbk->setHdmiTiming(real);
+    }
+    if (result == NO_ERROR) {
+        {
+            RWLock::AutoWLock stateLock(mStateLock);
+            hdmiState_l().timingSelected = true;
+            hdmiState_l().timing = real;
+        }
+        saveSinkPreferenceLocked();
+        saveSnapshot();
+    }
+    return result;
 }
 
 int MultiDisplayComposer::getHdmiTimingCount() {
-    Mutex::Autolock lock(mMutex);
+    // The timing count is cached by the probe, no DRM access here
+    RWLock::AutoRLock lock(mStateLock);
+    if (!mDrmInit)
+        return 0;
 
-    return drm_hdmi_getTimingNumber();
+    return hdmiState_l().timingCount;
 }
 
 status_t MultiDisplayComposer::getHdmiTimingList(
         int count, MDSHdmiTiming **list) {
-    Mutex::Autolock lock(mMutex);
-    bool ret = drm_hdmi_getTimings(count, list);
+    MDS_AUTOLOCK(mDisplayLock);
+    MDC_CHECK_INIT();
+    bool ret = drm_hdmi_getTimings(mHdmiIndex, count, list);
     return (ret == false ? UNKNOWN_ERROR : NO_ERROR);
 }
 
+int MultiDisplayComposer::getHdmiTimings(MDSHdmiTiming* list, int max) {
+    MDS_AUTOLOCK(mDisplayLock);
+    if (!mDrmInit)
+        return 0;
+    return drm_hdmi_getTimingList(mHdmiIndex, list, max);
+}
+
 status_t MultiDisplayComposer::getCurrentHdmiTiming(MDSHdmiTiming* timing) {
-    Mutex::Autolock lock(mMutex);
+    MDS_AUTOLOCK(mDisplayLock);
 
     return NO_ERROR;
 }
 
 status_t MultiDisplayComposer::setHdmiTimingByIndex(int index) {
-    Mutex::Autolock lock(mMutex);
+    mRecorder.record(MDS_REC_SET_HDMI_TIMING_BY_INDEX, index);
+    MDS_AUTOLOCK(mDisplayLock);
 
     return NO_ERROR;
 }
 
 int MultiDisplayComposer::getCurrentHdmiTimingIndex() {
-    Mutex::Autolock lock(mMutex);
+    MDS_AUTOLOCK(mDisplayLock);
     return 0;
 }
 
 status_t MultiDisplayComposer::setHdmiScalingType(MDS_SCALING_TYPE type) {
+    mRecorder.record(MDS_REC_SET_HDMI_SCALING_TYPE, type);
     ALOGV("set scaling type:%d", type);
-    Mutex::Autolock lock(mMutex);
+    MDS_AUTOLOCK(mDisplayLock);
+    status_t result = setHdmiScalingTypeLocked(type);
+    if (result == NO_ERROR) {
+        saveSinkPreferenceLocked();
+        saveSnapshot();
+    }
+    return result;
+}
+
+status_t MultiDisplayComposer::setHdmiScalingTypeLocked(MDS_SCALING_TYPE type) {
+    MultiDisplayState& hdmi = hdmiState_l();
     status_t result = UNKNOWN_ERROR;
     // Check the callback implementation
-    if (mMDSCallback != NULL)
-        result = mMDSCallback->setHdmiScalingType(type);
+    sp<IMultiDisplayCallback> cbk = getCallback(MDS_CB_CAP_SCALING_TYPE);
+    if (cbk != NULL) {
+        MDS_LATENCY_SCOPE(sCbSetHdmiScalingType);
+        result = cbk->setHdmiScalingType(type);
+        updateCallbackCap(cbk, MDS_CB_CAP_SCALING_TYPE, result);
+    }
 
     // If not implemented in callback, call SurfaceFlinger directly!
     if (result != NO_ERROR)
         result = setDisplayScalingLocked((uint32_t)type,
-            mHorizontalStep, mVerticalStep);
+            hdmi.hStep, hdmi.vStep);
 
-    if (result == NO_ERROR)
-        mScaleType = type;
+    if (result == NO_ERROR) {
+        {
+            RWLock::AutoWLock lock(mStateLock);
+            hdmi.scaleType = type;
+        }
+        broadcastDisplayState(hdmi);
+    }
 
     return result;
 }
 
 status_t MultiDisplayComposer::setHdmiOverscan(int hVal, int vVal) {
-    Mutex::Autolock lock(mMutex);
-    status_t result = UNKNOWN_ERROR;
+    mRecorder.record(MDS_REC_SET_HDMI_OVERSCAN, hVal, vVal);
+    MDS_AUTOLOCK(mDisplayLock);
     hVal = (hVal > overscan_max) ? 0: (overscan_max - hVal);
     vVal = (vVal > overscan_max) ? 0: (overscan_max - vVal);
     ALOGV("set overscan, h_val:%d, v_val:%d", hVal, vVal);
+    status_t result = setHdmiOverscanLocked(hVal, vVal);
+    if (result == NO_ERROR) {
+        saveSinkPreferenceLocked();
+        saveSnapshot();
+    }
+    return result;
+}
+
+status_t MultiDisplayComposer::setHdmiOverscanLocked(int hStep, int vStep) {
+    MultiDisplayState& hdmi = hdmiState_l();
+    status_t result = UNKNOWN_ERROR;
     // Check the callback implementation
-    if (mMDSCallback != NULL)
-        result = mMDSCallback->setHdmiOverscan(hVal, vVal);
+    sp<IMultiDisplayCallback> cbk = getCallback(MDS_CB_CAP_OVERSCAN);
+    if (cbk != NULL) {
+        MDS_LATENCY_SCOPE(sCbSetHdmiOverscan);
+        result = cbk->setHdmiOverscan(hStep, vStep);
+        updateCallbackCap(cbk, MDS_CB_CAP_OVERSCAN, result);
+    }
 
     // If not implemented in callback, call SurfaceFlinger directly!
     if (result != NO_ERROR)
         result = setDisplayScalingLocked(
-                (uint32_t)mScaleType, hVal, vVal);
+                (uint32_t)hdmi.scaleType, hStep, vStep);
 
     if (result == NO_ERROR) {
-        mHorizontalStep = hVal;
-        mVerticalStep = vVal;
+        {
+            RWLock::AutoWLock lock(mStateLock);
+            hdmi.hStep = hStep;
+            hdmi.vStep = vStep;
+        }
+        broadcastDisplayState(hdmi);
     }
     return result;
 }
 
-MDS_DISPLAY_MODE MultiDisplayComposer::getDisplayMode(bool wait) {
-    if (wait) {
-        mMutex.lock();
+status_t MultiDisplayComposer::applyDisplayConfig(const MDSDisplayConfig& config) {
+    mRecorder.record(MDS_REC_APPLY_DISPLAY_CONFIG, config);
+    MDS_AUTOLOCK(mDisplayLock);
+    MultiDisplayState& hdmi = hdmiState_l();
+    ALOGV("apply display config 0x%x", config.fields);
+
+    // Validate the whole set before anything reaches the display
+    const uint32_t allFields =
+        MDS_CONFIG_TIMING | MDS_CONFIG_SCALING | MDS_CONFIG_OVERSCAN;
+    if (config.fields == 0 || (config.fields & ~allFields) != 0)
+        return BAD_VALUE;
+
+    MDSDisplayConfig real;
+    memcpy(&real, &config, sizeof(MDSDisplayConfig));
+    int timingIndex = -1;
+    if (config.fields & MDS_CONFIG_TIMING) {
+        MDC_CHECK_INIT();
+        if (getCallback(0) == NULL)
+            return NO_INIT;
+        timingIndex = drm_hdmi_findTiming(mHdmiIndex, &real.timing);
+        if (timingIndex < 0)
+            return BAD_VALUE;
+    }
+    if (config.fields & MDS_CONFIG_SCALING) {
+        if (config.scaling < MDS_SCALING_NONE ||
+                config.scaling > MDS_SCALING_ASPECT)
+            return BAD_VALUE;
     } else {
-        if (mMutex.tryLock() == -EBUSY) {
-            return MDS_MODE_NONE;
+        real.scaling = hdmi.scaleType;
+    }
+    if (config.fields & MDS_CONFIG_OVERSCAN) {
+        if (config.hOverscan < 0 || config.hOverscan > overscan_max ||
+                config.vOverscan < 0 || config.vOverscan > overscan_max)
+            return BAD_VALUE;
+        real.hOverscan = overscan_max - config.hOverscan;
+        real.vOverscan = overscan_max - config.vOverscan;
+    } else {
+        real.hOverscan = hdmi.hStep;
+        real.vOverscan = hdmi.vStep;
+    }
+
+    status_t result = commitDisplayConfigLocked(real, timingIndex);
+    if (result != NO_ERROR)
+        return result;
+    saveSinkPreferenceLocked();
+    saveSnapshot();
+    return NO_ERROR;
+}
+
+status_t MultiDisplayComposer::commitDisplayConfigLocked(
+        const MDSDisplayConfig& config, int timingIndex) {
+    MDS_TRACE_CALL();
+    MultiDisplayState& hdmi = hdmiState_l();
+    // Push the whole set to HWC at once
+    status_t result = INVALID_OPERATION;
+    sp<IMultiDisplayCallback> cbk = getCallback(MDS_CB_CAP_DISPLAY_CONFIG);
+    if (cbk != NULL) {
+        MDS_LATENCY_SCOPE(sCbSetDisplayConfig);
+        result = cbk->setDisplayConfig(config);
+        updateCallbackCap(cbk, MDS_CB_CAP_DISPLAY_CONFIG, result);
+    }
+    if (result == INVALID_OPERATION || result == UNKNOWN_TRANSACTION)
+        result = applyDisplayConfigLocked(config);
+    if (result != NO_ERROR) {
+        ALOGE("Fail to apply display config 0x%x, %d", config.fields, result);
+        return result;
+    }
+
+    if (timingIndex >= 0)
+        drm_hdmi_selectTiming(mHdmiIndex, timingIndex);
+    {
+        RWLock::AutoWLock stateLock(mStateLock);
+        if (timingIndex >= 0) {
+            hdmi.timingSelected = true;
+            hdmi.timing = config.timing;
+        }
+        hdmi.scaleType = config.scaling;
+        hdmi.hStep = config.hOverscan;
+        hdmi.vStep = config.vOverscan;
+    }
+    broadcastDisplayState(hdmi);
+    return NO_ERROR;
+}
+
+status_t MultiDisplayComposer::applyDisplayConfigLocked(const MDSDisplayConfig& config) {
+    // HWC doesn't support the combined callback, apply the fields one by one.
+    // The timing can't be reverted, so it is applied at last, and the
+    // committed scaling is restored if it fails.
+    MultiDisplayState& hdmi = hdmiState_l();
+    status_t result = NO_ERROR;
+
+    if (config.fields & (MDS_CONFIG_SCALING | MDS_CONFIG_OVERSCAN)) {
+        uint32_t caps = 0;
+        if (config.fields & MDS_CONFIG_SCALING)
+            caps |= MDS_CB_CAP_SCALING_TYPE;
+        if (config.fields & MDS_CONFIG_OVERSCAN)
+            caps |= MDS_CB_CAP_OVERSCAN;
+        sp<IMultiDisplayCallback> cbk = getCallback(caps);
+        bool useCallback = (cbk != NULL);
+        if (useCallback) {
+            if (config.fields & MDS_CONFIG_SCALING) {
+                MDS_LATENCY_SCOPE(sCbSetHdmiScalingType);
+                result = cbk->setHdmiScalingType(config.scaling);
+                updateCallbackCap(cbk, MDS_CB_CAP_SCALING_TYPE, result);
+            }
+            if (result == NO_ERROR && (config.fields & MDS_CONFIG_OVERSCAN)) {
+                MDS_LATENCY_SCOPE(sCbSetHdmiOverscan);
+                result = cbk->setHdmiOverscan(
+                        config.hOverscan, config.vOverscan);
+                updateCallbackCap(cbk, MDS_CB_CAP_OVERSCAN, result);
+            }
+        }
+        // If not implemented in callback, call SurfaceFlinger directly!
+        // It takes scaling type and overscan in one transaction.
+        if (!useCallback || result != NO_ERROR)
+            result = setDisplayScalingLocked((uint32_t)config.scaling,
+                    config.hOverscan, config.vOverscan);
+        if (result != NO_ERROR)
+            return result;
+    }
+
+    if (config.fields & MDS_CONFIG_TIMING) {
+        sp<IMultiDisplayCallback> cbk = getCallback(0);
+        result = NO_INIT;
+        if (cbk != NULL) {
+            MDS_LATENCY_SCOPE(sCbSetHdmiTiming);
+            result = cbk->setHdmiTiming(config.timing);
+        }
+        if (result != NO_ERROR &&
+                (config.fields & (MDS_CONFIG_SCALING | MDS_CONFIG_OVERSCAN))) {
+            setHdmiScalingTypeLocked(hdmi.scaleType);
+            setHdmiOverscanLocked(hdmi.hStep, hdmi.vStep);
         }
     }
-    ALOGV("Mode is 0x%x, %d", mMode, wait);
-    MDS_DISPLAY_MODE mode = (MDS_DISPLAY_MODE)mMode;
-    mMutex.unlock();
+    return result;
+}
+
+MDS_DISPLAY_MODE MultiDisplayComposer::getDisplayMode(bool wait) {
+    // The mode is updated atomically, the caller never waits
+    // for a hotplug probe, so "wait" doesn't matter now.
+    MDS_DISPLAY_MODE mode =
+        (MDS_DISPLAY_MODE)android_atomic_acquire_load(&mMode);
+    ALOGV("Mode is 0x%x, %d", mode, wait);
+    return mode;
+}
+
+int MultiDisplayComposer::updateMode(int set, int clear) {
+    int32_t mode;
+    do {
+        mode = android_atomic_acquire_load(&mMode);
+    } while (android_atomic_release_cas(mode, (mode & ~clear) | set, &mMode) != 0);
+    MDS_TRACE_INT("MDS mode", (mode & ~clear) | set);
     return mode;
 }
 
@@ -442,73 +1613,103 @@ int32_t MultiDisplayComposer::registerListener(
         ALOGE("Fail to register a new listener");
         return -1;
     }
-    Mutex::Autolock _l(mMutex);
-    if (mListeners.size() >= MDS_LISTENER_MAX_VALUE ||
-            mListenerId >= MDS_LISTENER_MAX_VALUE) {
-        ALOGE("Up to the maximum of listener %d", MDS_LISTENER_MAX_VALUE);
-        return -1;
-    }
-    int32_t newId = mListenerId;
-    for (size_t i = 0; i < mListeners.size(); i++) {
-        if (mListeners.keyAt(i) == newId) {
-            ALOGE("The listener %p is already registered!", listener.get());
+    int32_t newId = -1;
+    {
+        MDS_AUTOLOCK(mListenerLock);
+        newId = allocateListenerId_l();
+        if (newId < 0) {
+            ALOGE("Up to the maximum of listener %d", MDS_LISTENER_MAX_VALUE);
             return -1;
         }
+        MultiDisplayListener* plistener =
+            new MultiDisplayListener(msg, newId, name, listener);
+        plistener->dump();
+        int32_t slot = newId & LISTENER_SLOT_MASK;
+        mListeners[slot] = plistener;
+        mListenerBitmap |= (1ULL << slot);
+        mListenerCount++;
     }
-    MultiDisplayListener* plistener =
-        new MultiDisplayListener(msg, newId, name, listener);
-    plistener->dump();
-    mListeners.add(newId, plistener);
-    mListenerId++;
-    // Find a valid Id
-    if (mListenerId >= MDS_LISTENER_MAX_VALUE) {
-        mListenerId = 0;
-        for (; mListenerId < MDS_LISTENER_MAX_VALUE; mListenerId++) {
-            bool used = false;
-            for (size_t i = 0; i < mListeners.size(); i++) {
-                if (mListeners.keyAt(i) == mListenerId) {
-                    used = true;
-                    break;
-                }
-            }
-            if (!used) break;
-        }
-        ALOGV("The next valid listener Id: %d", mListenerId);
+    // Linked once it is in the table, so a death is never missed.
+    // A listener of this process never dies alone
+    if (listener->asBinder()->linkToDeath(mClientObserver) == DEAD_OBJECT) {
+        ALOGW("The listener %s is dead", name);
+        onClientDied(listener->asBinder());
+        return -1;
     }
+    // The id is recorded, a replay maps the later calls with it
+    mRecorder.record(MDS_REC_REGISTER_LISTENER, name, msg, newId);
     return newId;
 }
 
+int32_t MultiDisplayComposer::allocateListenerId_l() {
+    if (mListenerCount >= MDS_LISTENER_MAX_VALUE)
+        return -1;
+    // The lowest zero bit
+    int32_t slot = __builtin_ctzll(~mListenerBitmap);
+    uint32_t generation =
+        (mListenerGenerations[slot] + 1) & LISTENER_GENERATION_MASK;
+    mListenerGenerations[slot] = generation;
+    return (int32_t)(generation << LISTENER_SLOT_BITS) | slot;
+}
+
+sp<IBinder> MultiDisplayComposer::removeListener_l(int32_t slot) {
+    MultiDisplayListener* listener = mListeners[slot];
+    mListeners[slot] = NULL;
+    mListenerBitmap &= ~(1ULL << slot);
+    mListenerCount--;
+    sp<IBinder> binder = listener->getListener()->asBinder();
+    delete listener;
+    return binder;
+}
+
 status_t MultiDisplayComposer::unregisterListener(int32_t listenerId) {
-    Mutex::Autolock _l(mMutex);
-    if (listenerId < 0) {
+    mRecorder.record(MDS_REC_UNREGISTER_LISTENER, listenerId);
+    int32_t slot = listenerId & LISTENER_SLOT_MASK;
+    if (listenerId < 0 || slot >= MDS_LISTENER_MAX_VALUE) {
         ALOGE("Error listener ID");
         return BAD_VALUE;
     }
-    for (size_t i = 0; i < mListeners.size(); i++) {
-        if (mListeners.keyAt(i) != listenerId)
-            continue;
-        MultiDisplayListener* listener = mListeners.valueAt(i);
-        if (listener == NULL)
-            continue;
+    sp<IBinder> binder;
+    {
+        MDS_AUTOLOCK(mListenerLock);
+        // The slot may be taken by another listener since
+        if (mListeners[slot] == NULL || mListeners[slot]->getId() != listenerId)
+            return NO_ERROR;
         ALOGV("Find a matched listener to unregister:\n");
-        listener->dump();
-        mListeners.removeItem(listenerId);
-        delete listener;
-        listener = NULL;
-        break;
+        mListeners[slot]->dump();
+        binder = removeListener_l(slot);
     }
+    binder->unlinkToDeath(mClientObserver);
     return NO_ERROR;
 }
 
-void MultiDisplayComposer::broadcastMessageLocked(
+void MultiDisplayComposer::broadcastMessage(
         int msg, void* value, int size, bool ignoreVideoDriver) {
-    if (mListeners.size() == 0)
+    MDS_AUTOLOCK(mListenerLock);
+    broadcastMessage_l(msg, value, size, ignoreVideoDriver);
+}
+
+void MultiDisplayComposer::broadcastModeChange(bool ignoreVideoDriver) {
+    MDS_AUTOLOCK(mListenerLock);
+    // The mode may be sent by another thread already
+    int32_t mode = android_atomic_acquire_load(&mMode);
+    if (mode == mBroadcastMode)
         return;
+    mBroadcastMode = mode;
+    broadcastMessage_l((int)MDS_MSG_MODE_CHANGE, &mode, sizeof(mode), ignoreVideoDriver);
+}
 
-    for (size_t index = 0; index < mListeners.size(); index++) {
-        MultiDisplayListener* listener = mListeners.valueAt(index);
-        if (listener == NULL)
-            continue;
+void MultiDisplayComposer::broadcastMessage_l(
+        int msg, void* value, int size, bool ignoreVideoDriver) {
+    MDS_TRACE_CALL();
+    if (mListenerBitmap == 0)
+        return;
+
+    // In the order of the slots
+    uint64_t dead = 0;
+    for (uint64_t bits = mListenerBitmap; bits != 0; bits &= bits - 1) {
+        int32_t slot = __builtin_ctzll(bits);
+        MultiDisplayListener* listener = mListeners[slot];
         listener->dump();
         const char* name = listener->getName();
         if (ignoreVideoDriver && name != NULL &&
@@ -518,21 +1719,60 @@ void MultiDisplayComposer::broadcastMessageLocked(
         }
         if (listener->checkMsg(msg)) {
             sp<IMultiDisplayListener> ielistener = listener->getListener();
-            if (ielistener != NULL)
-                ielistener->onMdsMessage(msg, value, size);
+            if (ielistener != NULL) {
+                MDS_LATENCY_SCOPE(sListenerOnMdsMessage);
+                if (ielistener->onMdsMessage(msg, value, size) == DEAD_OBJECT)
+                    dead |= (1ULL << slot);
+            }
         }
     }
+    // The death notification may come later, don't call them again
+    for (; dead != 0; dead &= dead - 1) {
+        int32_t slot = __builtin_ctzll(dead);
+        int32_t id = mListeners[slot]->getId();
+        ALOGW("Remove the dead listener %d", id);
+        mRecorder.record(MDS_REC_UNREGISTER_LISTENER, id);
+        removeListener_l(slot);
+    }
+}
+
+void MultiDisplayComposer::onClientDied(const wp<IBinder>& who) {
+    {
+        MDS_AUTOLOCK(mCallbackLock);
+        if (mMDSCallback != NULL &&
+                mMDSCallback->asBinder().get() == who.unsafe_get()) {
+            ALOGW("The callback died");
+            mRecorder.record(MDS_REC_UNREGISTER_CALLBACK);
+            mMDSCallback = NULL;
+            mCallbackCaps = 0;
+        }
+    }
+    // A listener may be registered more than once
+    MDS_AUTOLOCK(mListenerLock);
+    for (uint64_t bits = mListenerBitmap; bits != 0; bits &= bits - 1) {
+        int32_t slot = __builtin_ctzll(bits);
+        MultiDisplayListener* listener = mListeners[slot];
+        if (listener->getListener()->asBinder().get() != who.unsafe_get())
+            continue;
+        ALOGW("The listener %d %s died", listener->getId(), listener->getName());
+        mRecorder.record(MDS_REC_UNREGISTER_LISTENER, listener->getId());
+        removeListener_l(slot);
+    }
 }
 
 status_t MultiDisplayComposer::setDisplayScalingLocked(uint32_t mode,
          uint32_t stepx, uint32_t stepy) {
+    // The binder is cached until SurfaceFlinger dies
     if (mSurfaceComposer == NULL) {
         const sp<IServiceManager> sm = defaultServiceManager();
         const String16 name("SurfaceFlinger");
-        mSurfaceComposer = sm->getService(name);
-        if (mSurfaceComposer == NULL) {
+        sp<IBinder> binder = sm->getService(name);
+        if (binder == NULL) {
             return UNKNOWN_ERROR;
         }
+        if (binder->linkToDeath(mSurfaceComposerObserver) != NO_ERROR)
+            ALOGW("Fail to watch SurfaceFlinger");
+        mSurfaceComposer = binder;
     }
 
     uint32_t scale;
@@ -542,10 +1782,20 @@ status_t MultiDisplayComposer::setDisplayScalingLocked(uint32_t mode,
     scale = mode | stepx << 16 | stepy << 24;
     data.writeInterfaceToken(token);
     data.writeInt32(scale);
-    mSurfaceComposer->transact(SFIntelHDMIScalingSetting, data, &reply);
+    status_t err = mSurfaceComposer->transact(SFIntelHDMIScalingSetting, data, &reply);
+    if (err != NO_ERROR)
+        return err;
     return reply.readInt32();
 }
 
+void MultiDisplayComposer::onSurfaceComposerDied(const wp<IBinder>& who) {
+    MDS_AUTOLOCK(mDisplayLock);
+    if (mSurfaceComposer != NULL && mSurfaceComposer.get() == who.unsafe_get()) {
+        ALOGW("SurfaceFlinger died");
+        mSurfaceComposer = NULL;
+    }
+}
+
 int MultiDisplayComposer::getVideoSessionSize_l() {
     int size = 0;
     for (int i = 0; i < MDS_VIDEO_SESSION_MAX_VALUE; i++) {
@@ -557,9 +1807,11 @@ int MultiDisplayComposer::getVideoSessionSize_l() {
 }
 
 int MultiDisplayComposer::allocateVideoSessionId() {
-    Mutex::Autolock lock(mMutex);
+    mRecorder.record(MDS_REC_ALLOCATE_VIDEO_SESSION_ID);
+    MDS_AUTOLOCK(mVideoLock);
     for (int i = 0; i < MDS_VIDEO_SESSION_MAX_VALUE; i++) {
-        if (mVideos[i].getState() == MDS_VIDEO_UNPREPARED) {
+        if (mVideos[i].getState() == MDS_VIDEO_UNPREPARED &&
+                mVideos[i].getToken() == NULL) {
             ALOGV("Allocate a new Video Session ID %d", i);
             return i;
         }
@@ -569,6 +1821,40 @@ int MultiDisplayComposer::allocateVideoSessionId() {
     return -1;
 }
 
+int MultiDisplayComposer::allocateVideoSession(const sp<IBinder>& token) {
+    if (token == NULL)
+        return allocateVideoSessionId();
+    // A replay has no player binder, it allocates an unowned session
+    mRecorder.record(MDS_REC_ALLOCATE_VIDEO_SESSION_ID);
+    int sessionId = -1;
+    {
+        // The session is reserved till the player closes it or dies
+        MDS_AUTOLOCK(mVideoLock);
+        for (int i = 0; i < MDS_VIDEO_SESSION_MAX_VALUE; i++) {
+            if (mVideos[i].getState() == MDS_VIDEO_UNPREPARED &&
+                    mVideos[i].getToken() == NULL) {
+                mVideos[i].setToken(token);
+                sessionId = i;
+                break;
+            }
+        }
+    }
+    if (sessionId < 0) {
+        ALOGE("Fail to allocate session ID");
+        return -1;
+    }
+    // A binder of this process never dies alone
+    status_t err = token->linkToDeath(mVideoOwnerObserver);
+    if (err != NO_ERROR && err != INVALID_OPERATION)
+        ALOGW("Fail to watch the player of session %d, %d", sessionId, err);
+    if (err == DEAD_OBJECT) {
+        releaseVideoSession(sessionId, token.get(), 0, "is dead");
+        return -1;
+    }
+    ALOGV("Allocate a new Video Session ID %d, owned by %p", sessionId, token.get());
+    return sessionId;
+}
+
 void MultiDisplayComposer::initVideoSessions_l() {
     for (int i = 0; i < MDS_VIDEO_SESSION_MAX_VALUE; i++) {
         mVideos[i].init();
@@ -576,24 +1862,136 @@ void MultiDisplayComposer::initVideoSessions_l() {
 }
 
 status_t MultiDisplayComposer::resetVideoPlayback() {
-    Mutex::Autolock lock(mMutex);
-    if (getVideoSessionSize_l() <= 0)
-        return NO_ERROR;
+    mRecorder.record(MDS_REC_RESET_VIDEO_PLAYBACK);
+    MDS_AUTOLOCK(mVideoNotifyLock);
+    Vector<sp<IBinder> > tokens;
+    {
+        MDS_AUTOLOCK(mVideoLock);
+        for (int i = 0; i < MDS_VIDEO_SESSION_MAX_VALUE; i++) {
+            if (mVideos[i].getToken() != NULL)
+                tokens.add(mVideos[i].getToken());
+        }
+        if (getVideoSessionSize_l() <= 0 && tokens.isEmpty())
+            return NO_ERROR;
 
-    // TODO: for each video session, send MDS_VIDEO_UNPREPARED
-    initVideoSessions_l();
+        // TODO: for each video session, send MDS_VIDEO_UNPREPARED
+        initVideoSessions_l();
+    }
+    for (size_t i = 0; i < tokens.size(); i++)
+        tokens[i]->unlinkToDeath(mVideoOwnerObserver);
 
-    if (mMDSCallback != NULL) {
-        mMDSCallback->updateVideoState(-1, MDS_VIDEO_UNPREPARED);
+    sp<IMultiDisplayCallback> cbk = getCallback(0);
+    if (cbk != NULL) {
+        MDS_LATENCY_SCOPE(sCbUpdateVideoState);
+        cbk->updateVideoState(-1, MDS_VIDEO_UNPREPARED);
     }
 
     // exit extended mode
-    mMode &= ~MDS_VIDEO_ON;
-    broadcastMessageLocked((int)MDS_MSG_MODE_CHANGE, &mMode, sizeof(mMode), false);
+    updateMode(0, MDS_VIDEO_ON);
+    broadcastModeChange(false);
+    saveSnapshot();
 
     return NO_ERROR;
 }
 
+void MultiDisplayComposer::releaseVideoSession(
+        int sessionId, IBinder* owner, nsecs_t stateTime, const char* reason) {
+    MDS_AUTOLOCK(mVideoNotifyLock);
+    sp<IBinder> token;
+    bool playing = false;
+    {
+        MDS_AUTOLOCK(mVideoLock);
+        MultiDisplayVideoSession& session = mVideos[sessionId];
+        if (owner != NULL && session.getToken().get() != owner)
+            return;
+        if (stateTime != 0 && session.getStateTime() != stateTime)
+            return;
+        MDS_VIDEO_STATE state = session.getState();
+        pid_t pid = session.getOwner();
+        token = session.getToken();
+        session.init();
+        // Only allocated, nothing is sent out for it
+        if (state == MDS_VIDEO_UNPREPARED)
+            return;
+        ALOGW("Release video session %d in state %d, its player %d %s",
+                sessionId, state, pid, reason);
+        playing = hasVideoPlaying_l();
+    }
+    if (token != NULL && owner == NULL)
+        token->unlinkToDeath(mVideoOwnerObserver);
+    // A replay sees the release as a call of the player
+    mRecorder.record(MDS_REC_UPDATE_VIDEO_STATE, sessionId, MDS_VIDEO_UNPREPARED);
+    notifyVideoState(sessionId, MDS_VIDEO_UNPREPARED, playing, true);
+}
+
+void MultiDisplayComposer::onVideoOwnerDied(const wp<IBinder>& who) {
+    // The binder is dead, its death link is gone with it
+    for (int i = 0; i < MDS_VIDEO_SESSION_MAX_VALUE; i++)
+        releaseVideoSession(i, who.unsafe_get(), 0, "is dead");
+}
+
+void MultiDisplayComposer::expireVideoSessions() {
+    if (mVideoLeaseMonitor == NULL)
+        return;
+    nsecs_t lease = mVideoLeaseMonitor->getLeaseTime();
+    nsecs_t period = ms2ns(MultiDisplayVideoLeaseMonitor::OWNER_CHECK_PERIOD_MS);
+    nsecs_t next = 0;
+    int expired[MDS_VIDEO_SESSION_MAX_VALUE];
+    nsecs_t stateTimes[MDS_VIDEO_SESSION_MAX_VALUE];
+    const char* reasons[MDS_VIDEO_SESSION_MAX_VALUE];
+    int count = 0;
+    {
+        MDS_AUTOLOCK(mVideoLock);
+        nsecs_t now = systemTime();
+        for (int i = 0; i < MDS_VIDEO_SESSION_MAX_VALUE; i++) {
+            MDS_VIDEO_STATE state = mVideos[i].getState();
+            if (state == MDS_VIDEO_UNPREPARED)
+                continue;
+            const char* reason = NULL;
+            nsecs_t deadline = 0;
+            if (mVideos[i].isRestored()) {
+                if (!isOwnerAlive(mVideos[i].getOwner(),
+                            mVideos[i].getOwnerStartTime()))
+                    reason = "is gone";
+                else
+                    deadline = now + period;
+            }
+            if (reason == NULL && lease > 0 &&
+                    (state == MDS_VIDEO_PREPARING || state == MDS_VIDEO_UNPREPARING)) {
+                nsecs_t leaseDeadline = mVideos[i].getStateTime() + lease;
+                if (now >= leaseDeadline)
+                    reason = "is stuck";
+                else if (deadline == 0 || leaseDeadline < deadline)
+                    deadline = leaseDeadline;
+            }
+            if (reason != NULL) {
+                expired[count] = i;
+                stateTimes[count] = mVideos[i].getStateTime();
+                reasons[count] = reason;
+                count++;
+            } else if (deadline != 0 && (next == 0 || deadline < next)) {
+                next = deadline;
+            }
+        }
+    }
+    if (next != 0)
+        mVideoLeaseMonitor->schedule(next);
+    // A session changed since then has a new lease
+    for (int i = 0; i < count; i++)
+        releaseVideoSession(expired[i], NULL, stateTimes[i], reasons[i]);
+}
+
+void MultiDisplayComposer::getVideoStates(MDS_VIDEO_STATE* states) {
+    MDS_AUTOLOCK(mVideoLock);
+    for (int i = 0; i < MDS_VIDEO_SESSION_MAX_VALUE; i++)
+        states[i] = mVideos[i].getState();
+}
+
+int32_t MultiDisplayComposer::getListenerCount() {
+    MDS_AUTOLOCK(mListenerLock);
+    return mListenerCount;
+}
+
 bool MultiDisplayComposer::hasVideoPlaying_l() {
     int size = 0;
     for (int i = 0; i < MDS_VIDEO_SESSION_MAX_VALUE; i++) {
@@ -611,6 +2009,91 @@ void MultiDisplayComposer::dumpVideoSession_l() {
     return;
 }
 
+static void dumpDisplayState(const MultiDisplayState& state, String8& out) {
+    out.appendFormat("  %d:%d connection %d, edid 0x%08x, %d timings",
+            state.id, state.connector, state.connection,
+            state.edidHash, state.timingCount);
+    if (state.timingSelected)
+        out.appendFormat(", selected %dx%d@%d%s",
+                state.timing.width, state.timing.height,
+                state.timing.refresh, state.timing.interlace ? "i" : "");
+    out.appendFormat(", scaling %d, overscan %d/%d, vpp %d\n",
+            state.scaleType, state.hStep, state.vStep, state.vpp);
+}
+
+void MultiDisplayComposer::dump(String8& out) {
+    int32_t mode = android_atomic_acquire_load(&mMode);
+    out.appendFormat("MultiDisplay mode 0x%x\n", mode);
+
+    {
+        RWLock::AutoRLock lock(mStateLock);
+        out.appendFormat("Ready %d, drm %d, HDMI control display %d\n",
+                mReady, mDrmInit, mHdmiIndex);
+        out.append("Displays:\n");
+        dumpDisplayState(mPrimary, out);
+        dumpDisplayState(mVirtual, out);
+        for (int i = 0; i < mExternalCount; i++)
+            dumpDisplayState(mExternal[i], out);
+    }
+
+    // Don't wait for a hotplug probe, the timings are skipped if busy
+    if (mdsTryLock(mDisplayLock, __func__) == NO_ERROR) {
+        MDSHdmiTiming timings[MDS_HDMI_TIMING_MAX];
+        int count = (mDrmInit ?
+                drm_hdmi_getTimingList(mHdmiIndex, timings, MDS_HDMI_TIMING_MAX) : 0);
+        mDisplayLock.unlock();
+        out.appendFormat("HDMI timings: %d\n", count);
+        for (int i = 0; i < count; i++)
+            out.appendFormat("  [%d] %dx%d@%d%s, ratio %d, flags 0x%x\n", i,
+                    timings[i].width, timings[i].height, timings[i].refresh,
+                    timings[i].interlace ? "i" : "", timings[i].ratio,
+                    timings[i].flags);
+    } else {
+        out.append("HDMI timings: display is busy\n");
+    }
+
+    {
+        MDS_AUTOLOCK(mVideoLock);
+        out.appendFormat("Video sessions: %d\n", getVideoSessionSize_l());
+        if (mVideoLeaseMonitor != NULL && mVideoLeaseMonitor->getLeaseTime() > 0)
+            out.appendFormat("Video session lease: %lld ms\n",
+                    (long long)ns2ms(mVideoLeaseMonitor->getLeaseTime()));
+        for (int i = 0; i < MDS_VIDEO_SESSION_MAX_VALUE; i++)
+            mVideos[i].dump(i, out);
+    }
+
+    {
+        MDS_AUTOLOCK(mCallbackLock);
+        out.appendFormat("Callback %p, caps 0x%x\n",
+                mMDSCallback.get(), mCallbackCaps);
+    }
+
+    {
+        MDS_AUTOLOCK(mListenerLock);
+        out.appendFormat("Listeners: %d, last broadcasted mode 0x%x\n",
+                mListenerCount, mBroadcastMode);
+        for (uint64_t bits = mListenerBitmap; bits != 0; bits &= bits - 1) {
+            MultiDisplayListener* listener = mListeners[__builtin_ctzll(bits)];
+            const char* name = listener->getName();
+            out.appendFormat("  [%d] %s, msg 0x%x\n", listener->getId(),
+                    name != NULL ? name : "", listener->getMsg());
+        }
+    }
+
+    mRecorder.dump(out);
+    out.append("Latency:\n");
+    MultiDisplayLatency::dumpAll(out);
+    mdsDumpLocks(out);
+}
+
+status_t MultiDisplayComposer::startRecording() {
+    return mRecorder.start(RECORD_PATH, android_atomic_acquire_load(&mMode));
+}
+
+void MultiDisplayComposer::stopRecording() {
+    mRecorder.stop();
+}
+
 int MultiDisplayComposer::getValidDecoderConfigVideoSession_l() {
     int index = -1;
     int32_t width  = 0;
@@ -627,7 +2110,7 @@ int MultiDisplayComposer::getValidDecoderConfigVideoSession_l() {
 //TODO: The input "sessionId" is ignored now
 status_t MultiDisplayComposer::getDecoderOutputResolution(
         int sessionId, int32_t* width, int32_t* height) {
-    Mutex::Autolock lock(mMutex);
+    MDS_AUTOLOCK(mVideoLock);
     status_t result = NO_ERROR;
     int index = getValidDecoderConfigVideoSession_l();
     if (index < 0)
@@ -641,18 +2124,24 @@ status_t MultiDisplayComposer::getDecoderOutputResolution(
 
 status_t MultiDisplayComposer::setDecoderOutputResolution(
         int sessionId, int32_t width, int32_t height) {
-    Mutex::Autolock lock(mMutex);
-
+    mRecorder.record(MDS_REC_SET_DECODER_OUTPUT_RESOLUTION, sessionId, width, height);
     // Check video session
     CHECK_VIDEO_SESSION_ID(sessionId, UNKNOWN_ERROR);
-    int index = getValidDecoderConfigVideoSession_l();
-    if (index >= 0) {
-        ALOGW("Already has a valid decoder output resolution");
-        return UNKNOWN_ERROR;
+    status_t result = NO_ERROR;
+    {
+        MDS_AUTOLOCK(mVideoLock);
+        int index = getValidDecoderConfigVideoSession_l();
+        if (index >= 0) {
+            ALOGW("Already has a valid decoder output resolution");
+            return UNKNOWN_ERROR;
+        }
+        ALOGV("set video session %d decoder output resolution %dx%d",
+                sessionId, width, height);
+        result = mVideos[sessionId].setDecoderOutputResolution(width, height);
     }
-    ALOGV("set video session %d decoder output resolution %dx%d",
-            sessionId, width, height);
-    return mVideos[sessionId].setDecoderOutputResolution(width, height);
+    if (result == NO_ERROR)
+        saveSnapshot();
+    return result;
 }
 
 #ifdef TARGET_HAS_VPP
@@ -667,28 +2156,29 @@ status_t MultiDisplayComposer::setVppState_l(
     if (dpyId != MDS_DISPLAY_VIRTUAL) {
         return UNKNOWN_ERROR;
     }
-    if (connected) {
-        mDisplayId = dpyId;
-    } else {
-        mDisplayId = MDS_DISPLAY_PRIMARY;
-    }
-    ALOGV("Leaving %s, %d", __func__, mDisplayId);
+    RWLock::AutoWLock lock(mStateLock);
+    mVirtual.connection = (connected ?
+            MDS_DISPLAY_CONNECTED : MDS_DISPLAY_DISCONNECTED);
+    ALOGV("Leaving %s, %d", __func__, mVirtual.connection);
     return NO_ERROR;
 }
 
 bool MultiDisplayComposer::getVppState() {
     bool ret = false;
-    Mutex::Autolock lock(mMutex);
+    RWLock::AutoRLock lock(mStateLock);
     //TODO: only for WIDI now
-    if (mDisplayId != MDS_DISPLAY_VIRTUAL)
+    // The video goes to WIDI if it is connected, else to the local display
+    MultiDisplayState& state = mVirtual.isConnected() ? mVirtual : mPrimary;
+    if (state.vpp)
         ret = VPPSetting::isVppOn();
-    ALOGV("%s: %d %d", __func__, ret, mDisplayId);
+    ALOGV("%s: %d %d", __func__, ret, state.id);
     return ret;
 }
 
 status_t MultiDisplayComposer::setVppState(
         MDS_DISPLAY_ID dpyId, bool connected) {
-    Mutex::Autolock lock(mMutex);
+    mRecorder.record(MDS_REC_SET_VPP_STATE, dpyId, connected);
+    MDS_AUTOLOCK(mDisplayLock);
     ALOGV("%s:%d, %d, %d", __func__, __LINE__, dpyId, connected);
     return setVppState_l(dpyId, connected);
 }
@@ -22,10 +22,15 @@
 #include <utils/String16.h>
 #include <utils/RefBase.h>
 #include <utils/Vector.h>
+#include <utils/threads.h>
 #include <display/IMultiDisplayListener.h>
 #include <display/IMultiDisplayCallback.h>
 #include <display/IMultiDisplayInfoProvider.h>
 #include <display/MultiDisplayType.h>
+#include "MultiDisplayStore.h"
+#include "MultiDisplaySinkPreferences.h"
+#include "MultiDisplayRecorder.h"
+#include "MultiDisplayLockProfile.h"
 
 namespace android {
 namespace intel {
@@ -69,9 +74,62 @@ public:
     void dump();
 };
 
+// The state of one display kept by the composer
+class MultiDisplayState {
+public:
+    MDS_DISPLAY_ID         id;
+    int                    connector;
+    MDS_DISPLAY_CONNECTION connection;
+    // Hash of the sink EDID at the last committed hotplug
+    uint32_t               edidHash;
+    MDS_SCALING_TYPE       scaleType;
+    uint32_t               hStep;
+    uint32_t               vStep;
+    bool                   vpp;
+    int                    timingCount;
+    // The timing set by the user on the current sink
+    bool                   timingSelected;
+    MDSHdmiTiming          timing;
+
+    void init(MDS_DISPLAY_ID dpyId, int index);
+    void get(MDSDisplayState* state) const;
+    inline bool isConnected() const {
+        return connection != MDS_DISPLAY_DISCONNECTED;
+    }
+    inline bool hasScaling() const {
+        return scaleType != MDS_SCALING_NONE || hStep != 0 || vStep != 0;
+    }
+};
+
+// The persisted part of a video session
+typedef struct {
+    int32_t            state;
+    int32_t            owner;
+    int32_t            infoValid;
+    MDSVideoSourceInfo info;
+    int32_t            decoderConfigValid;
+    int32_t            decoderConfigWidth;
+    int32_t            decoderConfigHeight;
+    // The start time of the owner in clock ticks since the boot,
+    // so a new process with the same pid is not taken for it
+    uint64_t           ownerStartTime;
+} MultiDisplaySessionRecord;
+
 class MultiDisplayVideoSession {
 private:
     MDS_VIDEO_STATE     mState;
+    // The time of the last state change
+    nsecs_t             mStateTime;
+    // The process which reports the state
+    pid_t               mOwner;
+    // The binder of the player which allocates it, if any,
+    // the session is released when the player dies
+    sp<IBinder>         mToken;
+    // The start time of mOwner, read when the session is saved
+    uint64_t            mOwnerStartTime;
+    // Restored from the snapshot, there is no binder to watch,
+    // the session is released when its owner is gone
+    bool                mRestored;
     MDSVideoSourceInfo  mInfo;
     bool                mInfoValid;
     // Decoder output
@@ -89,8 +147,12 @@ public:
         if (state < MDS_VIDEO_PREPARING || state > MDS_VIDEO_UNPREPARED)
             return UNKNOWN_ERROR;
         mState = state;
+        mStateTime = systemTime();
         return NO_ERROR;
     }
+    inline nsecs_t getStateTime() {
+        return mStateTime;
+    }
     inline status_t getInfo(MDSVideoSourceInfo* info) {
         if (info == NULL || !mInfoValid)
             return UNKNOWN_ERROR;
@@ -119,13 +181,190 @@ public:
         *height = mDecoderConfigHeight;
         return NO_ERROR;
     }
+    inline pid_t getOwner() {
+        return mOwner;
+    }
+    inline void setOwner(pid_t owner) {
+        if (owner != mOwner)
+            mOwnerStartTime = 0;
+        mOwner = owner;
+    }
+    inline uint64_t getOwnerStartTime() {
+        return mOwnerStartTime;
+    }
+    inline const sp<IBinder>& getToken() {
+        return mToken;
+    }
+    inline void setToken(const sp<IBinder>& token) {
+        mToken = token;
+    }
+    inline bool isRestored() {
+        return mRestored;
+    }
     inline void init() {
         mState = MDS_VIDEO_UNPREPARED;
+        mStateTime = 0;
+        mOwner = 0;
+        mOwnerStartTime = 0;
+        mToken = NULL;
+        mRestored = false;
         memset(&mInfo, 0, sizeof(MDSVideoSourceInfo));
         mInfoValid = false;
         mDecoderConfigValid  = false;
     }
     void dump(int index);
+    void dump(int index, String8& out);
+    void save(MultiDisplaySessionRecord* record);
+    void restore(const MultiDisplaySessionRecord& record);
+};
+
+class MultiDisplayComposer;
+struct MultiDisplaySnapshot;
+
+/**
+ * Input idle detector, clients report input activity and the thread
+ * passes only the active/idle transitions to the composer.
+ */
+class MultiDisplayInputMonitor : public Thread {
+public:
+    // Input is idle if there is no activity in this period
+    static const int INPUT_IDLE_TIMEOUT_MS = 5000;
+
+    MultiDisplayInputMonitor(MultiDisplayComposer* com);
+    void notifyActivity();
+    void stop();
+
+private:
+    MultiDisplayComposer* mComposer;
+    Mutex     mLock;
+    Condition mCondition;
+    nsecs_t   mLastActivity;
+    // Current input state, and the last state sent to the composer
+    bool      mActive;
+    bool      mReported;
+
+    virtual bool threadLoop();
+};
+
+/**
+ * HDMI hotplug debouncer, a hotplug is committed to the composer only
+ * after no other hotplug is reported during the settle window.
+ */
+class MultiDisplayHotplugDebouncer : public Thread {
+public:
+    // The settle window can be changed by this property, 0 disables debounce
+    static const char* SETTLE_TIME_PROPERTY;
+    static const int   SETTLE_TIME_DEFAULT_MS = 300;
+
+    MultiDisplayHotplugDebouncer(MultiDisplayComposer* com, int settleMs);
+    void post(bool connected);
+    void stop();
+
+private:
+    MultiDisplayComposer* mComposer;
+    Mutex     mLock;
+    Condition mCondition;
+    nsecs_t   mSettleTime;
+    nsecs_t   mDeadline;
+    bool      mPending;
+    bool      mConnected;
+
+    virtual bool threadLoop();
+};
+
+/**
+ * Video session lease, a session which stays in PREPARING or UNPREPARING
+ * longer than the lease time is released, as its player is stuck.
+ * The owner of a restored session is checked every OWNER_CHECK_PERIOD_MS,
+ * the session is released once the owner is gone.
+ */
+class MultiDisplayVideoLeaseMonitor : public Thread {
+public:
+    // The lease time can be set by this property, 0 disables the lease
+    static const char* LEASE_TIME_PROPERTY;
+    static const int   LEASE_TIME_DEFAULT_MS = 0;
+    static const int   OWNER_CHECK_PERIOD_MS = 1000;
+
+    MultiDisplayVideoLeaseMonitor(MultiDisplayComposer* com, int leaseMs);
+    inline nsecs_t getLeaseTime() {
+        return mLeaseTime;
+    }
+    // Check the sessions at "deadline", or earlier if already asked to
+    void schedule(nsecs_t deadline);
+    void stop();
+
+private:
+    MultiDisplayComposer* mComposer;
+    Mutex     mLock;
+    Condition mCondition;
+    nsecs_t   mLeaseTime;
+    // The next check, 0 if none
+    nsecs_t   mDeadline;
+
+    virtual bool threadLoop();
+};
+
+/**
+ * Write the snapshot out of the binder threads and the composer locks.
+ * The changes posted within the write delay are saved by one write.
+ */
+class MultiDisplaySnapshotWriter : public Thread {
+public:
+    static const int WRITE_DELAY_MS = 100;
+
+    MultiDisplaySnapshotWriter(MultiDisplayComposer* com);
+    void post();
+    // Write the pending change at once, and exit
+    void stop();
+
+private:
+    MultiDisplayComposer* mComposer;
+    Mutex     mLock;
+    Condition mCondition;
+    nsecs_t   mDeadline;
+    bool      mPending;
+
+    virtual bool threadLoop();
+};
+
+// Bring up DRM out of the service registration path
+class MultiDisplayInitThread : public Thread {
+public:
+    MultiDisplayInitThread(MultiDisplayComposer* com)
+        : Thread(false), mComposer(com) {}
+private:
+    MultiDisplayComposer* mComposer;
+    virtual bool threadLoop();
+};
+
+// Drop the cached SurfaceFlinger binder when SurfaceFlinger dies
+class MultiDisplaySurfaceComposerObserver : public IBinder::DeathRecipient {
+public:
+    MultiDisplaySurfaceComposerObserver(MultiDisplayComposer* com)
+        : mComposer(com) {}
+    virtual void binderDied(const wp<IBinder>& who);
+private:
+    MultiDisplayComposer* mComposer;
+};
+
+// Remove a listener or the callback when its process dies
+class MultiDisplayClientObserver : public IBinder::DeathRecipient {
+public:
+    MultiDisplayClientObserver(MultiDisplayComposer* com)
+        : mComposer(com) {}
+    virtual void binderDied(const wp<IBinder>& who);
+private:
+    MultiDisplayComposer* mComposer;
+};
+
+// Release the video sessions of a player when it dies
+class MultiDisplayVideoOwnerObserver : public IBinder::DeathRecipient {
+public:
+    MultiDisplayVideoOwnerObserver(MultiDisplayComposer* com)
+        : mComposer(com) {}
+    virtual void binderDied(const wp<IBinder>& who);
+private:
+    MultiDisplayComposer* mComposer;
 };
 
 class MultiDisplayComposer : public RefBase {
@@ -135,6 +374,7 @@ public:
 
     // Video control
     int allocateVideoSessionId();
+    int allocateVideoSession(const sp<IBinder>& token);
     status_t updateVideoState(int, MDS_VIDEO_STATE);
     status_t resetVideoPlayback();
     status_t updateVideoSourceInfo(int, const MDSVideoSourceInfo&);
@@ -145,6 +385,9 @@ public:
     status_t getVideoSourceInfo(int, MDSVideoSourceInfo*);
     MDS_DISPLAY_MODE getDisplayMode(bool);
     bool getVppState();
+    bool isReady();
+    int getExternalDisplayCount();
+    status_t getDisplayState(MDS_DISPLAY_ID, int, MDSDisplayState*);
 
     // Sink Registrar
     int32_t  registerListener(const sp<IMultiDisplayListener>&, const char*, int);
@@ -158,11 +401,13 @@ public:
     status_t setHdmiTiming(const MDSHdmiTiming&);
     int getHdmiTimingCount();
     status_t getHdmiTimingList(int, MDSHdmiTiming**);
+    int getHdmiTimings(MDSHdmiTiming*, int);
     status_t getCurrentHdmiTiming(MDSHdmiTiming*);
     status_t setHdmiTimingByIndex(int);
     int getCurrentHdmiTimingIndex();
     status_t setHdmiScalingType(MDS_SCALING_TYPE);
     status_t setHdmiOverscan(int, int);
+    status_t applyDisplayConfig(const MDSDisplayConfig&);
 
     // Display connection state observer
     status_t updateHdmiConnectionStatus(bool);
@@ -171,6 +416,7 @@ public:
     // Event monitor
     status_t updateInputState(bool);
     status_t updatePhoneCallState(bool);
+    status_t notifyInputActivity();
 
     // Decoder configure
     status_t getDecoderOutputResolution(int, int32_t*, int32_t*);
@@ -181,42 +427,200 @@ public:
     status_t setVppState(MDS_DISPLAY_ID, bool);
 #endif
 
+    // Print the state for dumpsys
+    void dump(String8& out);
+    // Record the calls above into RECORD_PATH, @see MultiDisplayRecorder
+    status_t startRecording();
+    void stopRecording();
+
+protected:
+    /*
+     * The hooks of the tools, which drive the composer without HWC,
+     * @see tools/common/MultiDisplayComposerTestAccess.h
+     */
+    // Take mListenerLock
+    void broadcastMessage(int msg, void* value, int size, bool ignoreVideoDriver);
+    // Commit a hotplug at once, without the debouncer
+    status_t commitHdmiHotplug(bool);
+    // Take mVideoLock
+    void getVideoStates(MDS_VIDEO_STATE* states);
+    // Take mListenerLock
+    int32_t getListenerCount();
+
 private:
     // Assume it is impossible that there are up to 64 cocurrent running video driver
     static const int MDS_LISTENER_MAX_VALUE = (MDS_VIDEO_SESSION_MAX_VALUE * 4);
+    static_assert(MDS_LISTENER_MAX_VALUE <= 64, "a listener slot is a bit of mListenerBitmap");
+    /*
+     * A listener ID is (generation << LISTENER_SLOT_BITS) | slot. The
+     * generation of a slot is bumped each time it is taken, so a late
+     * unregisterListener with the ID of a removed listener doesn't
+     * match the next listener of the slot. It has 24 bits, the ID is
+     * always a positive int32_t.
+     */
+    static const int LISTENER_SLOT_BITS = 6;
+    static const int32_t LISTENER_SLOT_MASK = (1 << LISTENER_SLOT_BITS) - 1;
+    static const uint32_t LISTENER_GENERATION_MASK = 0xFFFFFF;
+    static_assert(MDS_LISTENER_MAX_VALUE <= (1 << LISTENER_SLOT_BITS), "a slot fits in the ID");
+
+    /*
+     * Lock order, a thread holding a lock only takes the ones below it:
+     *   mDisplayLock      DRM, hotplugs, HDMI timing and scaling, mSurfaceComposer
+     *   mVideoNotifyLock  the order of the video state changes sent out
+     *   mVideoLock        mVideos
+     *   mStateLock        the display state table, mDrmInit and mReady
+     *   mCallbackLock     mMDSCallback and mCallbackCaps
+     *   mListenerLock     mListeners, and the order of the broadcasts
+     * The state table is written with both mDisplayLock and mStateLock held,
+     * so either of them is enough to read it.
+     * mMode is updated atomically and read without any lock.
+     * HWC callbacks are called with at most mDisplayLock or mVideoNotifyLock
+     * held, so HWC may query MDS from a callback, but not the HDMI control.
+     * A query from HWC never waits for mDisplayLock, e.g. a hotplug probe.
+     * The binders of the video sessions, the listeners and the callback
+     * are unlinked out of their locks.
+     * The lock of mRecorder is the last one, it is taken with any of them.
+     * The mutexes are profiled in a build with MDS_LOCK_PROFILE,
+     * @see MultiDisplayLockProfile.h
+     */
+    mutable MultiDisplayMutex mDisplayLock;
+    mutable MultiDisplayMutex mVideoNotifyLock;
+    mutable MultiDisplayMutex mVideoLock;
+    mutable RWLock mStateLock;
+    mutable MultiDisplayMutex mCallbackLock;
+    mutable MultiDisplayMutex mListenerLock;
+
     bool     mDrmInit;
-    int      mMode;
-    mutable  Mutex mMutex;
-    uint32_t mHorizontalStep;
-    uint32_t mVerticalStep;
-#ifdef TARGET_HAS_VPP
-    // Vpp cofigure, only for WIDI now, and will be removed
-    // Maintain current connected display device Id
-    // if HDMI is connected, this id = MDS_DISPLAY_EXTERNAL
-    // if WIFI is connected, this id = MDS_DISPLAY_VIRTUAL
-    // else id = MDS_DISPLAY_PRIMARY
-    MDS_DISPLAY_ID mDisplayId;
-#endif
-    MDS_SCALING_TYPE mScaleType;
-    int32_t mListenerId;
+    // The bring-up is finished, whatever drm_init succeeds or not
+    bool     mReady;
+    // The summary of all the displays, @see MDS_DISPLAY_MODE
+    volatile int32_t mMode;
+    // The last mode broadcasted, guarded by mListenerLock
+    int32_t  mBroadcastMode;
+    // The bit N is set if the listener slot N is in use, guarded by
+    // mListenerLock with mListeners, mListenerGenerations and mListenerCount
+    uint64_t mListenerBitmap;
+    int32_t  mListenerCount;
+
+    // The state table, @see getDisplayState_l
+    MultiDisplayState mPrimary;
+    MultiDisplayState mVirtual;
+    MultiDisplayState mExternal[MDS_EXTERNAL_DISPLAY_MAX];
+    int mExternalCount;
+    // The external display addressed by the HDMI control
+    int mHdmiIndex;
 
     sp<IBinder> mSurfaceComposer;
     sp<IMultiDisplayCallback> mMDSCallback;
+    // MDS_CB_CAP_* reported by mMDSCallback
+    uint32_t mCallbackCaps;
+    sp<MultiDisplaySurfaceComposerObserver> mSurfaceComposerObserver;
+    sp<MultiDisplayInputMonitor> mInputMonitor;
+    sp<MultiDisplayHotplugDebouncer> mHotplugDebouncer;
+    sp<MultiDisplayClientObserver> mClientObserver;
+    sp<MultiDisplayVideoOwnerObserver> mVideoOwnerObserver;
+    sp<MultiDisplayVideoLeaseMonitor> mVideoLeaseMonitor;
+    sp<MultiDisplaySnapshotWriter> mSnapshotWriter;
+    sp<MultiDisplayInitThread> mInitThread;
 
-    KeyedVector<int32_t, MultiDisplayListener* > mListeners;
+    // The state is saved on each committed change, and restored when
+    // the service restarts in the same boot, @see restoreSnapshot
+    static const char* SNAPSHOT_PATH;
+    MultiDisplayStore mSnapshotStore;
+    // The last snapshot written, only used by mSnapshotWriter
+    MultiDisplaySnapshot* mSnapshot;
+    char mBootId[40];
+    // The settings chosen for each sink, applied when it is connected again.
+    // Guarded by mDisplayLock
+    static const char* PREFERENCES_PATH;
+    MultiDisplaySinkPreferences mSinkPreferences;
+    // The inbound calls are recorded into this log, from the start
+    // if the property is set to 1
+    static const char* RECORD_PATH;
+    static const char* RECORD_PROPERTY;
+    MultiDisplayRecorder mRecorder;
+
+#ifdef MDS_TRACE
+    // The trace flows of the HDMI hotplug events, from the report to
+    // the commit, the last one started and the last one finished
+    volatile int32_t mHotplugTraceId;
+    int32_t mHotplugTraceDone;
+#endif
+
+    // Indexed by the listener slot
+    MultiDisplayListener* mListeners[MDS_LISTENER_MAX_VALUE];
+    // The generation of the last listener of each slot
+    uint32_t mListenerGenerations[MDS_LISTENER_MAX_VALUE];
     MultiDisplayVideoSession mVideos[MDS_VIDEO_SESSION_MAX_VALUE];
 
     void init();
-    void broadcastMessageLocked(int msg, void* value, int size, bool ignoreVideoDriver);
+    void restoreSnapshot();
+    // Post the state to mSnapshotWriter, it never blocks
+    void saveSnapshot();
+    // Called by mSnapshotWriter without any lock held,
+    // take mVideoLock and mStateLock
+    void writeSnapshot();
+    void broadcastMessage_l(int msg, void* value, int size, bool ignoreVideoDriver);
+    // The ID of the lowest free slot in its next generation,
+    // -1 if all the slots are in use
+    int32_t allocateListenerId_l();
+    // Remove and delete the listener of "slot", which is in use, return
+    // its binder, which is unlinked out of mListenerLock if it is alive
+    sp<IBinder> removeListener_l(int32_t slot);
+    void onClientDied(const wp<IBinder>& who);
+    void broadcastModeChange(bool ignoreVideoDriver);
+    void broadcastDisplayState(const MultiDisplayState& state);
+    // Update the bits of mMode, return the previous mode
+    int  updateMode(int set, int clear);
+    // Take mCallbackLock, return NULL if the callback doesn't have the caps
+    sp<IMultiDisplayCallback> getCallback(uint32_t caps);
+    void updateCallbackCap(const sp<IMultiDisplayCallback>& cbk,
+            uint32_t cap, status_t result);
+    // "Locked" means mDisplayLock is held
     status_t setDisplayScalingLocked(uint32_t mode, uint32_t stepx, uint32_t stepy);
+    void onSurfaceComposerDied(const wp<IBinder>& who);
+    status_t setHdmiScalingTypeLocked(MDS_SCALING_TYPE type);
+    status_t setHdmiOverscanLocked(int hStep, int vStep);
+    status_t applyDisplayConfigLocked(const MDSDisplayConfig& config);
+    // Push a validated config of the HDMI control display, and commit it
+    status_t commitDisplayConfigLocked(const MDSDisplayConfig& config, int timingIndex);
+    // Set up a newly connected sink, return true if its state is broadcasted
+    bool applySinkPreferenceLocked(int index);
+    void saveSinkPreferenceLocked();
     status_t updateHdmiConnectStatusLocked();
-    MultiDisplayVideoSession* getVideoSession_l(int sessionId);
+    status_t resetScalingLocked(MultiDisplayState& state);
+    // "_l" means the lock of the data is held: mDisplayLock or mStateLock
+    // for the state table, mVideoLock for the video sessions,
+    // and mListenerLock for the listeners
+    MultiDisplayState* getDisplayState_l(MDS_DISPLAY_ID id, int connector);
+    inline MultiDisplayState& hdmiState_l() {
+        return mExternal[mHdmiIndex];
+    }
     int  getVideoSessionSize_l();
     void initVideoSessions_l();
     bool hasVideoPlaying_l();
     void dumpVideoSession_l();
+    // Send a video state change out, mVideoNotifyLock is held
+    status_t notifyVideoState(int sessionId, MDS_VIDEO_STATE state,
+            bool playing, bool ignoreVideoDriver);
+    // Release a session as if its player reported MDS_VIDEO_UNPREPARED,
+    // only if it is still owned by "owner" and its state is changed at
+    // "stateTime", when they are not NULL or 0, "reason" is logged
+    void releaseVideoSession(int sessionId, IBinder* owner, nsecs_t stateTime,
+            const char* reason);
+    void onVideoOwnerDied(const wp<IBinder>& who);
+    // Release the sessions whose lease is expired,
+    // and the restored ones whose owner is gone
+    void expireVideoSessions();
     int  getValidDecoderConfigVideoSession_l();
     status_t notifyHotplugLocked(MDS_DISPLAY_ID, bool);
+    friend class MultiDisplayHotplugDebouncer;
+    friend class MultiDisplayInitThread;
+    friend class MultiDisplaySurfaceComposerObserver;
+    friend class MultiDisplayClientObserver;
+    friend class MultiDisplayVideoOwnerObserver;
+    friend class MultiDisplayVideoLeaseMonitor;
+    friend class MultiDisplaySnapshotWriter;
 #ifdef TARGET_HAS_VPP
     status_t setVppState_l(MDS_DISPLAY_ID, bool);
 #endif
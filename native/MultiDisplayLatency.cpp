@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2012-2013, Intel Corporation. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <utils/threads.h>
+#include <cutils/atomic.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "MultiDisplayLatency.h"
+
+namespace android {
+namespace intel {
+
+// The registered histograms, only the registration takes the lock.
+// A histogram may be a static object of another file, so the lock is
+// created at the first use.
+static MultiDisplayLatency* sLatencyList = NULL;
+
+static Mutex& latencyLock() {
+    static Mutex lock;
+    return lock;
+}
+
+MultiDisplayLatency::MultiDisplayLatency(const char* name) :
+    mName(name),
+    mCount(0),
+    mMaxUs(0),
+    mNext(NULL)
+{
+    memset((void*)mBuckets, 0, sizeof(mBuckets));
+    Mutex::Autolock lock(latencyLock());
+    mNext = sLatencyList;
+    sLatencyList = this;
+}
+
+void MultiDisplayLatency::record(nsecs_t duration) {
+    nsecs_t us = ns2us(duration);
+    int32_t value = (us > INT32_MAX ? INT32_MAX : (us < 0 ? 0 : (int32_t)us));
+    int bucket = 0;
+    while ((value >> bucket) != 0 && bucket < BUCKETS - 1)
+        bucket++;
+    android_atomic_inc(&mBuckets[bucket]);
+    android_atomic_inc(&mCount);
+    int32_t max;
+    do {
+        max = android_atomic_acquire_load(&mMaxUs);
+        if (value <= max)
+            break;
+    } while (android_atomic_release_cas(max, value, &mMaxUs) != 0);
+}
+
+void MultiDisplayLatency::dump(String8& out) const {
+    int32_t count = android_atomic_acquire_load(&mCount);
+    if (count == 0)
+        return;
+    out.appendFormat("  %s: %d calls, max %d us\n   ", mName, count,
+            android_atomic_acquire_load(&mMaxUs));
+    for (int i = 0; i < BUCKETS; i++) {
+        int32_t n = android_atomic_acquire_load(&mBuckets[i]);
+        if (n == 0)
+            continue;
+        if (i == 0)
+            out.appendFormat(" <1us:%d", n);
+        else if (i == BUCKETS - 1)
+            out.appendFormat(" >=%dus:%d", 1 << (i - 1), n);
+        else
+            out.appendFormat(" <%dus:%d", 1 << i, n);
+    }
+    out.append("\n");
+}
+
+void MultiDisplayLatency::dumpAll(String8& out) {
+    MultiDisplayLatency* list;
+    {
+        Mutex::Autolock lock(latencyLock());
+        list = sLatencyList;
+    }
+    // A histogram is added at the head, the ones seen here never change
+    for (MultiDisplayLatency* l = list; l != NULL; l = l->mNext)
+        l->dump(out);
+}
+
+}; // namespace intel
+}; // namespace android
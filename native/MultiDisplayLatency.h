@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2012-2013, Intel Corporation. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef __MULTIDISPLAY_LATENCY_H__
+#define __MULTIDISPLAY_LATENCY_H__
+
+#include <utils/String8.h>
+#include <utils/Timers.h>
+#include "MultiDisplayTrace.h"
+
+namespace android {
+namespace intel {
+
+/**
+ * The latency histogram of a call, with log2 buckets in microseconds.
+ * Bucket 0 counts the calls under 1us, bucket i (i > 0) counts
+ * the ones in [2^(i-1), 2^i) us, and the last bucket is open ended.
+ * A call is recorded with atomic counters, without any lock.
+ * The histograms are never freed, they are listed by dumpAll.
+ */
+class MultiDisplayLatency {
+public:
+    static const int BUCKETS = 24;
+
+    MultiDisplayLatency(const char* name);
+
+    inline const char* getName() const {
+        return mName;
+    }
+    void record(nsecs_t duration);
+    void dump(String8& out) const;
+    static void dumpAll(String8& out);
+
+private:
+    const char*      mName;
+    volatile int32_t mCount;
+    volatile int32_t mMaxUs;
+    volatile int32_t mBuckets[BUCKETS];
+    MultiDisplayLatency* mNext;
+};
+
+// Record the time spent in the scope
+class MultiDisplayLatencyScope {
+public:
+    MultiDisplayLatencyScope(MultiDisplayLatency& latency)
+        : mLatency(latency), mStart(systemTime()) {}
+    ~MultiDisplayLatencyScope() {
+        mLatency.record(systemTime() - mStart);
+    }
+private:
+    MultiDisplayLatency& mLatency;
+    nsecs_t mStart;
+};
+
+// Measure the rest of the enclosing scope into the histogram "LATENCY",
+// it is also a trace section if the trace is enabled
+#define MDS_LATENCY_SCOPE(LATENCY) \
+    MDS_TRACE_NAME((LATENCY).getName()); \
+    MultiDisplayLatencyScope _mdsLatencyScope(LATENCY)
+
+// The same, with a histogram named "NAME" of the enclosing function
+#define MDS_LATENCY(NAME) \
+    static MultiDisplayLatency _mdsLatency(NAME); \
+    MDS_LATENCY_SCOPE(_mdsLatency)
+
+}; // namespace intel
+}; // namespace android
+
+#endif
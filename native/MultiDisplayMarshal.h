@@ -0,0 +1,382 @@
+/*
+ * Copyright (c) 2012-2013, Intel Corporation. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef __MULTIDISPLAY_MARSHAL_H__
+#define __MULTIDISPLAY_MARSHAL_H__
+
+#include <string.h>
+#include <utils/Errors.h>
+#include <utils/RefBase.h>
+#include <binder/IInterface.h>
+#include <binder/Parcel.h>
+
+#include <display/MultiDisplayType.h>
+#include <display/IMultiDisplayListener.h>
+
+namespace android {
+namespace intel {
+
+/*
+ * Wire format of the types used by IMultiDisplay* interfaces.
+ * Every field is written as a 32-bit value, structs are written field
+ * by field, so the layout doesn't depend on the ABI of the process.
+ */
+template <typename T>
+struct MDSWire;
+
+template <>
+struct MDSWire<int32_t> {
+    static status_t write(Parcel& p, int32_t v) {
+        return p.writeInt32(v);
+    }
+    static status_t read(const Parcel& p, int32_t* v) {
+        return p.readInt32(v);
+    }
+};
+
+template <>
+struct MDSWire<uint32_t> {
+    static status_t write(Parcel& p, uint32_t v) {
+        return p.writeInt32((int32_t)v);
+    }
+    static status_t read(const Parcel& p, uint32_t* v) {
+        return p.readInt32((int32_t*)v);
+    }
+};
+
+template <>
+struct MDSWire<bool> {
+    static status_t write(Parcel& p, bool v) {
+        return p.writeInt32(v ? 1 : 0);
+    }
+    static status_t read(const Parcel& p, bool* v) {
+        int32_t value = 0;
+        status_t err = p.readInt32(&value);
+        *v = (value != 0);
+        return err;
+    }
+};
+
+// Enums are written as int32_t
+#define MDS_WIRE_ENUM(TYPE) \
+template <> \
+struct MDSWire<TYPE> { \
+    static status_t write(Parcel& p, TYPE v) { \
+        return p.writeInt32((int32_t)v); \
+    } \
+    static status_t read(const Parcel& p, TYPE* v) { \
+        int32_t value = 0; \
+        status_t err = p.readInt32(&value); \
+        *v = (TYPE)value; \
+        return err; \
+    } \
+}
+
+MDS_WIRE_ENUM(MDS_DISPLAY_ID);
+MDS_WIRE_ENUM(MDS_VIDEO_STATE);
+MDS_WIRE_ENUM(MDS_SCALING_TYPE);
+MDS_WIRE_ENUM(MDS_DISPLAY_CONNECTION);
+
+// C string, the pointer read from a parcel is valid as long as the parcel
+template <>
+struct MDSWire<const char*> {
+    static status_t write(Parcel& p, const char* v) {
+        return p.writeCString(v != NULL ? v : "");
+    }
+    static status_t read(const Parcel& p, const char** v) {
+        *v = p.readCString();
+        return (*v != NULL ? NO_ERROR : NOT_ENOUGH_DATA);
+    }
+};
+
+template <>
+struct MDSWire<sp<IBinder> > {
+    static status_t write(Parcel& p, const sp<IBinder>& v) {
+        return p.writeStrongBinder(v);
+    }
+    static status_t read(const Parcel& p, sp<IBinder>* v) {
+        *v = p.readStrongBinder();
+        return NO_ERROR;
+    }
+};
+
+// Binder interfaces
+template <typename INTERFACE>
+struct MDSWire<sp<INTERFACE> > {
+    static status_t write(Parcel& p, const sp<INTERFACE>& v) {
+        return p.writeStrongBinder(v != NULL ? v->asBinder() : NULL);
+    }
+    static status_t read(const Parcel& p, sp<INTERFACE>* v) {
+        *v = interface_cast<INTERFACE>(p.readStrongBinder());
+        return NO_ERROR;
+    }
+};
+
+inline status_t mdsWrite(Parcel& p) {
+    return NO_ERROR;
+}
+
+/** @brief Write the values into a parcel in order */
+template <typename T, typename... Args>
+inline status_t mdsWrite(Parcel& p, const T& v, const Args&... args) {
+    status_t err = MDSWire<T>::write(p, v);
+    if (err != NO_ERROR)
+        return err;
+    return mdsWrite(p, args...);
+}
+
+inline status_t mdsRead(const Parcel& p) {
+    return NO_ERROR;
+}
+
+/** @brief Read the values from a parcel in order */
+template <typename T, typename... Args>
+inline status_t mdsRead(const Parcel& p, T* v, Args*... args) {
+    status_t err = MDSWire<T>::read(p, v);
+    if (err != NO_ERROR)
+        return err;
+    return mdsRead(p, args...);
+}
+
+template <>
+struct MDSWire<MDSHdmiTiming> {
+    static status_t write(Parcel& p, const MDSHdmiTiming& v) {
+        return mdsWrite(p, (int32_t)v.width, (int32_t)v.height, v.refresh,
+                (int32_t)v.interlace, (int32_t)v.ratio, v.flags);
+    }
+    static status_t read(const Parcel& p, MDSHdmiTiming* v) {
+        int32_t width = 0, height = 0, interlace = 0, ratio = 0;
+        status_t err = mdsRead(p, &width, &height, &v->refresh,
+                &interlace, &ratio, &v->flags);
+        v->width     = width;
+        v->height    = height;
+        v->interlace = interlace;
+        v->ratio     = ratio;
+        return err;
+    }
+};
+
+template <>
+struct MDSWire<MDSVideoSourceInfo> {
+    static status_t write(Parcel& p, const MDSVideoSourceInfo& v) {
+        return mdsWrite(p, (int32_t)v.frameRate, (int32_t)v.displayW,
+                (int32_t)v.displayH, v.isInterlaced, v.isProtected);
+    }
+    static status_t read(const Parcel& p, MDSVideoSourceInfo* v) {
+        int32_t frameRate = 0, displayW = 0, displayH = 0;
+        status_t err = mdsRead(p, &frameRate, &displayW, &displayH,
+                &v->isInterlaced, &v->isProtected);
+        v->frameRate = frameRate;
+        v->displayW  = displayW;
+        v->displayH  = displayH;
+        return err;
+    }
+};
+
+template <>
+struct MDSWire<MDSDisplayConfig> {
+    static status_t write(Parcel& p, const MDSDisplayConfig& v) {
+        return mdsWrite(p, v.fields, v.timing, v.scaling,
+                (int32_t)v.hOverscan, (int32_t)v.vOverscan);
+    }
+    static status_t read(const Parcel& p, MDSDisplayConfig* v) {
+        int32_t hOverscan = 0, vOverscan = 0;
+        status_t err = mdsRead(p, &v->fields, &v->timing, &v->scaling,
+                &hOverscan, &vOverscan);
+        v->hOverscan = hOverscan;
+        v->vOverscan = vOverscan;
+        return err;
+    }
+};
+
+template <>
+struct MDSWire<MDSDisplayState> {
+    static status_t write(Parcel& p, const MDSDisplayState& v) {
+        return mdsWrite(p, v.id, (int32_t)v.connector, v.connection,
+                (int32_t)v.timingCount, v.scaling,
+                (int32_t)v.hOverscan, (int32_t)v.vOverscan, v.vpp);
+    }
+    static status_t read(const Parcel& p, MDSDisplayState* v) {
+        int32_t connector = 0, timingCount = 0, hOverscan = 0, vOverscan = 0;
+        status_t err = mdsRead(p, &v->id, &connector, &v->connection,
+                &timingCount, &v->scaling, &hOverscan, &vOverscan, &v->vpp);
+        v->connector   = connector;
+        v->timingCount = timingCount;
+        v->hOverscan   = hOverscan;
+        v->vOverscan   = vOverscan;
+        return err;
+    }
+};
+
+/**
+ * @brief Write a message of IMultiDisplayListener, its id and size, then
+ * the payload, field by field for MDS_MSG_DISPLAY_STATE, as an opaque block
+ * of "size" bytes for the others
+ */
+inline status_t mdsWriteMessage(Parcel& p, int msg, const void* value, int size) {
+    if (msg == (int)MDS_MSG_DISPLAY_STATE) {
+        if ((size_t)size < sizeof(MDSDisplayState))
+            return BAD_VALUE;
+        return mdsWrite(p, msg, size, *(const MDSDisplayState*)value);
+    }
+    status_t err = mdsWrite(p, msg, size);
+    if (err != NO_ERROR)
+        return err;
+    return p.write(value, size);
+}
+
+/**
+ * @brief Read a message written by mdsWriteMessage, "value" points to
+ * "state" for MDS_MSG_DISPLAY_STATE, or into the parcel for the others
+ */
+inline status_t mdsReadMessage(const Parcel& p, int32_t* msg,
+        void** value, int32_t* size, MDSDisplayState* state) {
+    status_t err = mdsRead(p, msg, size);
+    if (err != NO_ERROR)
+        return err;
+    if (*msg == (int32_t)MDS_MSG_DISPLAY_STATE) {
+        memset(state, 0, sizeof(MDSDisplayState));
+        err = mdsRead(p, state);
+        *value = state;
+        *size = sizeof(MDSDisplayState);
+        return err;
+    }
+    if (*size < (int32_t)sizeof(int) || (size_t)*size > p.dataAvail())
+        return BAD_VALUE;
+    // Used in place, it lives as long as the parcel
+    *value = const_cast<void*>(p.readInplace(*size));
+    return *value == NULL ? NOT_ENOUGH_DATA : NO_ERROR;
+}
+
+// "int" is the same type as int32_t on all the supported ABIs,
+// the parameter types of a method are used without const and reference.
+template <typename T> struct MDSArg { typedef T type; };
+template <typename T> struct MDSArg<const T> { typedef T type; };
+template <typename T> struct MDSArg<T&> { typedef T type; };
+template <typename T> struct MDSArg<const T&> { typedef T type; };
+
+/**
+ * @brief Write the interface token and the arguments,
+ * and send the transaction to remote
+ */
+template <typename... In>
+inline status_t mdsTransact(IBinder* remote, const String16& descriptor,
+        uint32_t code, Parcel* reply, uint32_t flags, const In&... in) {
+    Parcel data;
+    data.writeInterfaceToken(descriptor);
+    status_t err = mdsWrite(data, in...);
+    if (err != NO_ERROR)
+        return err;
+    return remote->transact(code, data, reply, flags);
+}
+
+/**
+ * @brief A synchronous call which returns status_t,
+ * @return the transaction error, or the status returned by remote
+ */
+template <typename... In>
+inline status_t mdsCall(IBinder* remote, const String16& descriptor,
+        uint32_t code, const In&... in) {
+    Parcel reply;
+    status_t result = mdsTransact(remote, descriptor, code, &reply, 0, in...);
+    if (result != NO_ERROR)
+        return result;
+    if (mdsRead(reply, &result) != NO_ERROR)
+        return NOT_ENOUGH_DATA;
+    return result;
+}
+
+/**
+ * @brief A synchronous call which returns a value of type R
+ * @return the value returned by remote, or "err" if the transaction fails
+ */
+template <typename R, typename... In>
+inline R mdsCallValue(IBinder* remote, const String16& descriptor,
+        uint32_t code, R err, const In&... in) {
+    Parcel reply;
+    if (mdsTransact(remote, descriptor, code, &reply, 0, in...) != NO_ERROR)
+        return err;
+    R ret = err;
+    if (mdsRead(reply, &ret) != NO_ERROR)
+        return err;
+    return ret;
+}
+
+/** @brief An one-way call, it returns without waiting for remote */
+template <typename... In>
+inline status_t mdsCallOneway(IBinder* remote, const String16& descriptor,
+        uint32_t code, const In&... in) {
+    return mdsTransact(remote, descriptor, code,
+            NULL, IBinder::FLAG_ONEWAY, in...);
+}
+
+// Invoke a method of the stub, and write its return value into the reply
+template <typename C, typename R, typename... A>
+struct MDSMethod {
+    C* self;
+    R (C::*method)(A...);
+    template <typename... V>
+    status_t operator()(Parcel* reply, V&... values) {
+        R ret = (self->*method)(values...);
+        if (reply == NULL)
+            return NO_ERROR;
+        return MDSWire<typename MDSArg<R>::type>::write(*reply, ret);
+    }
+};
+
+// Read the pending arguments one by one, then invoke the method
+template <typename... Pending>
+struct MDSArgReader;
+
+template <>
+struct MDSArgReader<> {
+    template <typename M, typename... Done>
+    static status_t apply(const Parcel& data, Parcel* reply,
+            M& method, Done&... done) {
+        return method(reply, done...);
+    }
+};
+
+template <typename T, typename... Rest>
+struct MDSArgReader<T, Rest...> {
+    template <typename M, typename... Done>
+    static status_t apply(const Parcel& data, Parcel* reply,
+            M& method, Done&... done) {
+        typename MDSArg<T>::type value;
+        status_t err = MDSWire<typename MDSArg<T>::type>::read(data, &value);
+        if (err != NO_ERROR)
+            return err;
+        return MDSArgReader<Rest...>::apply(data, reply, method, done..., value);
+    }
+};
+
+/**
+ * @brief Generated stub of a call: read the arguments from "data",
+ * invoke "method" on "self", and write the return value into "reply".
+ * Only for the methods without output parameters.
+ */
+template <typename S, typename C, typename R, typename... A>
+inline status_t mdsDispatch(S* self, R (C::*method)(A...),
+        const Parcel& data, Parcel* reply) {
+    MDSMethod<C, R, A...> m = { self, method };
+    return MDSArgReader<A...>::apply(data, reply, m);
+}
+
+}; // namespace intel
+}; // namespace android
+
+#endif
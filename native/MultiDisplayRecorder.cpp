@@ -0,0 +1,225 @@
+/*
+ * Copyright (c) 2012-2013, Intel Corporation. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+//#define LOG_NDEBUG 0
+#include <utils/Log.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/uio.h>
+
+#include "MultiDisplayRecorder.h"
+
+namespace android {
+namespace intel {
+
+// The arguments of a call are a few words, a larger record is corrupted
+static const uint32_t MAX_RECORD_SIZE = 4096;
+
+static const char* sOpNames[MDS_REC_MAX] = {
+    NULL,
+    "allocateVideoSessionId",
+    "updateVideoState",
+    "resetVideoPlayback",
+    "updateVideoSourceInfo",
+    "registerListener",
+    "unregisterListener",
+    "registerCallback",
+    "unregisterCallback",
+    "setHdmiTiming",
+    "setHdmiTimingByIndex",
+    "setHdmiScalingType",
+    "setHdmiOverscan",
+    "applyDisplayConfig",
+    "updateHdmiConnectionStatus",
+    "updateWidiConnectionStatus",
+    "updateInputState",
+    "updatePhoneCallState",
+    "notifyInputActivity",
+    "setDecoderOutputResolution",
+    "setVppState",
+};
+
+const char* MultiDisplayRecorder::getOpName(uint32_t op) {
+    if (op == 0 || op >= MDS_REC_MAX)
+        return "unknown";
+    return sOpNames[op];
+}
+
+MultiDisplayRecorder::MultiDisplayRecorder() :
+    mFd(-1),
+    mStart(0),
+    mSize(0),
+    mCount(0)
+{
+}
+
+MultiDisplayRecorder::~MultiDisplayRecorder() {
+    stop();
+}
+
+status_t MultiDisplayRecorder::start(const char* path, int32_t mode) {
+    if (path == NULL || path[0] == '\0')
+        return BAD_VALUE;
+    Mutex::Autolock lock(mLock);
+    close_l();
+    // The previous log is replaced, but never through a link,
+    // and a file created by someone else in between is kept
+    if (unlink(path) < 0 && errno != ENOENT) {
+        ALOGW("Fail to remove %s, %s", path, strerror(errno));
+        return UNKNOWN_ERROR;
+    }
+    int fd = open(path, O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW, 0600);
+    if (fd < 0) {
+        ALOGW("Fail to create %s, %s", path, strerror(errno));
+        return UNKNOWN_ERROR;
+    }
+    MultiDisplayRecordHeader header;
+    header.magic    = MAGIC;
+    header.version  = VERSION;
+    header.mode     = mode;
+    header.reserved = 0;
+    if (::write(fd, &header, sizeof(header)) != (ssize_t)sizeof(header)) {
+        ALOGW("Fail to write %s, %s", path, strerror(errno));
+        close(fd);
+        return UNKNOWN_ERROR;
+    }
+    mPath.setTo(path);
+    mStart = systemTime();
+    mSize  = sizeof(header);
+    mCount = 0;
+    android_atomic_release_store(fd, &mFd);
+    ALOGI("Start recording into %s", path);
+    return NO_ERROR;
+}
+
+void MultiDisplayRecorder::stop() {
+    Mutex::Autolock lock(mLock);
+    close_l();
+}
+
+void MultiDisplayRecorder::close_l() {
+    int fd = mFd;
+    if (fd < 0)
+        return;
+    android_atomic_release_store(-1, &mFd);
+    close(fd);
+    ALOGI("Stop recording into %s, %u records", mPath.string(), mCount);
+}
+
+void MultiDisplayRecorder::write(MDS_RECORD_OP op, const void* data, size_t size) {
+    Mutex::Autolock lock(mLock);
+    if (mFd < 0)
+        return;
+    MultiDisplayRecord record;
+    record.time = systemTime() - mStart;
+    record.op   = op;
+    record.size = size;
+    size_t total = sizeof(record) + size;
+    if (mSize + total > MAX_LOG_SIZE) {
+        ALOGW("%s is full", mPath.string());
+        close_l();
+        return;
+    }
+    // One write per record, a reader never sees a half of a record
+    // unless the disk is full
+    struct iovec iov[2];
+    iov[0].iov_base = &record;
+    iov[0].iov_len  = sizeof(record);
+    iov[1].iov_base = const_cast<void*>(data);
+    iov[1].iov_len  = size;
+    ssize_t n;
+    do {
+        n = writev(mFd, iov, (size > 0 ? 2 : 1));
+    } while (n < 0 && errno == EINTR);
+    if (n != (ssize_t)total) {
+        ALOGW("Fail to write %s, %s", mPath.string(), strerror(errno));
+        close_l();
+        return;
+    }
+    mSize += total;
+    mCount++;
+}
+
+void MultiDisplayRecorder::dump(String8& out) {
+    Mutex::Autolock lock(mLock);
+    if (mFd < 0) {
+        out.append("Recording: off\n");
+        return;
+    }
+    out.appendFormat("Recording: %s, %u records, %zu bytes\n",
+            mPath.string(), mCount, mSize);
+}
+
+static bool readAll(int fd, void* data, size_t size) {
+    uint8_t* p = (uint8_t*)data;
+    while (size > 0) {
+        ssize_t n = read(fd, p, size);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        p += n;
+        size -= n;
+    }
+    return true;
+}
+
+MultiDisplayRecordReader::MultiDisplayRecordReader() :
+    mFd(-1)
+{
+    memset(&mHeader, 0, sizeof(mHeader));
+}
+
+MultiDisplayRecordReader::~MultiDisplayRecordReader() {
+    if (mFd >= 0)
+        close(mFd);
+}
+
+status_t MultiDisplayRecordReader::open(const char* path) {
+    if (mFd >= 0)
+        close(mFd);
+    mFd = ::open(path, O_RDONLY);
+    if (mFd < 0)
+        return NAME_NOT_FOUND;
+    if (!readAll(mFd, &mHeader, sizeof(mHeader)) ||
+            mHeader.magic != MultiDisplayRecorder::MAGIC ||
+            mHeader.version != MultiDisplayRecorder::VERSION) {
+        close(mFd);
+        mFd = -1;
+        return BAD_VALUE;
+    }
+    return NO_ERROR;
+}
+
+status_t MultiDisplayRecordReader::next(MultiDisplayRecord* record, Parcel* args) {
+    if (mFd < 0 || record == NULL || args == NULL)
+        return NO_INIT;
+    if (!readAll(mFd, record, sizeof(MultiDisplayRecord)))
+        return NOT_ENOUGH_DATA;
+    if (record->size > MAX_RECORD_SIZE)
+        return BAD_VALUE;
+    mBuffer.resize(record->size);
+    if (record->size > 0 && !readAll(mFd, mBuffer.editArray(), record->size))
+        return NOT_ENOUGH_DATA;
+    args->setData(mBuffer.array(), record->size);
+    return NO_ERROR;
+}
+
+}; // namespace intel
+}; // namespace android
@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2012-2013, Intel Corporation. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef __MULTIDISPLAY_RECORDER_H__
+#define __MULTIDISPLAY_RECORDER_H__
+
+#include <utils/Errors.h>
+#include <utils/String8.h>
+#include <utils/Timers.h>
+#include <utils/threads.h>
+#include <cutils/atomic.h>
+#include <binder/Parcel.h>
+#include "MultiDisplayMarshal.h"
+
+namespace android {
+namespace intel {
+
+/*
+ * The recorded calls of the composer, the values are kept in the logs,
+ * so a new call is only added at the end.
+ */
+typedef enum {
+    MDS_REC_ALLOCATE_VIDEO_SESSION_ID = 1,
+    MDS_REC_UPDATE_VIDEO_STATE,           // session id, state
+    MDS_REC_RESET_VIDEO_PLAYBACK,
+    MDS_REC_UPDATE_VIDEO_SOURCE_INFO,     // session id, MDSVideoSourceInfo
+    MDS_REC_REGISTER_LISTENER,            // name, msg, the id given
+    MDS_REC_UNREGISTER_LISTENER,          // id
+    MDS_REC_REGISTER_CALLBACK,
+    MDS_REC_UNREGISTER_CALLBACK,
+    MDS_REC_SET_HDMI_TIMING,              // MDSHdmiTiming
+    MDS_REC_SET_HDMI_TIMING_BY_INDEX,     // index
+    MDS_REC_SET_HDMI_SCALING_TYPE,        // MDS_SCALING_TYPE
+    MDS_REC_SET_HDMI_OVERSCAN,            // h, v
+    MDS_REC_APPLY_DISPLAY_CONFIG,         // MDSDisplayConfig
+    MDS_REC_UPDATE_HDMI_CONNECTION,       // connected
+    MDS_REC_UPDATE_WIDI_CONNECTION,       // connected
+    MDS_REC_UPDATE_INPUT_STATE,           // state
+    MDS_REC_UPDATE_PHONE_CALL_STATE,      // state
+    MDS_REC_NOTIFY_INPUT_ACTIVITY,
+    MDS_REC_SET_DECODER_OUTPUT_RESOLUTION, // session id, width, height
+    MDS_REC_SET_VPP_STATE,                // MDS_DISPLAY_ID, on
+    MDS_REC_MAX,
+} MDS_RECORD_OP;
+
+/*
+ * A log is a header and the records in order, all in the host order.
+ * The arguments of a record are written as MDSWire does for a parcel.
+ */
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    // MDS_DISPLAY_MODE when the recording starts
+    int32_t  mode;
+    uint32_t reserved;
+} MultiDisplayRecordHeader;
+
+typedef struct {
+    // Since the recording starts
+    int64_t  time;
+    uint32_t op;
+    uint32_t size;
+} MultiDisplayRecord;
+
+/**
+ * Record the inbound calls of the composer into a log.
+ * Nothing is done if it isn't recording, except an atomic load.
+ * A record is written at once, so the log survives a crash,
+ * and the recording stops when the log is full.
+ */
+class MultiDisplayRecorder {
+public:
+    static const uint32_t MAGIC   = 0x5244534d; // "MDSR"
+    static const uint32_t VERSION = 1;
+    static const size_t   MAX_LOG_SIZE = 4 * 1024 * 1024;
+
+    MultiDisplayRecorder();
+    ~MultiDisplayRecorder();
+
+    // Replace the log at "path", which is in a directory of the service
+    status_t start(const char* path, int32_t mode);
+    void stop();
+    inline bool isRecording() {
+        return android_atomic_acquire_load(&mFd) >= 0;
+    }
+
+    template <typename... Args>
+    inline void record(MDS_RECORD_OP op, const Args&... args) {
+        if (!isRecording())
+            return;
+        Parcel data;
+        if (mdsWrite(data, args...) != NO_ERROR)
+            return;
+        write(op, data.data(), data.dataSize());
+    }
+
+    void dump(String8& out);
+    static const char* getOpName(uint32_t op);
+
+private:
+    Mutex    mLock;
+    volatile int32_t mFd;
+    String8  mPath;
+    nsecs_t  mStart;
+    size_t   mSize;
+    uint32_t mCount;
+
+    void write(MDS_RECORD_OP op, const void* data, size_t size);
+    void close_l();
+};
+
+// Read a log written by MultiDisplayRecorder
+class MultiDisplayRecordReader {
+public:
+    MultiDisplayRecordReader();
+    ~MultiDisplayRecordReader();
+
+    status_t open(const char* path);
+    inline int32_t getStartMode() const {
+        return mHeader.mode;
+    }
+    /**
+     * @brief Read the next record, and its arguments into "args"
+     * @return NOT_ENOUGH_DATA at the end of the log, or if the last record
+     * is truncated, BAD_VALUE if the record is corrupted
+     */
+    status_t next(MultiDisplayRecord* record, Parcel* args);
+
+private:
+    int mFd;
+    MultiDisplayRecordHeader mHeader;
+    Vector<uint8_t> mBuffer;
+};
+
+}; // namespace intel
+}; // namespace android
+
+#endif
@@ -19,12 +19,19 @@
 //#define LOG_NDEBUG 0
 #include <utils/Log.h>
 #include <utils/Errors.h>
+#include <utils/String8.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <private/android_filesystem_config.h>
 
 #include <binder/IServiceManager.h>
 #include <binder/IPCThreadState.h>
 
 #include <display/MultiDisplayService.h>
 #include "MultiDisplayComposer.h"
+#include "MultiDisplayLatency.h"
+#include "MultiDisplayMarshal.h"
 
 namespace android {
 namespace intel {
@@ -40,30 +47,35 @@ do { \
 
 #define IMPLEMENT_API_0(CLASS, OBJECT, INTERFACE, RETURN, ERR)               \
     RETURN CLASS::INTERFACE() {                         \
+        MDS_LATENCY(#CLASS "::" #INTERFACE);                                   \
         MDC_CHECK_OBJECT(OBJECT, ERR);                                         \
         return OBJECT->INTERFACE();                            \
     }
 
 #define IMPLEMENT_API_1(CLASS, OBJECT, INTERFACE, PARAM0, RETURN, ERR)       \
     RETURN CLASS::INTERFACE(PARAM0 p0) {                \
+        MDS_LATENCY(#CLASS "::" #INTERFACE);                                   \
         MDC_CHECK_OBJECT(OBJECT, ERR);                                         \
         return OBJECT->INTERFACE(p0);                          \
     }
 
 #define IMPLEMENT_API_2(CLASS, OBJECT, INTERFACE, PARAM0, PARAM1, RETURN, ERR)          \
     RETURN CLASS::INTERFACE(PARAM0 p0, PARAM1 p1) {                \
+        MDS_LATENCY(#CLASS "::" #INTERFACE);                                              \
         MDC_CHECK_OBJECT(OBJECT, ERR);                                                    \
         return OBJECT->INTERFACE(p0, p1);                                 \
     }
 
 #define IMPLEMENT_API_3(CLASS, OBJECT, INTERFACE, PARAM0, PARAM1, PARAM2, RETURN, ERR)  \
     RETURN CLASS::INTERFACE(PARAM0 p0, PARAM1 p1, PARAM2 p2) {     \
+        MDS_LATENCY(#CLASS "::" #INTERFACE);                                              \
         MDC_CHECK_OBJECT(OBJECT, ERR);                                                    \
         return OBJECT->INTERFACE(p0, p1, p2);                             \
     }
 
 #define IMPLEMENT_API_4(CLASS, OBJECT, INTERFACE, PARAM0, PARAM1, PARAM2, PARAM3, RETURN, ERR)  \
     RETURN CLASS::INTERFACE(PARAM0 p0, PARAM1 p1, PARAM2 p2, PARAM3 p3) {     \
+        MDS_LATENCY(#CLASS "::" #INTERFACE);                                              \
         MDC_CHECK_OBJECT(OBJECT, ERR);                                                    \
         return OBJECT->INTERFACE(p0, p1, p2, p3);                             \
     }
@@ -78,10 +90,12 @@ public:
     int getHdmiTimingCount();
     status_t setHdmiTiming(const MDSHdmiTiming&);
     status_t getHdmiTimingList(int, MDSHdmiTiming**);
+    int getHdmiTimings(MDSHdmiTiming*, int);
     status_t getCurrentHdmiTiming(MDSHdmiTiming*);
     status_t setHdmiTimingByIndex(int);
     status_t setHdmiScalingType(MDS_SCALING_TYPE);
     status_t setHdmiOverscan(int, int);
+    status_t applyDisplayConfig(const MDSDisplayConfig&);
     static sp<MultiDisplayHdmiControlImpl> getInstance() {
         return sHdmiInstance;
     }
@@ -103,6 +117,8 @@ IMPLEMENT_API_1(MultiDisplayHdmiControlImpl, pCom, setHdmiScalingType, MDS_SCALI
 IMPLEMENT_API_1(MultiDisplayHdmiControlImpl, pCom, setHdmiTimingByIndex, int, status_t, NO_INIT)
 IMPLEMENT_API_2(MultiDisplayHdmiControlImpl, pCom, setHdmiOverscan, int, int, status_t, NO_INIT)
 IMPLEMENT_API_2(MultiDisplayHdmiControlImpl, pCom, getHdmiTimingList, int, MDSHdmiTiming**, status_t, NO_INIT)
+IMPLEMENT_API_2(MultiDisplayHdmiControlImpl, pCom, getHdmiTimings, MDSHdmiTiming*, int, int, 0)
+IMPLEMENT_API_1(MultiDisplayHdmiControlImpl, pCom, applyDisplayConfig, const MDSDisplayConfig&, status_t, NO_INIT)
 
 // singleton
 class MultiDisplayVideoControlImpl : public BnMultiDisplayVideoControl {
@@ -112,6 +128,7 @@ private:
 public:
     MultiDisplayVideoControlImpl(const sp<MultiDisplayComposer>& com);
     int allocateVideoSessionId();
+    int allocateVideoSession(const sp<IBinder>&);
     status_t updateVideoState(int, MDS_VIDEO_STATE);
     status_t resetVideoPlayback();
     status_t updateVideoSourceInfo(int, const MDSVideoSourceInfo&);
@@ -130,6 +147,7 @@ MultiDisplayVideoControlImpl::MultiDisplayVideoControlImpl(const sp<MultiDisplay
 
 IMPLEMENT_API_0(MultiDisplayVideoControlImpl, pCom, resetVideoPlayback, status_t, NO_INIT)
 IMPLEMENT_API_0(MultiDisplayVideoControlImpl, pCom, allocateVideoSessionId, int, -1)
+IMPLEMENT_API_1(MultiDisplayVideoControlImpl, pCom, allocateVideoSession, const sp<IBinder>&, int, -1)
 IMPLEMENT_API_2(MultiDisplayVideoControlImpl, pCom, updateVideoState, int, MDS_VIDEO_STATE, status_t, NO_INIT)
 IMPLEMENT_API_2(MultiDisplayVideoControlImpl, pCom, updateVideoSourceInfo, int, const MDSVideoSourceInfo&, status_t, NO_INIT)
 
@@ -193,6 +211,9 @@ public:
     MultiDisplayInfoProviderImpl(const sp<MultiDisplayComposer>& com);
     MDS_VIDEO_STATE getVideoState(int);
     bool getVppState();
+    bool isReady();
+    int getExternalDisplayCount();
+    status_t getDisplayState(MDS_DISPLAY_ID, int, MDSDisplayState*);
     int getVideoSessionNumber();
     MDS_DISPLAY_MODE getDisplayMode(bool);
     status_t getVideoSourceInfo(int, MDSVideoSourceInfo*);
@@ -212,6 +233,9 @@ MultiDisplayInfoProviderImpl::MultiDisplayInfoProviderImpl(const sp<MultiDisplay
 
 IMPLEMENT_API_0(MultiDisplayInfoProviderImpl, pCom, getVideoSessionNumber, int, 0)
 IMPLEMENT_API_0(MultiDisplayInfoProviderImpl, pCom, getVppState, bool, false)
+IMPLEMENT_API_0(MultiDisplayInfoProviderImpl, pCom, isReady, bool, false)
+IMPLEMENT_API_0(MultiDisplayInfoProviderImpl, pCom, getExternalDisplayCount, int, 0)
+IMPLEMENT_API_3(MultiDisplayInfoProviderImpl, pCom, getDisplayState, MDS_DISPLAY_ID, int, MDSDisplayState*, status_t, NO_INIT)
 IMPLEMENT_API_1(MultiDisplayInfoProviderImpl, pCom, getVideoState, int,  MDS_VIDEO_STATE, MDS_VIDEO_STATE_UNKNOWN)
 IMPLEMENT_API_1(MultiDisplayInfoProviderImpl, pCom, getDisplayMode, bool, MDS_DISPLAY_MODE,  MDS_MODE_NONE)
 IMPLEMENT_API_2(MultiDisplayInfoProviderImpl, pCom, getVideoSourceInfo, int,  MDSVideoSourceInfo*, status_t, NO_INIT)
@@ -225,6 +249,7 @@ public:
     MultiDisplayEventMonitorImpl(const sp<MultiDisplayComposer>& com);
     status_t updatePhoneCallState(bool);
     status_t updateInputState(bool);
+    status_t notifyInputActivity();
     static sp<MultiDisplayEventMonitorImpl> getInstance() {
         return sEventInstance;
     }
@@ -240,6 +265,7 @@ MultiDisplayEventMonitorImpl::MultiDisplayEventMonitorImpl(const sp<MultiDisplay
 
 IMPLEMENT_API_1(MultiDisplayEventMonitorImpl, pCom, updatePhoneCallState,  bool,  status_t, NO_INIT)
 IMPLEMENT_API_1(MultiDisplayEventMonitorImpl, pCom, updateInputState,      bool,  status_t, NO_INIT)
+IMPLEMENT_API_0(MultiDisplayEventMonitorImpl, pCom, notifyInputActivity,          status_t, NO_INIT)
 
 class MultiDisplayConnectionObserverImpl : public BnMultiDisplayConnectionObserver {
 private:
@@ -330,96 +356,51 @@ public:
     }
 
     virtual sp<IMultiDisplayHdmiControl> getHdmiControl() {
-        Parcel data, reply;
-        data.writeInterfaceToken(IMDService::getInterfaceDescriptor());
-        status_t result = remote()->transact(
-                MDS_SERVICE_GET_HDMI_CONTROL, data, &reply);
-        if (result != NO_ERROR)
-            ALOGE("Trasaction is fail");
-        return interface_cast<IMultiDisplayHdmiControl>(reply.readStrongBinder());
+        return mdsCallValue<sp<IMultiDisplayHdmiControl> >(remote(),
+                getInterfaceDescriptor(), MDS_SERVICE_GET_HDMI_CONTROL, NULL);
     }
 
     virtual sp<IMultiDisplayVideoControl> getVideoControl() {
-        Parcel data, reply;
-        data.writeInterfaceToken(IMDService::getInterfaceDescriptor());
-        status_t result = remote()->transact(
-                MDS_SERVICE_GET_VIDEO_CONTROL, data, &reply);
-        if (result != NO_ERROR)
-            ALOGE("Trasaction is fail");
-        return interface_cast<IMultiDisplayVideoControl>(reply.readStrongBinder());
+        return mdsCallValue<sp<IMultiDisplayVideoControl> >(remote(),
+                getInterfaceDescriptor(), MDS_SERVICE_GET_VIDEO_CONTROL, NULL);
     }
 
     virtual sp<IMultiDisplayEventMonitor> getEventMonitor() {
-        Parcel data, reply;
-        data.writeInterfaceToken(IMDService::getInterfaceDescriptor());
-        status_t result = remote()->transact(
-                MDS_SERVICE_GET_EVENT_MONITOR, data, &reply);
-        if (result != NO_ERROR)
-            ALOGE("Trasaction is fail");
-        return interface_cast<IMultiDisplayEventMonitor>(reply.readStrongBinder());
+        return mdsCallValue<sp<IMultiDisplayEventMonitor> >(remote(),
+                getInterfaceDescriptor(), MDS_SERVICE_GET_EVENT_MONITOR, NULL);
     }
 
     virtual sp<IMultiDisplayCallbackRegistrar> getCallbackRegistrar() {
-        Parcel data, reply;
-        data.writeInterfaceToken(IMDService::getInterfaceDescriptor());
-        status_t result = remote()->transact(
-                MDS_SERVICE_GET_CALLBACK_REGISTRAR, data, &reply);
-        if (result != NO_ERROR)
-            ALOGE("Trasaction is fail");
-        ALOGV("%s", __func__);
-        return interface_cast<IMultiDisplayCallbackRegistrar>(reply.readStrongBinder());
+        return mdsCallValue<sp<IMultiDisplayCallbackRegistrar> >(remote(),
+                getInterfaceDescriptor(), MDS_SERVICE_GET_CALLBACK_REGISTRAR, NULL);
     }
 
     virtual sp<IMultiDisplaySinkRegistrar> getSinkRegistrar() {
-        Parcel data, reply;
-        ALOGV("%s, %d", __func__, __LINE__);
-        data.writeInterfaceToken(IMDService::getInterfaceDescriptor());
-        status_t result = remote()->transact(
-                MDS_SERVICE_GET_SINK_REGISTRAR, data, &reply);
-        if (result != NO_ERROR)
-            ALOGE("Trasaction is fail");
-        ALOGV("%s, %d", __func__, __LINE__);
-        return interface_cast<IMultiDisplaySinkRegistrar>(reply.readStrongBinder());
+        return mdsCallValue<sp<IMultiDisplaySinkRegistrar> >(remote(),
+                getInterfaceDescriptor(), MDS_SERVICE_GET_SINK_REGISTRAR, NULL);
     }
 
     virtual sp<IMultiDisplayInfoProvider> getInfoProvider() {
-        Parcel data, reply;
-        data.writeInterfaceToken(IMDService::getInterfaceDescriptor());
-        status_t result = remote()->transact(
-                MDS_SERVICE_GET_INFO_PROVIDER, data, &reply);
-        if (result != NO_ERROR)
-            ALOGE("Trasaction is fail");
-        return interface_cast<IMultiDisplayInfoProvider>(reply.readStrongBinder());
+        return mdsCallValue<sp<IMultiDisplayInfoProvider> >(remote(),
+                getInterfaceDescriptor(), MDS_SERVICE_GET_INFO_PROVIDER, NULL);
     }
 
     virtual sp<IMultiDisplayConnectionObserver> getConnectionObserver() {
-        Parcel data, reply;
-        data.writeInterfaceToken(IMDService::getInterfaceDescriptor());
-        status_t result = remote()->transact(
-                MDS_SERVICE_GET_CONNECTION_OBSERVER, data, &reply);
-        if (result != NO_ERROR)
-            ALOGE("Trasaction is fail");
-        return interface_cast<IMultiDisplayConnectionObserver>(reply.readStrongBinder());
+        return mdsCallValue<sp<IMultiDisplayConnectionObserver> >(remote(),
+                getInterfaceDescriptor(), MDS_SERVICE_GET_CONNECTION_OBSERVER, NULL);
     }
 
     virtual sp<IMultiDisplayDecoderConfig> getDecoderConfig() {
-        Parcel data, reply;
-        data.writeInterfaceToken(IMDService::getInterfaceDescriptor());
-        status_t result = remote()->transact(
-                MDS_SERVICE_GET_DECODER_CONFIG, data, &reply);
-        if (result != NO_ERROR)
-            ALOGE("Trasaction is fail");
-        return interface_cast<IMultiDisplayDecoderConfig>(reply.readStrongBinder());
+        return mdsCallValue<sp<IMultiDisplayDecoderConfig> >(remote(),
+                getInterfaceDescriptor(), MDS_SERVICE_GET_DECODER_CONFIG, NULL);
     }
+
+#ifdef TARGET_HAS_VPP
     virtual sp<IMultiDisplayVppConfig> getVppConfig() {
-        Parcel data, reply;
-        data.writeInterfaceToken(IMDService::getInterfaceDescriptor());
-        status_t result = remote()->transact(
-                MDS_SERVICE_GET_VPP_CONFIG, data, &reply);
-        if (result != NO_ERROR)
-            ALOGE("Trasaction is fail");
-        return interface_cast<IMultiDisplayVppConfig>(reply.readStrongBinder());
+        return mdsCallValue<sp<IMultiDisplayVppConfig> >(remote(),
+                getInterfaceDescriptor(), MDS_SERVICE_GET_VPP_CONFIG, NULL);
     }
+#endif
 };
 
 IMPLEMENT_META_INTERFACE(MDService,"com.intel.MDService");
@@ -430,69 +411,57 @@ status_t BnMDService::onTransact(
     switch (code) {
         case MDS_SERVICE_GET_HDMI_CONTROL: {
             CHECK_INTERFACE(IMDService, data, reply);
-            sp<IBinder> b = this->getHdmiControl()->asBinder();
-            reply->writeStrongBinder(b);
-            return NO_ERROR;
+            return mdsDispatch(this, &IMDService::getHdmiControl, data, reply);
         }
         case MDS_SERVICE_GET_VIDEO_CONTROL: {
             CHECK_INTERFACE(IMDService, data, reply);
-            sp<IBinder> b = this->getVideoControl()->asBinder();
-            reply->writeStrongBinder(b);
-            return NO_ERROR;
+            return mdsDispatch(this, &IMDService::getVideoControl, data, reply);
         }
         case MDS_SERVICE_GET_EVENT_MONITOR: {
             CHECK_INTERFACE(IMDService, data, reply);
-            sp<IBinder> b = this->getEventMonitor()->asBinder();
-            reply->writeStrongBinder(b);
-            return NO_ERROR;
+            return mdsDispatch(this, &IMDService::getEventMonitor, data, reply);
         }
         case MDS_SERVICE_GET_CALLBACK_REGISTRAR: {
             CHECK_INTERFACE(IMDService, data, reply);
-            sp<IBinder> b = this->getCallbackRegistrar()->asBinder();
-            reply->writeStrongBinder(b);
-            ALOGV("%s", __func__);
-            return NO_ERROR;
+            return mdsDispatch(this, &IMDService::getCallbackRegistrar, data, reply);
         }
         case MDS_SERVICE_GET_SINK_REGISTRAR: {
             CHECK_INTERFACE(IMDService, data, reply);
-            sp<IBinder> b = this->getSinkRegistrar()->asBinder();
-            reply->writeStrongBinder(b);
-            ALOGV("%s", __func__);
-            return NO_ERROR;
+            return mdsDispatch(this, &IMDService::getSinkRegistrar, data, reply);
         }
         case MDS_SERVICE_GET_INFO_PROVIDER: {
             CHECK_INTERFACE(IMDService, data, reply);
-            sp<IBinder> b = this->getInfoProvider()->asBinder();
-            reply->writeStrongBinder(b);
-            return NO_ERROR;
+            return mdsDispatch(this, &IMDService::getInfoProvider, data, reply);
         }
         case MDS_SERVICE_GET_CONNECTION_OBSERVER: {
             CHECK_INTERFACE(IMDService, data, reply);
-            sp<IBinder> b = this->getConnectionObserver()->asBinder();
-            reply->writeStrongBinder(b);
-            return NO_ERROR;
+            return mdsDispatch(this, &IMDService::getConnectionObserver, data, reply);
         }
         case MDS_SERVICE_GET_DECODER_CONFIG: {
             CHECK_INTERFACE(IMDService, data, reply);
-            sp<IBinder> b = this->getDecoderConfig()->asBinder();
-            reply->writeStrongBinder(b);
-            return NO_ERROR;
+            return mdsDispatch(this, &IMDService::getDecoderConfig, data, reply);
         }
+#ifdef TARGET_HAS_VPP
         case MDS_SERVICE_GET_VPP_CONFIG: {
             CHECK_INTERFACE(IMDService, data, reply);
-            sp<IBinder> b = this->getVppConfig()->asBinder();
-            reply->writeStrongBinder(b);
-            return NO_ERROR;
+            return mdsDispatch(this, &IMDService::getVppConfig, data, reply);
         }
+#endif
         default:
             return BBinder::onTransact(code, data, reply, flags);
     } // switch
 }
 
 
+struct MultiDisplayService::Impl {
+    sp<MultiDisplayComposer> composer;
+};
+
 MultiDisplayService::MultiDisplayService() {
     LOGI("%s: create a MultiDisplay service %p", __func__, this);
     sp<MultiDisplayComposer> com   = new MultiDisplayComposer();
+    mImpl = new Impl;
+    mImpl->composer = com;
     new MultiDisplayHdmiControlImpl(com);
     new MultiDisplayVideoControlImpl(com);
     new MultiDisplayEventMonitorImpl(com);
@@ -506,6 +475,7 @@ MultiDisplayService::MultiDisplayService() {
 
 MultiDisplayService::~MultiDisplayService() {
     LOGV("%s: MultiDisplay service %p is destoryed", __func__, this);
+    delete mImpl;
 }
 
 void MultiDisplayService::instantiate() {
@@ -514,6 +484,46 @@ void MultiDisplayService::instantiate() {
         ALOGE("Failed to start %s service", INTEL_MDS_SERVICE_NAME);
 }
 
+status_t MultiDisplayService::dump(int fd, const Vector<String16>& args) {
+    sp<MultiDisplayComposer> com = mImpl->composer;
+    String8 out;
+    if (!checkCallingPermission(String16("android.permission.DUMP"))) {
+        out.appendFormat("Permission Denial: can't dump MultiDisplay from pid=%d, uid=%d\n",
+                IPCThreadState::self()->getCallingPid(),
+                IPCThreadState::self()->getCallingUid());
+    } else if (com != NULL) {
+        // "--record" starts recording the calls, "--record-stop" stops it,
+        // only for a developer, the log is in the data directory of MDS
+        bool record = args.size() >= 1 && args[0] == String16("--record");
+        bool stop = args.size() >= 1 && args[0] == String16("--record-stop");
+        uid_t uid = IPCThreadState::self()->getCallingUid();
+        if ((record || stop) && uid != AID_ROOT && uid != AID_SHELL) {
+            out.appendFormat("Permission Denial: can't record from uid=%d\n", uid);
+        } else if (record) {
+            status_t err = com->startRecording();
+            out.appendFormat("Start recording: %d\n", err);
+        } else if (stop) {
+            com->stopRecording();
+            out.append("Stop recording\n");
+        }
+        com->dump(out);
+    }
+    const char* buf = out.string();
+    size_t left = out.size();
+    while (left > 0) {
+        ssize_t n = write(fd, buf, left);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0) {
+            ALOGW("%s: failed to write the dump, %s", __func__, strerror(errno));
+            break;
+        }
+        buf += n;
+        left -= n;
+    }
+    return NO_ERROR;
+}
+
 sp<IMultiDisplayHdmiControl> MultiDisplayService::getHdmiControl() {
 	return MultiDisplayHdmiControlImpl::getInstance();
 }
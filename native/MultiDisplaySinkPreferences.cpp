@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2012-2013, Intel Corporation. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+//#define LOG_NDEBUG 0
+#include <utils/Log.h>
+#include <string.h>
+
+#include "MultiDisplaySinkPreferences.h"
+
+namespace android {
+namespace intel {
+
+static const uint32_t PREFERENCES_MAGIC   = 0x5053444d; // "MDSP"
+static const uint32_t PREFERENCES_VERSION = 1;
+
+MultiDisplaySinkPreferences::MultiDisplaySinkPreferences(const char* path) :
+    mStore(path, PREFERENCES_MAGIC, PREFERENCES_VERSION),
+    mLoaded(false)
+{
+    memset(&mTable, 0, sizeof(mTable));
+}
+
+void MultiDisplaySinkPreferences::load() {
+    if (mLoaded)
+        return;
+    mLoaded = true;
+    if (mStore.load(&mTable, sizeof(mTable)) != NO_ERROR ||
+            mTable.count < 0 || mTable.count > MAX_SINKS)
+        memset(&mTable, 0, sizeof(mTable));
+    ALOGV("%d sink preferences", mTable.count);
+}
+
+int MultiDisplaySinkPreferences::indexOf(const uint8_t* sink) {
+    for (int i = 0; i < mTable.count; i++) {
+        if (memcmp(mTable.entries[i].sink, sink, DRM_HDMI_SINK_ID_LEN) == 0)
+            return i;
+    }
+    return -1;
+}
+
+bool MultiDisplaySinkPreferences::find(
+        const uint8_t* sink, MultiDisplaySinkPreference* pref) {
+    if (sink == NULL || pref == NULL)
+        return false;
+    load();
+    int i = indexOf(sink);
+    if (i < 0)
+        return false;
+    memcpy(pref, &mTable.entries[i].pref, sizeof(MultiDisplaySinkPreference));
+    return true;
+}
+
+void MultiDisplaySinkPreferences::update(
+        const uint8_t* sink, const MultiDisplaySinkPreference& pref) {
+    if (sink == NULL)
+        return;
+    load();
+    Entry entry;
+    memset(&entry, 0, sizeof(entry));
+    memcpy(entry.sink, sink, DRM_HDMI_SINK_ID_LEN);
+    // Field by field, the padding stays zero
+    entry.pref.timingSelected = pref.timingSelected;
+    if (pref.timingSelected)
+        entry.pref.timing = pref.timing;
+    entry.pref.scaleType = pref.scaleType;
+    entry.pref.hStep = pref.hStep;
+    entry.pref.vStep = pref.vStep;
+
+    int i = indexOf(sink);
+    if (i == 0 && memcmp(&mTable.entries[0], &entry, sizeof(entry)) == 0)
+        return;
+    // Move the sink to the head, drop the last one if the table is full
+    if (i < 0) {
+        if (mTable.count < MAX_SINKS)
+            mTable.count++;
+        i = mTable.count - 1;
+    }
+    memmove(&mTable.entries[1], &mTable.entries[0], i * sizeof(Entry));
+    mTable.entries[0] = entry;
+    mStore.save(&mTable, sizeof(mTable));
+}
+
+}; // namespace intel
+}; // namespace android
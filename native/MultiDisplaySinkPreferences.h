@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2012-2013, Intel Corporation. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef __MULTIDISPLAY_SINK_PREFERENCES_H__
+#define __MULTIDISPLAY_SINK_PREFERENCES_H__
+
+#include <display/MultiDisplayType.h>
+#include "MultiDisplayStore.h"
+#include "drm_hdmi.h"
+
+namespace android {
+namespace intel {
+
+// The settings chosen by the user for a sink
+typedef struct {
+    int32_t       timingSelected;
+    MDSHdmiTiming timing;
+    int32_t       scaleType;
+    uint32_t      hStep;
+    uint32_t      vStep;
+} MultiDisplaySinkPreference;
+
+/**
+ * The preferences of the recently used sinks, kept across reboots.
+ * A sink is identified by the product info of its EDID, the least
+ * recently updated one is dropped when the table is full.
+ * The caller serializes the access.
+ */
+class MultiDisplaySinkPreferences {
+public:
+    static const int MAX_SINKS = 16;
+
+    MultiDisplaySinkPreferences(const char* path);
+
+    /** @brief Look up the preference of "sink", false if it is unknown */
+    bool find(const uint8_t* sink, MultiDisplaySinkPreference* pref);
+    /** @brief Record the preference of "sink", and write the table if it changes */
+    void update(const uint8_t* sink, const MultiDisplaySinkPreference& pref);
+
+private:
+    typedef struct {
+        uint8_t sink[DRM_HDMI_SINK_ID_LEN];
+        MultiDisplaySinkPreference pref;
+    } Entry;
+
+    // The file content, the entries are in most recently used order
+    typedef struct {
+        int32_t count;
+        Entry   entries[MAX_SINKS];
+    } Table;
+
+    MultiDisplayStore mStore;
+    Table mTable;
+    // The table is read at the first access
+    bool  mLoaded;
+
+    void load();
+    int  indexOf(const uint8_t* sink);
+};
+
+}; // namespace intel
+}; // namespace android
+
+#endif
@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2012-2013, Intel Corporation. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+//#define LOG_NDEBUG 0
+#include <utils/Log.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "MultiDisplayStore.h"
+#include "drm_hdmi.h"
+
+namespace android {
+namespace intel {
+
+// The file header, followed by the record
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t size;
+    uint32_t checksum;
+} MDSStoreHeader;
+
+MultiDisplayStore::MultiDisplayStore(
+        const char* path, uint32_t magic, uint32_t version) :
+    mPath(path),
+    mMagic(magic),
+    mVersion(version)
+{
+}
+
+uint32_t MultiDisplayStore::checksum(const void* data, size_t size) {
+    return hashEdid(data, size);
+}
+
+static bool writeAll(int fd, const void* data, size_t size) {
+    const uint8_t* p = (const uint8_t*)data;
+    while (size > 0) {
+        ssize_t n = write(fd, p, size);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        p += n;
+        size -= n;
+    }
+    return true;
+}
+
+static bool readAll(int fd, void* data, size_t size) {
+    uint8_t* p = (uint8_t*)data;
+    while (size > 0) {
+        ssize_t n = read(fd, p, size);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        p += n;
+        size -= n;
+    }
+    return true;
+}
+
+status_t MultiDisplayStore::save(const void* data, size_t size) {
+    if (data == NULL || size == 0)
+        return BAD_VALUE;
+    MDSStoreHeader header;
+    header.magic    = mMagic;
+    header.version  = mVersion;
+    header.size     = size;
+    header.checksum = checksum(data, size);
+
+    String8 tmp(mPath);
+    tmp.append(".tmp");
+    int fd = open(tmp.string(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0) {
+        ALOGW("Fail to create %s, %s", tmp.string(), strerror(errno));
+        return UNKNOWN_ERROR;
+    }
+    // The data reach the disk before the rename, or a power loss
+    // may leave the new name on an empty file
+    bool ok = writeAll(fd, &header, sizeof(header)) && writeAll(fd, data, size) &&
+        fsync(fd) == 0;
+    close(fd);
+    // The rename is atomic against a crash of the process
+    if (!ok || rename(tmp.string(), mPath.string()) != 0) {
+        ALOGW("Fail to write %s, %s", mPath.string(), strerror(errno));
+        unlink(tmp.string());
+        return UNKNOWN_ERROR;
+    }
+    ALOGV("Save %zu bytes to %s", size, mPath.string());
+    return NO_ERROR;
+}
+
+status_t MultiDisplayStore::load(void* data, size_t size) {
+    if (data == NULL || size == 0)
+        return BAD_VALUE;
+    int fd = open(mPath.string(), O_RDONLY);
+    if (fd < 0)
+        return NAME_NOT_FOUND;
+    MDSStoreHeader header;
+    bool ok = readAll(fd, &header, sizeof(header)) &&
+        header.magic == mMagic && header.version == mVersion &&
+        header.size == size && readAll(fd, data, size);
+    close(fd);
+    if (!ok || header.checksum != checksum(data, size)) {
+        ALOGW("Drop the invalid record %s", mPath.string());
+        return BAD_VALUE;
+    }
+    return NO_ERROR;
+}
+
+status_t MultiDisplayStore::remove() {
+    if (unlink(mPath.string()) != 0 && errno != ENOENT)
+        return UNKNOWN_ERROR;
+    return NO_ERROR;
+}
+
+}; // namespace intel
+}; // namespace android
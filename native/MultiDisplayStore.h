@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2012-2013, Intel Corporation. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef __MULTIDISPLAY_STORE_H__
+#define __MULTIDISPLAY_STORE_H__
+
+#include <utils/Errors.h>
+#include <utils/String8.h>
+
+namespace android {
+namespace intel {
+
+/**
+ * A binary record kept in a local file.
+ * The record is written into a temporary file which then replaces
+ * the old one by rename, so a reader sees the old or the new record,
+ * never a partial one. The caller serializes the writes.
+ */
+class MultiDisplayStore {
+public:
+    MultiDisplayStore(const char* path, uint32_t magic, uint32_t version);
+
+    /** @brief Replace the record by "size" bytes of "data" */
+    status_t save(const void* data, size_t size);
+    /**
+     * @brief Read the record into "data"
+     * @return NAME_NOT_FOUND if there is no record, BAD_VALUE if it is
+     * corrupted or written by another version
+     */
+    status_t load(void* data, size_t size);
+    status_t remove();
+
+private:
+    String8  mPath;
+    uint32_t mMagic;
+    uint32_t mVersion;
+
+    static uint32_t checksum(const void* data, size_t size);
+};
+
+}; // namespace intel
+}; // namespace android
+
+#endif
@@ -28,6 +28,7 @@
 #include "linux/psb_drm.h"
 #endif
 #include "drm_hdmi.h"
+#include "MultiDisplayTrace.h"
 #include "xf86drm.h"
 #include "xf86drmMode.h"
 
@@ -37,12 +38,16 @@ namespace intel {
 
 #define EDID_PRODUCT_INFO_LEN   8
 #define PREFERRED_VREFRESH      60  // 60Hz
+// A benchmark build with a fake libdrm points it to a harmless node
+#ifndef DRM_DEVICE_NAME
 #define DRM_DEVICE_NAME         "/dev/card0"
+#endif
 
 
-typedef struct _drmContext {
-    int  drmFD;
-    bool hdmiSupported;
+// The state of one external connector
+typedef struct _drmConnectorContext {
+    uint32_t connectorId;
+    uint32_t connectorType;
     //bool newDevice;
     bool connected;
     int  preferredModeIndex;
@@ -54,57 +59,97 @@ typedef struct _drmContext {
 #endif
     Vector<MDSHdmiTiming*> hdmiTimings;
     drmModeConnectorPtr hdmiConnector;
+    // Hash of the EDID read at the last connection status check
+    uint32_t edidHash;
+    // EDID product info of the sink, @see drm_hdmi_getSinkId
+    uint8_t  sinkId[DRM_HDMI_SINK_ID_LEN];
+} drmConnectorContext;
+
+typedef struct _drmContext {
+    int  drmFD;
+    // External connectors found by drm_init, in the order of sExternalTypes
+    int  connectorCount;
+    drmConnectorContext connectors[MDS_EXTERNAL_DISPLAY_MAX];
 } drmContext;
 
 static drmContext gDrmCxt;
 
-static drmModeConnector* getConnector(int fd, uint32_t connector_type)
+// The connector types treated as external displays, in priority order
+static const uint32_t sExternalTypes[] = {
+#ifndef VPG_DRM
+    DRM_MODE_CONNECTOR_DVID,
+#else
+    DRM_MODE_CONNECTOR_HDMIA,
+    DRM_MODE_CONNECTOR_HDMIB,
+    DRM_MODE_CONNECTOR_DisplayPort,
+#endif
+};
+
+static inline drmConnectorContext* getContext(int index)
 {
-    ALOGV("Entering %s, %d", __func__, connector_type);
-    drmModeRes *resources = drmModeGetResources(fd);
-    drmModeConnector *connector = NULL;
-    int i;
+    if (index < 0 || index >= gDrmCxt.connectorCount)
+        return NULL;
+    return &gDrmCxt.connectors[index];
+}
 
+/*
+ * Enumerate the external connectors,
+ * whatever a sink is connected or not.
+ */
+static int enumerateConnectors(int fd)
+{
+    drmModeRes *resources = drmModeGetResources(fd);
     if (resources == NULL || resources->connectors == NULL) {
         ALOGE("%s: drmModeGetResources failed.", __func__);
-        return NULL;
+        if (resources)
+            drmModeFreeResources(resources);
+        return 0;
     }
-    for (i = 0; i < resources->count_connectors; i++) {
-        connector = drmModeGetConnector(fd, resources->connectors[i]);
+    // A connector is probed once, then ordered by sExternalTypes
+    int total = resources->count_connectors;
+    uint32_t* types = new uint32_t[total];
+    for (int i = 0; i < total; i++) {
+        types[i] = 0;
+        drmModeConnector *connector =
+            drmModeGetConnector(fd, resources->connectors[i]);
         if (connector == NULL)
             continue;
-        if (connector->count_modes <= 0)
-            continue;
-        if (connector->connector_type == connector_type)
-            break;
-
+        types[i] = connector->connector_type;
         drmModeFreeConnector(connector);
-        connector = NULL;
     }
-    drmModeFreeResources(resources);
-    if (connector == NULL) {
-        ALOGE("%s: Failed to get conector", __func__);
+    int count = 0;
+    size_t typeCount = sizeof(sExternalTypes) / sizeof(sExternalTypes[0]);
+    for (size_t t = 0; t < typeCount; t++) {
+        for (int i = 0; i < total; i++) {
+            if (count >= MDS_EXTERNAL_DISPLAY_MAX)
+                break;
+            if (types[i] != sExternalTypes[t])
+                continue;
+            drmConnectorContext* cxt = &gDrmCxt.connectors[count++];
+            cxt->connectorId = resources->connectors[i];
+            cxt->connectorType = types[i];
+            ALOGI("External connector %d: id %d, type %d",
+                    count - 1, cxt->connectorId, cxt->connectorType);
+        }
     }
-    ALOGV("Leaving %s, %d", __func__, connector_type);
-    return connector;
+    delete[] types;
+    drmModeFreeResources(resources);
+    return count;
 }
 
-static drmModeConnectorPtr getHdmiConnector()
+static drmModeConnectorPtr getHdmiConnector(drmConnectorContext* cxt)
 {
-    if (gDrmCxt.hdmiConnector == NULL)
-#ifndef VPG_DRM
-        gDrmCxt.hdmiConnector = getConnector(gDrmCxt.drmFD, DRM_MODE_CONNECTOR_DVID);
-#else
-        gDrmCxt.hdmiConnector = getConnector(gDrmCxt.drmFD, DRM_MODE_CONNECTOR_HDMIA);
-        if (gDrmCxt.hdmiConnector == NULL) {
-            gDrmCxt.hdmiConnector = getConnector(gDrmCxt.drmFD, DRM_MODE_CONNECTOR_HDMIB);
-        }
-#endif
-    if (gDrmCxt.hdmiConnector == NULL || gDrmCxt.hdmiConnector->modes == NULL) {
+    if (cxt->hdmiConnector == NULL) {
+        // The connector probe, it may be a slow DDC transfer
+        MDS_TRACE_NAME("drmModeGetConnector");
+        cxt->hdmiConnector = drmModeGetConnector(gDrmCxt.drmFD, cxt->connectorId);
+    }
+    if (cxt->hdmiConnector == NULL || cxt->hdmiConnector->count_modes <= 0 ||
+            cxt->hdmiConnector->modes == NULL) {
         ALOGW("Please check HDMI cable is connected or not");
         return NULL;
     }
-    return gDrmCxt.hdmiConnector;
+    return cxt->hdmiConnector;
 }
 
 static inline bool drm_is_preferred_flags(unsigned int flags)
@@ -119,7 +164,8 @@ static inline bool drm_is_preferred_flags(unsigned int flags)
 #endif
 }
 
-static void drm_select_preferredmode(drmModeConnectorPtr connector)
+static void drm_select_preferredmode(drmConnectorContext* cxt,
+        drmModeConnectorPtr connector)
 {
     int index_preferred = -1;
     int hdisplay = 0, vdisplay = 0;
@@ -172,19 +218,19 @@ static void drm_select_preferredmode(drmModeConnectorPtr connector)
         }
     }
 
-    gDrmCxt.preferredModeIndex = 0;
+    cxt->preferredModeIndex = 0;
     if (index_preferred != -1 &&
             connector->modes[index_preferred].vrefresh == PREFERRED_VREFRESH) {
-        gDrmCxt.preferredModeIndex = index_preferred;
+        cxt->preferredModeIndex = index_preferred;
     } else if (index_1080P != -1) {
-        gDrmCxt.preferredModeIndex = index_1080P;
+        cxt->preferredModeIndex = index_1080P;
     } else if (index_720P != -1) {
-        gDrmCxt.preferredModeIndex = index_720P;
+        cxt->preferredModeIndex = index_720P;
     } else if (index_max != -1) {
-        gDrmCxt.preferredModeIndex = index_max;
+        cxt->preferredModeIndex = index_max;
     }
 
-    index_preferred = gDrmCxt.preferredModeIndex;
+    index_preferred = cxt->preferredModeIndex;
     ALOGI("HDMI preferred timing is: %dx%d@%dHz, index = %d",
             connector->modes[index_preferred].hdisplay,
             connector->modes[index_preferred].vdisplay,
@@ -193,57 +239,63 @@ static void drm_select_preferredmode(drmModeConnectorPtr connector)
 
 }
 
-static void addHdmiTimings(MDSHdmiTiming* dst) {
+static void addHdmiTimings(drmConnectorContext* cxt, MDSHdmiTiming* dst) {
     MDSHdmiTiming* bak = new MDSHdmiTiming;
     memcpy(bak, dst, sizeof(MDSHdmiTiming));
-    gDrmCxt.hdmiTimings.add(bak);
+    cxt->hdmiTimings.add(bak);
 }
 
-static void clearHdmiTimings() {
-    gDrmCxt.selectedModeIndex = -1;
-    for (unsigned int i = 0; i < gDrmCxt.hdmiTimings.size(); i++) {
-        MDSHdmiTiming* timing = gDrmCxt.hdmiTimings.itemAt(i);
+static void clearHdmiTimings(drmConnectorContext* cxt) {
+    cxt->selectedModeIndex = -1;
+    for (unsigned int i = 0; i < cxt->hdmiTimings.size(); i++) {
+        MDSHdmiTiming* timing = cxt->hdmiTimings.itemAt(i);
         delete timing;
         timing = NULL;
     }
-    gDrmCxt.hdmiTimings.clear();
-    ALOGV("Clear Hdmi Timings backup, %d", gDrmCxt.hdmiTimings.size());
+    cxt->hdmiTimings.clear();
+    ALOGV("Clear Hdmi Timings backup, %d", cxt->hdmiTimings.size());
 }
 
-bool drm_init()
-{
-    //gDrmCxt.newDevice = false;;
-    gDrmCxt.connected = false;
-    gDrmCxt.preferredModeIndex = -1;
-    gDrmCxt.selectedModeIndex = -1;
-    gDrmCxt.hdmiConnector = NULL;
+static void resetConnector(drmConnectorContext* cxt) {
+    clearHdmiTimings(cxt);
+    //cxt->newDevice = false;;
+    cxt->connected = false;
+    cxt->preferredModeIndex = -1;
+    cxt->edidHash = 0;
+    memset(cxt->sinkId, 0, DRM_HDMI_SINK_ID_LEN);
+    if (cxt->hdmiConnector)
+        drmModeFreeConnector(cxt->hdmiConnector);
+    cxt->hdmiConnector = NULL;
 #if 0 // Don't keep prevoius device EDID
-    memset(gDrmCxt.productInfo, 0,EDID_PRODUCT_INFO_LEN);
+    memset(cxt->productInfo, 0,EDID_PRODUCT_INFO_LEN);
 #endif
+}
+
+bool drm_init()
+{
+    MDS_TRACE_CALL();
+    gDrmCxt.connectorCount = 0;
+    for (int i = 0; i < MDS_EXTERNAL_DISPLAY_MAX; i++) {
+        drmConnectorContext* cxt = &gDrmCxt.connectors[i];
+        cxt->hdmiConnector = NULL;
+        resetConnector(cxt);
+        cxt->hdmiTimings.setCapacity(HDMI_TIMING_MAX);
+    }
 #ifndef VPG_DRM
     gDrmCxt.drmFD = open(DRM_DEVICE_NAME, O_RDWR, 0);
     if (gDrmCxt.drmFD <= 0) {
         ALOGE("%s: Failed to open %s", __func__, DRM_DEVICE_NAME);
         return false;
     }
-    drmModeConnectorPtr connector = getConnector(gDrmCxt.drmFD, DRM_MODE_CONNECTOR_DVID);
 #else
     gDrmCxt.drmFD = drmOpen("i915", NULL);
     if (gDrmCxt.drmFD <= 0) {
         ALOGE("%s: Failed to open drm", __func__);
         return false;
     }
-    drmModeConnectorPtr connector = getConnector(gDrmCxt.drmFD, DRM_MODE_CONNECTOR_HDMIA);
-    if (connector == NULL) {
-        connector = getConnector(gDrmCxt.drmFD, DRM_MODE_CONNECTOR_HDMIB);
-    }
 #endif
-    gDrmCxt.hdmiSupported = (connector != NULL);
-    if (connector) {
-        drmModeFreeConnector(connector);
-        connector = NULL;
-    }
-    gDrmCxt.hdmiTimings.setCapacity(HDMI_TIMING_MAX);
+    gDrmCxt.connectorCount = enumerateConnectors(gDrmCxt.drmFD);
+    ALOGI("%d external connectors", gDrmCxt.connectorCount);
     return true;
 }
 
@@ -251,19 +303,33 @@ void drm_cleanup()
 {
     if (gDrmCxt.drmFD > 0)
         drmClose(gDrmCxt.drmFD);
-    if (gDrmCxt.hdmiConnector)
-        drmModeFreeConnector(gDrmCxt.hdmiConnector);
+    gDrmCxt.drmFD = -1;
+    for (int i = 0; i < gDrmCxt.connectorCount; i++)
+        resetConnector(&gDrmCxt.connectors[i]);
+    gDrmCxt.connectorCount = 0;
+}
 
-    memset(&gDrmCxt, 0, sizeof(drmContext));
+int drm_hdmi_getConnectorCount()
+{
+    return gDrmCxt.connectorCount;
 }
 
-bool drm_hdmi_onHdmiDisconnected(void)
+bool drm_hdmi_isDisplayPort(int index)
 {
-    clearHdmiTimings();
-    gDrmCxt.connected = false;
-    if (gDrmCxt.hdmiConnector)
-        drmModeFreeConnector(gDrmCxt.hdmiConnector);
-    gDrmCxt.hdmiConnector = NULL;
+#ifdef VPG_DRM
+    drmConnectorContext* cxt = getContext(index);
+    return cxt != NULL && cxt->connectorType == DRM_MODE_CONNECTOR_DisplayPort;
+#else
+    return false;
+#endif
+}
+
+bool drm_hdmi_onHdmiDisconnected(int index)
+{
+    drmConnectorContext* cxt = getContext(index);
+    if (cxt == NULL)
+        return false;
+    resetConnector(cxt);
     return true;
 }
 
@@ -283,22 +349,30 @@ bool drm_hdmi_notify_audio_hotplug(bool plugin)
 #endif
 }
 
-// return 0 - not connected, 1 - HDMI connected, 2 - DVI connected
-int drm_hdmi_getConnectionStatus()
+// return 0 - not connected, 1 - HDMI connected, 2 - DVI connected, 3 - DP connected
+int drm_hdmi_getConnectionStatus(int index)
 {
-    ALOGV("Entering %s", __func__);
-    if (!gDrmCxt.hdmiSupported)
-        return 0;
-
-    if (gDrmCxt.hdmiConnector)
-        drmModeFreeConnector(gDrmCxt.hdmiConnector);
-    gDrmCxt.hdmiConnector = NULL;
+    MDS_TRACE_CALL();
+    ALOGV("Entering %s, %d", __func__, index);
+    drmConnectorContext* cxt = getContext(index);
+    if (cxt == NULL)
+        return DRM_HDMI_DISCONNECTED;
+
+    if (cxt->hdmiConnector)
+        drmModeFreeConnector(cxt->hdmiConnector);
+    cxt->hdmiConnector = NULL;
     // reset connection status
-    gDrmCxt.connected = false;
-    drmModeConnector *connector = getHdmiConnector();
-    if (connector == NULL)
-        return 0;
-    int ret = 0;
+    uint32_t lastEdidHash = cxt->edidHash;
+    cxt->connected = false;
+    cxt->edidHash = 0;
+    memset(cxt->sinkId, 0, DRM_HDMI_SINK_ID_LEN);
+    drmModeConnector *connector = getHdmiConnector(cxt);
+    if (connector == NULL) {
+        if (lastEdidHash != 0)
+            clearHdmiTimings(cxt);
+        return DRM_HDMI_DISCONNECTED;
+    }
+    int ret = DRM_HDMI_DISCONNECTED;
 
     // Read EDID, and check whether it's HDMI or DVI interface
     for (int i = 0; i < connector->count_props; i++) {
@@ -312,6 +386,7 @@ int drm_hdmi_getConnectionStatus()
             continue;
         }
 
+        MDS_TRACE_NAME("EDID read");
         uint64_t* edid = &connector->prop_values[i];
         drmModePropertyBlobPtr edidBlob = drmModeGetPropertyBlob(gDrmCxt.drmFD, *edid);
         if (edidBlob == NULL ||
@@ -319,27 +394,35 @@ int drm_hdmi_getConnectionStatus()
             edidBlob->length < HDMI_TIMING_MAX) {
             ALOGE("%s: Invalid EDID Blob.", __func__);
             drmModeFreeProperty(props);
-            ret = 0;
+            ret = DRM_HDMI_DISCONNECTED;
             break;
         }
 
         char* edid_binary = (char *)edidBlob->data;
         // offset of product_info
         char* product_info = edid_binary + 8;
-        gDrmCxt.connected = true;
+        cxt->connected = true;
+        cxt->edidHash = hashEdid((const uint8_t*)edidBlob->data, edidBlob->length);
+        memcpy(cxt->sinkId, product_info, DRM_HDMI_SINK_ID_LEN);
 #if 0   // Don't keep prevoius device EDID
-        gDrmCxt.newDevice = false;
-        if (memcmp(gDrmCxt.productInfo, product_info, EDID_PRODUCT_INFO_LEN)) {
+        cxt->newDevice = false;
+        if (memcmp(cxt->productInfo, product_info, EDID_PRODUCT_INFO_LEN)) {
             ALOGI("A new HDMI sink is connected.");
-            gDrmCxt.newDevice = true;
-            memcpy(gDrmCxt.productInfo, product_info, EDID_PRODUCT_INFO_LEN);
+            cxt->newDevice = true;
+            memcpy(cxt->productInfo, product_info, EDID_PRODUCT_INFO_LEN);
             //clear HDMI timings backup
-            clearHdmiTimings();
+            clearHdmiTimings(cxt);
         }
 #endif
-        drm_select_preferredmode(connector);
+        drm_select_preferredmode(cxt, connector);
 
-        ret = 2; // DVI
+        if (drm_hdmi_isDisplayPort(index)) {
+            ret = DRM_DP_CONNECTED;
+            drmModeFreeProperty(props);
+            break;
+        }
+
+        ret = DRM_DVI_CONNECTED;
         if (edid_binary[126] == 0) {
             drmModeFreeProperty(props);
             break;
@@ -351,7 +434,7 @@ int drm_hdmi_getConnectionStatus()
             if (edid_binary[n]   == 0x03 &&
                 edid_binary[n+1] == 0x0c &&
                 edid_binary[n+2] == 0x00) {
-                ret = 1; //HDMI
+                ret = DRM_HDMI_CONNECTED;
                 break;
             }
         }
@@ -359,17 +442,24 @@ int drm_hdmi_getConnectionStatus()
         break;
     }
 
-    ALOGD("External Display device is %d", ret);
+    // An unplug and a replug may come as one probe, the timings
+    // of another sink, or of none, are dropped
+    if (cxt->edidHash != lastEdidHash) {
+        ALOGI("The sink of connector %d is changed", index);
+        clearHdmiTimings(cxt);
+    }
+    ALOGD("External Display device %d is %d", index, ret);
     return ret;
 }
 
 /*
  * Parse HDMI timings,
- * and save them in gDrmCxt.hdmiTimings
+ * and save them in the timings backup of the connector
  */
-static int parseHdmiTimings() {
+static int parseHdmiTimings(drmConnectorContext* cxt) {
+    MDS_TRACE_CALL();
     ALOGV("Entering %s", __func__);
-    drmModeConnector *connector = getHdmiConnector();
+    drmModeConnector *connector = getHdmiConnector(cxt);
     if (connector == NULL) {
         ALOGE("%s: Failed to get HDMI connector.", __func__);
         return 0;
@@ -377,7 +467,7 @@ static int parseHdmiTimings() {
     if (connector->count_modes < 0 || connector->count_modes > HDMI_TIMING_MAX) {
         ALOGW("%s: unexpected count of modes %d", __func__, connector->count_modes);
         drmModeFreeConnector(connector);
-        gDrmCxt.hdmiConnector = NULL;
+        cxt->hdmiConnector = NULL;
         return 0;
     }
     int validCnt = 0;
@@ -391,8 +481,8 @@ static int parseHdmiTimings() {
         unsigned int tmpA = connector->modes[i].picture_aspect_ratio;
 #endif
         bool duplicated = false;
-        for (size_t j = 0; j < gDrmCxt.hdmiTimings.size(); j++) {
-            MDSHdmiTiming* bak = gDrmCxt.hdmiTimings.itemAt(j);
+        for (size_t j = 0; j < cxt->hdmiTimings.size(); j++) {
+            MDSHdmiTiming* bak = cxt->hdmiTimings.itemAt(j);
             if (bak != NULL &&
                     bak->width == tmpW && bak->height == tmpV &&
 #ifndef VPG_DRM
@@ -430,43 +520,52 @@ static int parseHdmiTimings() {
 #endif
         dst.flags = tmpF;
         // Save Hdmi timing
-        addHdmiTimings(&dst);
+        addHdmiTimings(cxt, &dst);
         validCnt++;
         ALOGV("Add timing: %dx%d@%dx0x%0x", tmpW, tmpV, tmpR, tmpF);
     }
     return validCnt;
 }
 
-int drm_hdmi_getTimingNumber() {
+// Get the context of a connected connector
+static drmConnectorContext* getConnectedContext(int index, const char* func)
+{
+    drmConnectorContext* cxt = getContext(index);
+    if (cxt == NULL || !cxt->connected) {
+        ALOGE("%s: display %d is not supported or not connected.", func, index);
+        return NULL;
+    }
+    return cxt;
+}
+
+int drm_hdmi_getTimingNumber(int index) {
     ALOGV("Entering %s", __func__);
-    if (!gDrmCxt.hdmiSupported || !gDrmCxt.connected) {
-        ALOGE("%s: HDMI is not supported or not connected.", __func__);
+    drmConnectorContext* cxt = getConnectedContext(index, __func__);
+    if (cxt == NULL)
         return 0;
-    }
-    int number = gDrmCxt.hdmiTimings.size();
+    int number = cxt->hdmiTimings.size();
     if (number > 0)
         return number;
-    return parseHdmiTimings();
+    return parseHdmiTimings(cxt);
 }
 
 // return number of unique modes
-bool drm_hdmi_getTimings(int count, MDSHdmiTiming** list)
+bool drm_hdmi_getTimings(int index, int count, MDSHdmiTiming** list)
 {
     ALOGV("Entering %s", __func__);
-    if (!gDrmCxt.hdmiSupported || !gDrmCxt.connected) {
-        ALOGE("%s: HDMI is not supported or not connected.", __func__);
+    drmConnectorContext* cxt = getConnectedContext(index, __func__);
+    if (cxt == NULL)
         return false;
-    }
     if (count <= 0 || list == NULL)
         return false;
-    int validCnt = gDrmCxt.hdmiTimings.size();
+    int validCnt = cxt->hdmiTimings.size();
     if (validCnt <= 0)
-        validCnt = parseHdmiTimings();
+        validCnt = parseHdmiTimings(cxt);
     if (validCnt > count)
         validCnt = count;
-    ALOGV("Hdmi timing number: %d, %d, %d", validCnt, count, gDrmCxt.hdmiTimings.size());
+    ALOGV("Hdmi timing number: %d, %d, %d", validCnt, count, cxt->hdmiTimings.size());
     for (int i = 0; i < validCnt; i++) {
-        MDSHdmiTiming* bak = gDrmCxt.hdmiTimings.itemAt(i);
+        MDSHdmiTiming* bak = cxt->hdmiTimings.itemAt(i);
         MDSHdmiTiming* dst = *(list + i);
         if (dst != NULL)
             memcpy(dst, bak, sizeof(MDSHdmiTiming));
@@ -474,16 +573,33 @@ bool drm_hdmi_getTimings(int count, MDSHdmiTiming** list)
     return true;
 }
 
-bool drm_hdmi_checkTiming(MDSHdmiTiming* timing)
+int drm_hdmi_getTimingList(int index, MDSHdmiTiming* list, int max)
 {
-    if (!timing || !gDrmCxt.hdmiSupported || !gDrmCxt.connected) {
-        ALOGE("%s: HDMI is not supported or not connected.", __func__);
-        return false;
-    }
+    ALOGV("Entering %s", __func__);
+    drmConnectorContext* cxt = getConnectedContext(index, __func__);
+    if (cxt == NULL)
+        return 0;
+    if (max <= 0 || list == NULL)
+        return 0;
+    int validCnt = cxt->hdmiTimings.size();
+    if (validCnt <= 0)
+        validCnt = parseHdmiTimings(cxt);
+    if (validCnt > max)
+        validCnt = max;
+    for (int i = 0; i < validCnt; i++)
+        memcpy(list + i, cxt->hdmiTimings.itemAt(i), sizeof(MDSHdmiTiming));
+    return validCnt;
+}
+
+int drm_hdmi_findTiming(int index, MDSHdmiTiming* timing)
+{
+    drmConnectorContext* cxt = getConnectedContext(index, __func__);
+    if (!timing || cxt == NULL)
+        return -1;
     unsigned int i = 0;
-    unsigned int size = gDrmCxt.hdmiTimings.size();
+    unsigned int size = cxt->hdmiTimings.size();
     for (; i < size; i++) {
-        MDSHdmiTiming* bak = gDrmCxt.hdmiTimings.itemAt(i);
+        MDSHdmiTiming* bak = cxt->hdmiTimings.itemAt(i);
         ALOGV("%dx%d@%dx%dx%d, %dx%d@%dx%dx%d",
                 timing->width, timing->height,
                 timing->refresh, timing->interlace, timing->ratio,
@@ -495,16 +611,43 @@ bool drm_hdmi_checkTiming(MDSHdmiTiming* timing)
                 timing->interlace == bak->interlace &&
                 timing->ratio == bak->ratio) {
             timing->flags = bak->flags;
-            gDrmCxt.selectedModeIndex = i;
-            break;
+            return i;
         }
     }
-    if (i >= size) {
-        ALOGE("Fail to get a matched Hdmi timing, %d, %d", i, size);
+    ALOGE("Fail to get a matched Hdmi timing, %d, %d", i, size);
+    return -1;
+}
+
+bool drm_hdmi_selectTiming(int index, int timing)
+{
+    drmConnectorContext* cxt = getContext(index);
+    if (cxt == NULL || timing < 0 || timing >= (int)cxt->hdmiTimings.size())
         return false;
-    }
+    cxt->selectedModeIndex = timing;
     return true;
 }
+
+uint32_t drm_hdmi_getEdidHash(int index)
+{
+    drmConnectorContext* cxt = getContext(index);
+    if (cxt == NULL || !cxt->connected)
+        return 0;
+    return cxt->edidHash;
+}
+
+bool drm_hdmi_getSinkId(int index, uint8_t* id)
+{
+    drmConnectorContext* cxt = getContext(index);
+    if (cxt == NULL || id == NULL || !cxt->connected)
+        return false;
+    memcpy(id, cxt->sinkId, DRM_HDMI_SINK_ID_LEN);
+    return true;
+}
+
+bool drm_hdmi_checkTiming(int index, MDSHdmiTiming* timing)
+{
+    return drm_hdmi_selectTiming(index, drm_hdmi_findTiming(index, timing));
+}
 #if 0
 bool drm_hdmi_isDeviceChanged()
 {
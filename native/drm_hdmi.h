@@ -29,8 +29,11 @@ namespace intel {
 #define DRM_HDMI_DISCONNECTED   (0)
 #define DRM_HDMI_CONNECTED      (1)
 #define DRM_DVI_CONNECTED       (2)
+#define DRM_DP_CONNECTED        (3)
 
-#define HDMI_TIMING_MAX (128)
+#define HDMI_TIMING_MAX MDS_HDMI_TIMING_MAX
+// EDID manufacturer, product code and serial number
+#define DRM_HDMI_SINK_ID_LEN    8
 
 
 bool drm_init();
@@ -38,17 +41,44 @@ void drm_cleanup();
 int  drm_get_dev_fd();
 int  drm_get_ioctl_offset();
 
-bool drm_hdmi_onHdmiDisconnected(void);
+/*
+ * The external connectors are enumerated by drm_init,
+ * "index" is the position of a connector, from 0 to count - 1.
+ */
+int  drm_hdmi_getConnectorCount();
+bool drm_hdmi_isDisplayPort(int index);
+bool drm_hdmi_onHdmiDisconnected(int index);
 bool drm_hdmi_notify_audio_hotplug(bool connected);
-// return 0 - disconnected, 1 - HDMI connected, 2 - DVI connected
-int  drm_hdmi_getConnectionStatus();
-int  drm_hdmi_getTimingNumber();
+// return 0 - disconnected, 1 - HDMI connected, 2 - DVI connected, 3 - DP connected
+int  drm_hdmi_getConnectionStatus(int index);
+// hash of the sink EDID read by drm_hdmi_getConnectionStatus, 0 if not connected
+uint32_t drm_hdmi_getEdidHash(int index);
+// copy the id of the connected sink into "id", false if not connected
+bool drm_hdmi_getSinkId(int index, uint8_t* id);
+int  drm_hdmi_getTimingNumber(int index);
 // get all unique (non-duplicated) modes
-bool drm_hdmi_getTimings(int count, MDSHdmiTiming** list);
+bool drm_hdmi_getTimings(int index, int count, MDSHdmiTiming** list);
+// copy up to "max" modes into "list", return the count copied
+int  drm_hdmi_getTimingList(int index, MDSHdmiTiming* list, int max);
 
-bool drm_hdmi_checkTiming(MDSHdmiTiming* info);
+bool drm_hdmi_checkTiming(int index, MDSHdmiTiming* info);
+// return the index of a matched timing and fill its flags, -1 if no matched
+int  drm_hdmi_findTiming(int index, MDSHdmiTiming* info);
+// mark the timing at "timing" as the user selected one
+bool drm_hdmi_selectTiming(int index, int timing);
 //bool drm_hdmi_isDeviceChanged();
 
+// 32-bit FNV-1a, the EDID hash, also the checksum of MultiDisplayStore
+static inline uint32_t hashEdid(const void* data, size_t length) {
+    const uint8_t* p = (const uint8_t*)data;
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= p[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
 }; // namespace intel
 }; // namespace android
 
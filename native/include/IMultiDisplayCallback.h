@@ -28,6 +28,21 @@
 namespace android {
 namespace intel {
 
+/*
+ * The optional operations implemented by a callback,
+ * MDS calls SurfaceFlinger directly for the ones not reported.
+ */
+enum {
+    MDS_CB_CAP_SCALING_TYPE   = 0x1,
+    MDS_CB_CAP_OVERSCAN       = 0x2,
+    MDS_CB_CAP_DISPLAY_CONFIG = 0x4,
+    // Reported by the callbacks which don't know the capability query,
+    // MDS tries all of them and drops the ones return INVALID_OPERATION
+    MDS_CB_CAP_LEGACY         = (MDS_CB_CAP_SCALING_TYPE |
+                                 MDS_CB_CAP_OVERSCAN |
+                                 MDS_CB_CAP_DISPLAY_CONFIG),
+};
+
 class IMultiDisplayCallback : public IInterface {
 public:
     DECLARE_META_INTERFACE(MultiDisplayCallback);
@@ -82,6 +97,24 @@ public:
      *     !=0: on failure
      */
     virtual status_t updateInputState(bool state) = 0;
+    /*
+     * set timing, scale type and overscan compensation of display
+     * together, only the fields marked in config.fields are valid.
+     * The default implementation returns INVALID_OPERATION, and MDS
+     * falls back to the separated calls.
+     * param: please refer MultiDisplayType.h
+     * return:
+     *       0: on success
+     *     !=0: on failure
+     */
+    virtual status_t setDisplayConfig(const MDSDisplayConfig& config);
+    /*
+     * get the optional operations implemented by the callback,
+     * it is queried once when the callback is registered.
+     * The default implementation returns MDS_CB_CAP_LEGACY.
+     * return: the mask of MDS_CB_CAP_*
+     */
+    virtual uint32_t getCapabilities();
 };
 
 class BnMultiDisplayCallback : public BnInterface<IMultiDisplayCallback>
@@ -44,6 +44,13 @@ public:
      * @return @see status_t in <utils/Errors.h>
      */
     virtual status_t updateInputState(bool state) = 0;
+    /**
+     * @brief Report touch screen or key input activity, it is an one-way call.
+     * The service tracks the input idle timeout itself, and only the
+     * active/idle transitions are passed to the display callback.
+     * @return @see status_t in <utils/Errors.h>
+     */
+    virtual status_t notifyInputActivity() = 0;
 };
 
 class BnMultiDisplayEventMonitor : public BnInterface<IMultiDisplayEventMonitor> {
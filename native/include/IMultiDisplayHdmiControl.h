@@ -88,6 +88,24 @@ public:
      * @return @see status_t in <utils/Errors.h>
      */
     virtual status_t setHdmiOverscan(int hValue, int vValue) = 0;
+
+    /**
+     * @brief Apply timing, scaling type and overscan compensation of HDMI
+     * in one transaction, either all of them are applied or none of them
+     * @param config The configuration, only the fields marked in \
+     *        config.fields are applied. @see MDSDisplayConfig
+     * @return @see status_t in <utils/Errors.h>
+     */
+    virtual status_t applyDisplayConfig(const MDSDisplayConfig& config) = 0;
+
+    /**
+     * @brief Get the timing count and the timing list of HDMI at once
+     * @param list the timing list, it has room for "max" timings
+     * @param max  the max count of timings to return, \
+     *        up to MDS_HDMI_TIMING_MAX
+     * @return The count of timings in the list
+     */
+    virtual int getHdmiTimings(MDSHdmiTiming* list, int max) = 0;
 };
 
 class BnMultiDisplayHdmiControl : public BnInterface<IMultiDisplayHdmiControl> {
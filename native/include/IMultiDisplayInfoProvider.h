@@ -93,6 +93,32 @@ public:
      * @return @see "true" means vpp is on
      */
      virtual bool getVppState() = 0;
+
+    /**
+     * @brief Check whether MDS has finished display bring-up.
+     * Before that, the HDMI bits of the display mode are never set,
+     * the HDMI timing count is 0 and the HDMI settings return NO_INIT.
+     * MDS_MSG_READY is broadcasted when it becomes ready.
+     * @return "true" means MDS is ready
+     */
+     virtual bool isReady() = 0;
+
+    /**
+     * @brief Get the count of the external display connectors
+     * @return the count, 0 if MDS isn't ready
+     */
+     virtual int getExternalDisplayCount() = 0;
+
+    /**
+     * @brief Get the state of one display
+     * @param id @see MDS_DISPLAY_ID
+     * @param connector the external connector index,
+     *                  from 0 to getExternalDisplayCount() - 1,
+     *                  it must be 0 for the primary and virtual display
+     * @param state @see MDSDisplayState in the MultiDisplayType.h
+     * @return @see status_t in <utils/Errors.h>
+     */
+    virtual status_t getDisplayState(MDS_DISPLAY_ID id, int connector, MDSDisplayState* state) = 0;
 };
 
 
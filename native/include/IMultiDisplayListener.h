@@ -31,6 +31,8 @@ namespace intel {
 /** @brief The messages MDS broadcasts to listeners */
 typedef enum {
     MDS_MSG_MODE_CHANGE = 1 << 1,
+    MDS_MSG_READY       = 1 << 3,  /**< MDS finished display bring-up */
+    MDS_MSG_DISPLAY_STATE = 1 << 4,  /**< a display changed, the value is MDSDisplayState */
 } MDS_MESSAGE;
 
 class IMultiDisplayListener : public IInterface
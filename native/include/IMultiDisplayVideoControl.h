@@ -58,6 +58,16 @@ public:
      * @return @see status_t in <utils/Errors.h>
      */
     virtual status_t updateVideoSourceInfo(int sessionId, const MDSVideoSourceInfo& info) = 0;
+
+    // Added last, the existing entries of the vtable are kept
+    /**
+     * @brief Allocate a unique id for video player, owned by "token".
+     * The session is reserved until it is UNPREPARED, and released
+     * as UNPREPARED if the process of "token" dies before.
+     * @param token, a binder of the player, e.g. a new BBinder
+     * @return: a sessionId, or -1 if no session is free
+     */
+    virtual int allocateVideoSession(const sp<IBinder>& token) = 0;
 };
 
 class BnMultiDisplayVideoControl : public BnInterface<IMultiDisplayVideoControl> {
@@ -85,6 +85,13 @@ public:
 #ifdef TARGET_HAS_VPP
     virtual sp<IMultiDisplayVppConfig>           getVppConfig();
 #endif
+
+    virtual status_t dump(int fd, const Vector<String16>& args);
+
+private:
+    // The state of the service, only known in MultiDisplayService.cpp
+    struct Impl;
+    Impl* mImpl;
 };
 
 }; // namespace intel
@@ -27,6 +27,10 @@ namespace intel {
 
 
 static const int MDS_VIDEO_SESSION_MAX_VALUE = 16;
+/** @brief The max count of HDMI timings reported by MDS */
+static const int MDS_HDMI_TIMING_MAX = 128;
+/** @brief The max count of external displays (HDMI, DVI and DP) */
+static const int MDS_EXTERNAL_DISPLAY_MAX = 4;
 
 /** @brief The display ID */
 typedef enum {
@@ -76,6 +80,43 @@ typedef enum {
     MDS_SCALING_ASPECT      = 3,
 } MDS_SCALING_TYPE;
 
+/** @brief The valid fields of a display configuration */
+typedef enum {
+    MDS_CONFIG_TIMING   = 1,       /**< timing is valid */
+    MDS_CONFIG_SCALING  = 1 << 1,  /**< scaling type is valid */
+    MDS_CONFIG_OVERSCAN = 1 << 2,  /**< overscan compensation is valid */
+} MDS_DISPLAY_CONFIG_FIELD;
+
+/** @brief A set of HDMI settings which are applied together */
+typedef struct {
+    uint32_t         fields;     /**< @see MDS_DISPLAY_CONFIG_FIELD */
+    MDSHdmiTiming    timing;     /**< @see MDSHdmiTiming */
+    MDS_SCALING_TYPE scaling;    /**< @see MDS_SCALING_TYPE */
+    int              hOverscan;  /**< horizontal overscan compensation */
+    int              vOverscan;  /**< vertical overscan compensation */
+} MDSDisplayConfig;
+
+/** @brief The connection state of a display */
+typedef enum {
+    MDS_DISPLAY_DISCONNECTED   = 0,
+    MDS_DISPLAY_HDMI_CONNECTED = 1,  /**< an HDMI sink is connected */
+    MDS_DISPLAY_DVI_CONNECTED  = 2,  /**< a DVI sink is connected */
+    MDS_DISPLAY_DP_CONNECTED   = 3,  /**< a DisplayPort sink is connected */
+    MDS_DISPLAY_CONNECTED      = 4,  /**< the primary or virtual display is on */
+} MDS_DISPLAY_CONNECTION;
+
+/** @brief The state of one display */
+typedef struct {
+    MDS_DISPLAY_ID         id;
+    int                    connector;   /**< external connector index, 0 for the others */
+    MDS_DISPLAY_CONNECTION connection;  /**< @see MDS_DISPLAY_CONNECTION */
+    int                    timingCount; /**< count of the timings of the sink */
+    MDS_SCALING_TYPE       scaling;     /**< @see MDS_SCALING_TYPE */
+    int                    hOverscan;   /**< horizontal overscan compensation */
+    int                    vOverscan;   /**< vertical overscan compensation */
+    bool                   vpp;         /**< vpp is allowed on the display */
+} MDSDisplayState;
+
 
 }; // namespace intel
 }; // namespace android
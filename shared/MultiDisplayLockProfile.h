@@ -0,0 +1,312 @@
+/*
+ * Copyright (c) 2012-2013, Intel Corporation. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef __MULTIDISPLAY_LOCK_PROFILE_H__
+#define __MULTIDISPLAY_LOCK_PROFILE_H__
+
+/*
+ * Lock contention profile of the composer mutexes.
+ * A mutex is declared as MultiDisplayMutex, created with its name,
+ * and locked with:
+ *
+ *   MDS_AUTOLOCK(lock)               lock it till the end of the scope
+ *   mdsLock(lock, __func__)          lock it
+ *   mdsTryLock(lock, __func__)       try to lock it
+ *   mdsWait(condition, lock)         wait on a condition with it
+ *
+ * If MDS_LOCK_PROFILE is defined, each mutex keeps a histogram of the
+ * wait time of the contended locks, a histogram of the hold time, and
+ * the same numbers per call site, that is the function which locks it.
+ * They are printed by mdsDumpLocks. Otherwise MultiDisplayMutex is Mutex
+ * and all of these are the plain Mutex calls.
+ *
+ * This header is shared by the library and the legacy trees, the legacy
+ * ones export it with their composer header.
+ */
+
+#include <utils/threads.h>
+#include <utils/String8.h>
+
+#define MDS_LOCK_CONCAT_(A, B) A##B
+#define MDS_LOCK_CONCAT(A, B)  MDS_LOCK_CONCAT_(A, B)
+
+#ifdef MDS_LOCK_PROFILE
+
+#include <utils/Timers.h>
+#include <string.h>
+
+namespace android {
+namespace intel {
+
+/*
+ * Log2 buckets in microseconds, as MultiDisplayLatency: bucket 0 counts
+ * the times under 1us, bucket i (i > 0) the ones in [2^(i-1), 2^i) us.
+ * It is updated with its mutex held, a dump reads it without the mutex,
+ * so a dump may miss the calls in flight.
+ */
+class MultiDisplayLockHistogram {
+public:
+    static const int BUCKETS = 20;
+
+    MultiDisplayLockHistogram() : mCount(0), mMaxUs(0) {
+        memset((void*)mBuckets, 0, sizeof(mBuckets));
+    }
+    void record(nsecs_t duration) {
+        nsecs_t us = ns2us(duration);
+        int32_t value = (us > INT32_MAX ? INT32_MAX : (us < 0 ? 0 : (int32_t)us));
+        int bucket = 0;
+        while ((value >> bucket) != 0 && bucket < BUCKETS - 1)
+            bucket++;
+        mBuckets[bucket]++;
+        mCount++;
+        if (value > mMaxUs)
+            mMaxUs = value;
+    }
+    void dump(String8& out, const char* what) const {
+        int32_t count = mCount;
+        if (count == 0)
+            return;
+        out.appendFormat("    %s: %d, max %d us\n     ", what, count, mMaxUs);
+        for (int i = 0; i < BUCKETS; i++) {
+            int32_t n = mBuckets[i];
+            if (n == 0)
+                continue;
+            if (i == 0)
+                out.appendFormat(" <1us:%d", n);
+            else if (i == BUCKETS - 1)
+                out.appendFormat(" >=%dus:%d", 1 << (i - 1), n);
+            else
+                out.appendFormat(" <%dus:%d", 1 << i, n);
+        }
+        out.append("\n");
+    }
+
+private:
+    volatile int32_t mCount;
+    volatile int32_t mMaxUs;
+    volatile int32_t mBuckets[BUCKETS];
+};
+
+class MultiDisplayMutex {
+public:
+    // The call sites kept per mutex, the others are counted together
+    static const int SITES = 16;
+
+    MultiDisplayMutex(const char* name)
+        : mName(name), mSite(NULL), mAcquired(0), mNext(NULL) {
+        memset(mSites, 0, sizeof(mSites));
+        Mutex::Autolock lock(listLock());
+        mNext = list();
+        list() = this;
+    }
+    ~MultiDisplayMutex() {
+        Mutex::Autolock lock(listLock());
+        for (MultiDisplayMutex** p = &list(); *p != NULL; p = &(*p)->mNext) {
+            if (*p == this) {
+                *p = mNext;
+                break;
+            }
+        }
+    }
+
+    status_t lock(const char* site) {
+        status_t err = mLock.tryLock();
+        if (err == NO_ERROR) {
+            acquired(site, -1);
+            return err;
+        }
+        nsecs_t start = systemTime();
+        err = mLock.lock();
+        if (err == NO_ERROR)
+            acquired(site, systemTime() - start);
+        return err;
+    }
+    status_t tryLock(const char* site) {
+        status_t err = mLock.tryLock();
+        if (err == NO_ERROR)
+            acquired(site, -1);
+        return err;
+    }
+    void unlock() {
+        released();
+        mLock.unlock();
+    }
+    // The time in the wait isn't counted as held
+    status_t wait(Condition& condition) {
+        const char* site = mSite;
+        released();
+        status_t err = condition.wait(mLock);
+        acquired(site, -1);
+        return err;
+    }
+
+    class Autolock {
+    public:
+        Autolock(MultiDisplayMutex& lock, const char* site) : mLock(lock) {
+            mLock.lock(site);
+        }
+        ~Autolock() {
+            mLock.unlock();
+        }
+    private:
+        MultiDisplayMutex& mLock;
+    };
+
+    static void dumpAll(String8& out) {
+        Mutex::Autolock lock(listLock());
+        out.append("Locks:\n");
+        for (MultiDisplayMutex* m = list(); m != NULL; m = m->mNext)
+            m->dump(out);
+    }
+
+private:
+    struct Site {
+        const char* name;
+        int32_t count;
+        int32_t contended;
+        nsecs_t wait;
+        nsecs_t hold;
+        nsecs_t maxHold;
+    };
+
+    Mutex       mLock;
+    const char* mName;
+    // The owner, valid while the mutex is held
+    const char* mSite;
+    nsecs_t     mAcquired;
+    MultiDisplayLockHistogram mWait;
+    MultiDisplayLockHistogram mHold;
+    Site        mSites[SITES];
+    MultiDisplayMutex* mNext;
+
+    // The profiled mutexes, a mutex may be a static object of another
+    // file, so the list and its lock are created at the first use
+    static MultiDisplayMutex*& list() {
+        static MultiDisplayMutex* sList = NULL;
+        return sList;
+    }
+    static Mutex& listLock() {
+        static Mutex sLock;
+        return sLock;
+    }
+
+    // With the mutex held, the sites are matched by the address of __func__
+    Site& getSite(const char* name) {
+        if (name == NULL)
+            name = "?";
+        for (int i = 0; i < SITES - 1; i++) {
+            if (mSites[i].name == name)
+                return mSites[i];
+            if (mSites[i].name == NULL) {
+                mSites[i].name = name;
+                return mSites[i];
+            }
+        }
+        mSites[SITES - 1].name = "(others)";
+        return mSites[SITES - 1];
+    }
+    // "wait" is -1 if the mutex was free
+    void acquired(const char* site, nsecs_t wait) {
+        mAcquired = systemTime();
+        mSite = site;
+        Site& s = getSite(site);
+        s.count++;
+        if (wait >= 0) {
+            mWait.record(wait);
+            s.contended++;
+            s.wait += wait;
+        }
+    }
+    void released() {
+        nsecs_t hold = systemTime() - mAcquired;
+        mHold.record(hold);
+        Site& s = getSite(mSite);
+        s.hold += hold;
+        if (hold > s.maxHold)
+            s.maxHold = hold;
+    }
+
+    void dump(String8& out) const {
+        out.appendFormat("  %s:\n", mName);
+        mWait.dump(out, "contended");
+        mHold.dump(out, "held");
+        for (int i = 0; i < SITES && mSites[i].name != NULL; i++) {
+            const Site& s = mSites[i];
+            if (s.count == 0)
+                continue;
+            out.appendFormat("    %s: %d locks, %d contended, wait %lld us, "
+                    "hold %lld us, max hold %lld us\n", s.name, s.count,
+                    s.contended, (long long)ns2us(s.wait),
+                    (long long)ns2us(s.hold), (long long)ns2us(s.maxHold));
+        }
+    }
+};
+
+static inline status_t mdsLock(MultiDisplayMutex& lock, const char* site) {
+    return lock.lock(site);
+}
+
+static inline status_t mdsTryLock(MultiDisplayMutex& lock, const char* site) {
+    return lock.tryLock(site);
+}
+
+static inline status_t mdsWait(Condition& condition, MultiDisplayMutex& lock) {
+    return lock.wait(condition);
+}
+
+static inline void mdsDumpLocks(String8& out) {
+    MultiDisplayMutex::dumpAll(out);
+}
+
+}; // namespace intel
+}; // namespace android
+
+#define MDS_AUTOLOCK(LOCK) \
+    android::intel::MultiDisplayMutex::Autolock \
+        MDS_LOCK_CONCAT(_mdsAutolock, __LINE__)(LOCK, __func__)
+
+#else
+
+namespace android {
+namespace intel {
+
+typedef Mutex MultiDisplayMutex;
+
+static inline status_t mdsLock(Mutex& lock, const char* site) {
+    return lock.lock();
+}
+
+static inline status_t mdsTryLock(Mutex& lock, const char* site) {
+    return lock.tryLock();
+}
+
+static inline status_t mdsWait(Condition& condition, Mutex& lock) {
+    return condition.wait(lock);
+}
+
+static inline void mdsDumpLocks(String8& out) {
+}
+
+}; // namespace intel
+}; // namespace android
+
+#define MDS_AUTOLOCK(LOCK) \
+    android::Mutex::Autolock MDS_LOCK_CONCAT(_mdsAutolock, __LINE__)(LOCK)
+
+#endif
+
+#endif
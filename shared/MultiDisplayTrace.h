@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2012-2013, Intel Corporation. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef __MULTIDISPLAY_TRACE_H__
+#define __MULTIDISPLAY_TRACE_H__
+
+/*
+ * Trace points, written to the ftrace trace_marker in the format of
+ * systrace, so they can be read by systrace/perfetto on Android, and by
+ * trace-cmd on a plain Linux.
+ * They are built only if MDS_TRACE is defined, otherwise all the macros
+ * expand to nothing and their arguments are not evaluated.
+ *
+ *   MDS_TRACE_CALL()                 a section of the enclosing function
+ *   MDS_TRACE_NAME(name)             a section till the end of the scope
+ *   MDS_TRACE_ASYNC_BEGIN(name, id)  start the flow "id" of "name"
+ *   MDS_TRACE_ASYNC_END(name, id)    finish it, maybe on another thread
+ *   MDS_TRACE_INT(name, value)       a counter
+ *
+ * This header is shared by the library and the legacy trees, all of
+ * them have shared/ in their include path.
+ */
+
+#ifdef MDS_TRACE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <unistd.h>
+
+namespace android {
+namespace intel {
+
+static inline int mdsTraceOpen() {
+    static const char* paths[] = {
+        "/sys/kernel/debug/tracing/trace_marker",
+        "/sys/kernel/tracing/trace_marker",
+    };
+    for (size_t i = 0; i < sizeof(paths) / sizeof(paths[0]); i++) {
+        int fd = open(paths[i], O_WRONLY | O_CLOEXEC);
+        if (fd >= 0)
+            return fd;
+    }
+    return -1;
+}
+
+// The marker is opened once per process, at the first trace point
+static inline int mdsTraceFd() {
+    static int fd = mdsTraceOpen();
+    return fd;
+}
+
+static inline void mdsTraceWrite(const char* fmt, ...)
+        __attribute__((format(printf, 1, 2)));
+static inline void mdsTraceWrite(const char* fmt, ...) {
+    int fd = mdsTraceFd();
+    if (fd < 0)
+        return;
+    char buf[256];
+    va_list ap;
+    va_start(ap, fmt);
+    int len = vsnprintf(buf, sizeof(buf), fmt, ap);
+    va_end(ap);
+    if (len <= 0)
+        return;
+    if (len >= (int)sizeof(buf))
+        len = sizeof(buf) - 1;
+    // The marker takes a point in a single write, a failed one is dropped
+    while (write(fd, buf, len) < 0 && errno == EINTR)
+        ;
+}
+
+class MultiDisplayTraceScope {
+public:
+    MultiDisplayTraceScope(const char* name) {
+        mdsTraceWrite("B|%d|%s", getpid(), name);
+    }
+    ~MultiDisplayTraceScope() {
+        mdsTraceWrite("E|%d", getpid());
+    }
+};
+
+}; // namespace intel
+}; // namespace android
+
+#define MDS_TRACE_CONCAT_(A, B) A##B
+#define MDS_TRACE_CONCAT(A, B)  MDS_TRACE_CONCAT_(A, B)
+
+#define MDS_TRACE_NAME(NAME) \
+    android::intel::MultiDisplayTraceScope \
+        MDS_TRACE_CONCAT(_mdsTrace, __LINE__)(NAME)
+#define MDS_TRACE_CALL() MDS_TRACE_NAME(__func__)
+#define MDS_TRACE_ASYNC_BEGIN(NAME, ID) \
+    android::intel::mdsTraceWrite("S|%d|%s|%d", getpid(), NAME, (int)(ID))
+#define MDS_TRACE_ASYNC_END(NAME, ID) \
+    android::intel::mdsTraceWrite("F|%d|%s|%d", getpid(), NAME, (int)(ID))
+#define MDS_TRACE_INT(NAME, VALUE) \
+    android::intel::mdsTraceWrite("C|%d|%s|%d", getpid(), NAME, (int)(VALUE))
+
+#else
+
+#define MDS_TRACE_NAME(NAME)            ((void)0)
+#define MDS_TRACE_CALL()                ((void)0)
+#define MDS_TRACE_ASYNC_BEGIN(NAME, ID) ((void)0)
+#define MDS_TRACE_ASYNC_END(NAME, ID)   ((void)0)
+#define MDS_TRACE_INT(NAME, VALUE)      ((void)0)
+
+#endif
+
+#endif
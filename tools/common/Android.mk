@@ -0,0 +1,37 @@
+# The composer core with a fake libdrm, built once for all the tools.
+# A tool links it and includes mds_tool.mk, so both are built with the
+# same flags.
+
+LOCAL_PATH:= $(call my-dir)
+
+ifneq ($(filter true,$(ENABLE_IMG_GRAPHICS) $(ENABLE_GEN_GRAPHICS)),)
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES := \
+    FakeDrm.cpp \
+    ../../native/MultiDisplayComposer.cpp \
+    ../../native/IMultiDisplayListener.cpp \
+    ../../native/IMultiDisplayCallback.cpp \
+    ../../native/IMultiDisplayInfoProvider.cpp \
+    ../../native/IMultiDisplayConnectionObserver.cpp \
+    ../../native/IMultiDisplayHdmiControl.cpp \
+    ../../native/IMultiDisplayVideoControl.cpp \
+    ../../native/IMultiDisplayEventMonitor.cpp \
+    ../../native/IMultiDisplaySinkRegistrar.cpp \
+    ../../native/IMultiDisplayCallbackRegistrar.cpp \
+    ../../native/IMultiDisplayDecoderConfig.cpp \
+    ../../native/MultiDisplayService.cpp \
+    ../../native/MultiDisplayStore.cpp \
+    ../../native/MultiDisplaySinkPreferences.cpp \
+    ../../native/MultiDisplayLatency.cpp \
+    ../../native/MultiDisplayRecorder.cpp \
+    ../../native/drm_hdmi.cpp
+
+LOCAL_MODULE := libmds_tools_core
+LOCAL_MODULE_TAGS := optional
+
+LOCAL_CFLAGS := -DLOG_TAG=\"MultiDisplay\"
+
+include $(LOCAL_PATH)/mds_tool.mk
+include $(BUILD_STATIC_LIBRARY)
+endif
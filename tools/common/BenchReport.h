@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2012-2013, Intel Corporation. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef __MDS_TOOLS_BENCH_REPORT_H__
+#define __MDS_TOOLS_BENCH_REPORT_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <utils/String8.h>
+#include <utils/Timers.h>
+#include <utils/Vector.h>
+
+namespace android {
+namespace intel {
+
+// The time per operation of a run, in nanoseconds
+class BenchSamples {
+public:
+    BenchSamples() : mOps(0), mWall(0) {}
+
+    // "ns" is the time of "ops" operations
+    inline void add(nsecs_t ns, int ops = 1) {
+        mSamples.add(ns / ops);
+        mOps += ops;
+    }
+    void merge(const BenchSamples& other) {
+        for (size_t i = 0; i < other.mSamples.size(); i++)
+            mSamples.add(other.mSamples[i]);
+        mOps += other.mOps;
+    }
+    inline void setWallTime(nsecs_t wall) {
+        mWall = wall;
+    }
+
+    Vector<nsecs_t> mSamples;
+    int64_t mOps;
+    nsecs_t mWall;
+};
+
+static int compareNsecs(const void* a, const void* b) {
+    nsecs_t l = *(const nsecs_t*)a;
+    nsecs_t r = *(const nsecs_t*)b;
+    return (l < r ? -1 : (l > r ? 1 : 0));
+}
+
+/*
+ * The JSON report of a tool, a result per run with the time per
+ * operation in nanoseconds (mean, p50, p99 and max) and the throughput,
+ * so the reports of two builds can be compared entry by entry.
+ */
+class BenchReport {
+public:
+    BenchReport(const char* tool) : mTool(tool), mCount(0) {}
+
+    /**
+     * @brief Add the result of a run,
+     * "config" is the JSON members of the run parameters, may be empty
+     */
+    void add(const char* name, const String8& config, BenchSamples& samples) {
+        size_t n = samples.mSamples.size();
+        if (n == 0)
+            return;
+        nsecs_t* array = samples.mSamples.editArray();
+        qsort(array, n, sizeof(nsecs_t), compareNsecs);
+        double sum = 0;
+        for (size_t i = 0; i < n; i++)
+            sum += array[i];
+        double opsPerSec = 0;
+        if (samples.mWall > 0)
+            opsPerSec = samples.mOps * 1e9 / samples.mWall;
+        mResults.appendFormat("%s\n    {\"name\": \"%s\", \"config\": {%s}, "
+                "\"operations\": %lld, \"mean_ns\": %.1f, \"p50_ns\": %lld, "
+                "\"p99_ns\": %lld, \"max_ns\": %lld, \"ops_per_sec\": %.1f}",
+                (mCount > 0 ? "," : ""), name, config.string(),
+                (long long)samples.mOps, sum / n,
+                (long long)array[n / 2], (long long)array[(n * 99) / 100],
+                (long long)array[n - 1], opsPerSec);
+        mCount++;
+        fprintf(stderr, "%-24s {%s} mean %.1f ns, p99 %lld ns\n",
+                name, config.string(), sum / n, (long long)array[(n * 99) / 100]);
+    }
+
+    // "members" are the JSON members of the tool, each one ends with ",\n"
+    void write(FILE* file, const String8& members) {
+#ifdef MDS_TRACE
+        const char* trace = "true";
+#else
+        const char* trace = "false";
+#endif
+        fprintf(file, "{\n  \"tool\": \"%s\",\n  \"version\": 1,\n"
+                "  \"trace\": %s,\n%s  \"results\": [%s\n  ]\n}\n",
+                mTool, trace, members.string(), mResults.string());
+    }
+
+private:
+    const char* mTool;
+    String8 mResults;
+    int mCount;
+};
+
+}; // namespace intel
+}; // namespace android
+
+#endif
@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2012-2013, Intel Corporation. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef __MDS_TOOLS_BENCH_WORKER_H__
+#define __MDS_TOOLS_BENCH_WORKER_H__
+
+#include <utils/threads.h>
+
+#include "BenchReport.h"
+
+namespace android {
+namespace intel {
+
+// Released once all the workers of a run are started
+class BenchGate {
+public:
+    BenchGate() : mOpen(false) {}
+    void wait() {
+        Mutex::Autolock lock(mLock);
+        while (!mOpen)
+            mCondition.wait(mLock);
+    }
+    void open() {
+        Mutex::Autolock lock(mLock);
+        mOpen = true;
+        mCondition.broadcast();
+    }
+private:
+    Mutex     mLock;
+    Condition mCondition;
+    bool      mOpen;
+};
+
+// A worker thread of a run, the samples are read after join()
+class BenchWorker : public Thread {
+public:
+    BenchWorker(BenchGate& gate) : Thread(false), mGate(gate) {}
+    BenchSamples mSamples;
+protected:
+    virtual void work() = 0;
+private:
+    BenchGate& mGate;
+    virtual bool threadLoop() {
+        mGate.wait();
+        work();
+        return false;
+    }
+};
+
+}; // namespace intel
+}; // namespace android
+
+#endif
@@ -0,0 +1,387 @@
+/*
+ * Copyright (c) 2012-2013, Intel Corporation. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "xf86drm.h"
+#include "xf86drmMode.h"
+
+#include "FakeDrm.h"
+
+namespace android {
+namespace intel {
+
+enum {
+    FAKE_PANEL_ID    = 10,
+    FAKE_EXTERNAL_ID = 11,
+    FAKE_DPMS_PROP   = 1,
+    FAKE_EDID_PROP   = 2,
+    FAKE_EDID_BLOB   = 3,
+};
+
+#define FAKE_EDID_BLOCK   128
+#define FAKE_ASPECT_NONE  0
+#define FAKE_ASPECT_4_3   1
+#define FAKE_ASPECT_16_9  2
+
+typedef struct {
+    uint16_t width;
+    uint16_t height;
+    uint32_t refresh;
+    bool     interlace;
+    int      aspect;
+    bool     preferred;
+} FakeMode;
+
+typedef struct {
+    const char*     name;
+    // An HDMI sink has the HDMI VSDB in a CEA extension, a DVI one has no extension
+    bool            hdmi;
+    const FakeMode* modes;
+    int             count;
+} FakeSink;
+
+// A 1080p TV, the preferred mode is listed twice like some TVs do
+static const FakeMode sTv1080p[] = {
+    { 1920, 1080, 60, false, FAKE_ASPECT_16_9, true  },
+    { 1920, 1080, 60, false, FAKE_ASPECT_16_9, false },
+    { 1920, 1080, 50, false, FAKE_ASPECT_16_9, false },
+    { 1920, 1080, 60, true,  FAKE_ASPECT_16_9, false },
+    { 1920, 1080, 50, true,  FAKE_ASPECT_16_9, false },
+    { 1920, 1080, 30, false, FAKE_ASPECT_16_9, false },
+    { 1920, 1080, 24, false, FAKE_ASPECT_16_9, false },
+    { 1280,  720, 60, false, FAKE_ASPECT_16_9, false },
+    { 1280,  720, 50, false, FAKE_ASPECT_16_9, false },
+    { 1280,  720, 60, false, FAKE_ASPECT_16_9, false },
+    { 1024,  768, 60, false, FAKE_ASPECT_NONE, false },
+    {  800,  600, 60, false, FAKE_ASPECT_NONE, false },
+    {  720,  576, 50, false, FAKE_ASPECT_4_3,  false },
+    {  720,  576, 50, false, FAKE_ASPECT_16_9, false },
+    {  720,  480, 60, false, FAKE_ASPECT_4_3,  false },
+    {  720,  480, 60, false, FAKE_ASPECT_16_9, false },
+    {  640,  480, 60, false, FAKE_ASPECT_4_3,  false },
+};
+
+// A 720p TV
+static const FakeMode sTv720p[] = {
+    { 1280,  720, 60, false, FAKE_ASPECT_16_9, true  },
+    { 1920, 1080, 60, true,  FAKE_ASPECT_16_9, false },
+    { 1920, 1080, 50, true,  FAKE_ASPECT_16_9, false },
+    { 1280,  720, 50, false, FAKE_ASPECT_16_9, false },
+    {  720,  576, 50, false, FAKE_ASPECT_4_3,  false },
+    {  720,  576, 50, false, FAKE_ASPECT_16_9, false },
+    {  720,  480, 60, false, FAKE_ASPECT_4_3,  false },
+    {  720,  480, 60, false, FAKE_ASPECT_16_9, false },
+    {  640,  480, 60, false, FAKE_ASPECT_4_3,  false },
+};
+
+// A 50Hz TV, the preferred mode isn't 60Hz so the 1080p one is searched
+static const FakeMode sTv50Hz[] = {
+    { 1920, 1080, 50, false, FAKE_ASPECT_16_9, true  },
+    { 1920, 1080, 50, true,  FAKE_ASPECT_16_9, false },
+    { 1280,  720, 50, false, FAKE_ASPECT_16_9, false },
+    {  720,  576, 50, false, FAKE_ASPECT_4_3,  false },
+    {  720,  576, 50, false, FAKE_ASPECT_16_9, false },
+    { 1920, 1080, 60, true,  FAKE_ASPECT_16_9, false },
+    { 1920, 1080, 60, false, FAKE_ASPECT_16_9, false },
+    { 1280,  720, 60, false, FAKE_ASPECT_16_9, false },
+    {  720,  480, 60, false, FAKE_ASPECT_4_3,  false },
+    {  640,  480, 60, false, FAKE_ASPECT_4_3,  false },
+};
+
+// A DVI monitor with the VESA modes
+static const FakeMode sDviMonitor[] = {
+    { 1680, 1050, 60, false, FAKE_ASPECT_NONE, true  },
+    { 1280, 1024, 75, false, FAKE_ASPECT_NONE, false },
+    { 1280, 1024, 60, false, FAKE_ASPECT_NONE, false },
+    { 1440,  900, 75, false, FAKE_ASPECT_NONE, false },
+    { 1440,  900, 60, false, FAKE_ASPECT_NONE, false },
+    { 1280,  960, 60, false, FAKE_ASPECT_NONE, false },
+    { 1152,  864, 75, false, FAKE_ASPECT_NONE, false },
+    { 1024,  768, 75, false, FAKE_ASPECT_NONE, false },
+    { 1024,  768, 70, false, FAKE_ASPECT_NONE, false },
+    { 1024,  768, 60, false, FAKE_ASPECT_NONE, false },
+    {  832,  624, 75, false, FAKE_ASPECT_NONE, false },
+    {  800,  600, 75, false, FAKE_ASPECT_NONE, false },
+    {  800,  600, 72, false, FAKE_ASPECT_NONE, false },
+    {  800,  600, 60, false, FAKE_ASPECT_NONE, false },
+    {  800,  600, 56, false, FAKE_ASPECT_NONE, false },
+    {  640,  480, 75, false, FAKE_ASPECT_NONE, false },
+    {  640,  480, 72, false, FAKE_ASPECT_NONE, false },
+    {  640,  480, 67, false, FAKE_ASPECT_NONE, false },
+    {  640,  480, 60, false, FAKE_ASPECT_NONE, false },
+    {  720,  400, 70, false, FAKE_ASPECT_NONE, false },
+};
+
+// Up to HDMI_TIMING_MAX unique modes without a preferred one,
+// the worst case of the duplicate check and the preferred mode search
+static const int sLargeSizes[][2] = {
+    { 4096, 2160 }, { 3840, 2160 }, { 2560, 1600 }, { 2560, 1440 },
+    { 1920, 1200 }, { 1920, 1080 }, { 1680, 1050 }, { 1600, 1200 },
+    { 1600,  900 }, { 1440,  900 }, { 1366,  768 }, { 1280, 1024 },
+    { 1280,  800 }, { 1280,  720 }, { 1024,  768 }, {  720,  576 },
+};
+static const uint32_t sLargeRefresh[] = { 24, 30, 50, 60 };
+static const int LARGE_MODE_COUNT = 16 * 4 * 2;
+static FakeMode sLarge[LARGE_MODE_COUNT];
+
+static FakeSink sCorpus[] = {
+    { "hdmi-tv-1080p",    true,  sTv1080p,    sizeof(sTv1080p) / sizeof(FakeMode)    },
+    { "hdmi-tv-720p",     true,  sTv720p,     sizeof(sTv720p) / sizeof(FakeMode)     },
+    { "hdmi-tv-50hz",     true,  sTv50Hz,     sizeof(sTv50Hz) / sizeof(FakeMode)     },
+    { "dvi-monitor",      false, sDviMonitor, sizeof(sDviMonitor) / sizeof(FakeMode) },
+    { "hdmi-large-modes", true,  sLarge,      LARGE_MODE_COUNT                       },
+};
+static const int CORPUS_SIZE = sizeof(sCorpus) / sizeof(sCorpus[0]);
+
+// The sink on the external connector, and its EDID
+static volatile int sCurrent = -1;
+static uint8_t sEdid[FAKE_EDID_BLOCK * 2];
+static drmModePropertyBlobRes sEdidBlob;
+
+static void initLargeModes() {
+    if (sLarge[0].width != 0)
+        return;
+    int n = 0;
+    for (int s = 0; s < 16; s++) {
+        for (int r = 0; r < 4; r++) {
+            for (int a = FAKE_ASPECT_4_3; a <= FAKE_ASPECT_16_9; a++) {
+                FakeMode& mode = sLarge[n++];
+                mode.width     = sLargeSizes[s][0];
+                mode.height    = sLargeSizes[s][1];
+                mode.refresh   = sLargeRefresh[r];
+                mode.interlace = false;
+                mode.aspect    = a;
+                mode.preferred = false;
+            }
+        }
+    }
+}
+
+static void fillChecksum(uint8_t* block) {
+    uint8_t sum = 0;
+    for (int i = 0; i < FAKE_EDID_BLOCK - 1; i++)
+        sum += block[i];
+    block[FAKE_EDID_BLOCK - 1] = (uint8_t)(0x100 - sum);
+}
+
+// A base block, and a CEA extension with the HDMI VSDB for an HDMI sink
+static void buildEdid(int sink) {
+    static const uint8_t header[] = { 0x00, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x00 };
+    memset(sEdid, 0, sizeof(sEdid));
+    memcpy(sEdid, header, sizeof(header));
+    // Manufacturer, product code and serial number, a sink id per entry
+    sEdid[8]  = 0x25;
+    sEdid[9]  = 0xd4;
+    sEdid[10] = (uint8_t)sink;
+    sEdid[12] = (uint8_t)(0x10 + sink);
+    sEdid[18] = 1;
+    sEdid[19] = 3;
+    sEdid[126] = (sCorpus[sink].hdmi ? 1 : 0);
+    fillChecksum(sEdid);
+
+    sEdidBlob.id = FAKE_EDID_BLOB;
+    sEdidBlob.length = FAKE_EDID_BLOCK;
+    sEdidBlob.data = sEdid;
+    if (!sCorpus[sink].hdmi)
+        return;
+    uint8_t* ext = sEdid + FAKE_EDID_BLOCK;
+    ext[0] = 0x02;
+    ext[1] = 0x03;
+    ext[2] = 10;
+    // Vendor specific data block, IEEE OUI 00-0c-03 and address 1.0.0.0
+    ext[4] = 0x65;
+    ext[5] = 0x03;
+    ext[6] = 0x0c;
+    ext[7] = 0x00;
+    ext[8] = 0x10;
+    ext[9] = 0x00;
+    fillChecksum(ext);
+    sEdidBlob.length = sizeof(sEdid);
+}
+
+static void fillMode(const FakeMode& src, drmModeModeInfo* dst) {
+    memset(dst, 0, sizeof(drmModeModeInfo));
+    dst->hdisplay = src.width;
+    dst->vdisplay = src.height;
+    dst->vrefresh = src.refresh;
+    if (src.interlace)
+        dst->flags |= DRM_MODE_FLAG_INTERLACE;
+#ifndef VPG_DRM
+    if (src.aspect == FAKE_ASPECT_16_9)
+        dst->flags |= DRM_MODE_FLAG_PAR16_9;
+    else if (src.aspect == FAKE_ASPECT_4_3)
+        dst->flags |= DRM_MODE_FLAG_PAR4_3;
+#else
+    if (src.aspect == FAKE_ASPECT_16_9)
+        dst->picture_aspect_ratio = HDMI_PICTURE_ASPECT_16_9;
+    else if (src.aspect == FAKE_ASPECT_4_3)
+        dst->picture_aspect_ratio = HDMI_PICTURE_ASPECT_4_3;
+#endif
+    if (src.preferred)
+        dst->type |= DRM_MODE_TYPE_PREFERRED;
+}
+
+int fakeDrmGetSinkCount() {
+    return CORPUS_SIZE;
+}
+
+const char* fakeDrmGetSinkName(int sink) {
+    if (sink < 0 || sink >= CORPUS_SIZE)
+        return NULL;
+    return sCorpus[sink].name;
+}
+
+int fakeDrmGetSinkModeCount(int sink) {
+    if (sink < 0 || sink >= CORPUS_SIZE)
+        return 0;
+    return sCorpus[sink].count;
+}
+
+void fakeDrmConnect(int sink) {
+    initLargeModes();
+    if (sink < 0 || sink >= CORPUS_SIZE) {
+        sCurrent = -1;
+        return;
+    }
+    buildEdid(sink);
+    sCurrent = sink;
+}
+
+}; // namespace intel
+}; // namespace android
+
+using namespace android::intel;
+
+// The libdrm entries used by drm_hdmi.cpp, allocated like libdrm does
+int drmOpen(const char* name, const char* busid) {
+    return open("/dev/null", O_RDWR);
+}
+
+int drmClose(int fd) {
+    return close(fd);
+}
+
+int drmCommandWriteRead(int fd, unsigned long drmCommandIndex,
+        void* data, unsigned long size) {
+    return 0;
+}
+
+drmModeResPtr drmModeGetResources(int fd) {
+    drmModeResPtr res = (drmModeResPtr)calloc(1, sizeof(drmModeRes));
+    if (res == NULL)
+        return NULL;
+    res->count_connectors = 2;
+    res->connectors = (uint32_t*)calloc(2, sizeof(uint32_t));
+    if (res->connectors == NULL) {
+        free(res);
+        return NULL;
+    }
+    res->connectors[0] = FAKE_PANEL_ID;
+    res->connectors[1] = FAKE_EXTERNAL_ID;
+    return res;
+}
+
+void drmModeFreeResources(drmModeResPtr ptr) {
+    if (ptr == NULL)
+        return;
+    free(ptr->connectors);
+    free(ptr);
+}
+
+drmModeConnectorPtr drmModeGetConnector(int fd, uint32_t connectorId) {
+    if (connectorId != FAKE_PANEL_ID && connectorId != FAKE_EXTERNAL_ID)
+        return NULL;
+    drmModeConnectorPtr con = (drmModeConnectorPtr)calloc(1, sizeof(drmModeConnector));
+    if (con == NULL)
+        return NULL;
+    con->connector_id = connectorId;
+    if (connectorId == FAKE_PANEL_ID) {
+        con->connector_type = DRM_MODE_CONNECTOR_LVDS;
+        con->connection = DRM_MODE_CONNECTED;
+        return con;
+    }
+#ifndef VPG_DRM
+    con->connector_type = DRM_MODE_CONNECTOR_DVID;
+#else
+    con->connector_type = DRM_MODE_CONNECTOR_HDMIA;
+#endif
+    int sink = sCurrent;
+    if (sink < 0) {
+        con->connection = DRM_MODE_DISCONNECTED;
+        return con;
+    }
+    const FakeSink& entry = sCorpus[sink];
+    con->connection = DRM_MODE_CONNECTED;
+    con->modes = (drmModeModeInfoPtr)calloc(entry.count, sizeof(drmModeModeInfo));
+    con->props = (uint32_t*)calloc(2, sizeof(uint32_t));
+    con->prop_values = (uint64_t*)calloc(2, sizeof(uint64_t));
+    if (con->modes == NULL || con->props == NULL || con->prop_values == NULL) {
+        drmModeFreeConnector(con);
+        return NULL;
+    }
+    con->count_modes = entry.count;
+    for (int i = 0; i < entry.count; i++)
+        fillMode(entry.modes[i], &con->modes[i]);
+    con->count_props = 2;
+    con->props[0] = FAKE_DPMS_PROP;
+    con->props[1] = FAKE_EDID_PROP;
+    con->prop_values[0] = DRM_MODE_DPMS_ON;
+    con->prop_values[1] = FAKE_EDID_BLOB;
+    return con;
+}
+
+void drmModeFreeConnector(drmModeConnectorPtr ptr) {
+    if (ptr == NULL)
+        return;
+    free(ptr->modes);
+    free(ptr->props);
+    free(ptr->prop_values);
+    free(ptr);
+}
+
+drmModePropertyPtr drmModeGetProperty(int fd, uint32_t propertyId) {
+    const char* name = NULL;
+    if (propertyId == FAKE_DPMS_PROP)
+        name = "DPMS";
+    else if (propertyId == FAKE_EDID_PROP)
+        name = "EDID";
+    else
+        return NULL;
+    drmModePropertyPtr prop = (drmModePropertyPtr)calloc(1, sizeof(drmModePropertyRes));
+    if (prop == NULL)
+        return NULL;
+    prop->prop_id = propertyId;
+    strncpy(prop->name, name, sizeof(prop->name) - 1);
+    return prop;
+}
+
+void drmModeFreeProperty(drmModePropertyPtr ptr) {
+    free(ptr);
+}
+
+// drm_hdmi.cpp keeps the blob, so it is a static one here
+drmModePropertyBlobPtr drmModeGetPropertyBlob(int fd, uint32_t blobId) {
+    if (blobId != FAKE_EDID_BLOB || sCurrent < 0)
+        return NULL;
+    return &sEdidBlob;
+}
+
+void drmModeFreePropertyBlob(drmModePropertyBlobPtr ptr) {
+}
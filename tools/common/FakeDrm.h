@@ -0,0 +1,43 @@
+/*
+ * Copyright (c) 2012-2013, Intel Corporation. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef __MDS_TOOLS_FAKE_DRM_H__
+#define __MDS_TOOLS_FAKE_DRM_H__
+
+namespace android {
+namespace intel {
+
+/*
+ * A libdrm stand-in for drm_hdmi.cpp, it has one internal panel and
+ * one external connector. The sink on the external connector is taken
+ * from a built-in EDID corpus, each sink has an EDID blob and the mode
+ * list the kernel would build from it.
+ */
+
+// The sinks of the corpus, from 0 to count - 1
+int  fakeDrmGetSinkCount();
+const char* fakeDrmGetSinkName(int sink);
+// The modes reported by the connector, duplicates included
+int  fakeDrmGetSinkModeCount(int sink);
+
+/** @brief Plug "sink" into the external connector, -1 unplugs it */
+void fakeDrmConnect(int sink);
+
+}; // namespace intel
+}; // namespace android
+
+#endif
@@ -0,0 +1,44 @@
+/*
+ * Copyright (c) 2012-2013, Intel Corporation. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef __MDS_TOOLS_COMPOSER_TEST_ACCESS_H__
+#define __MDS_TOOLS_COMPOSER_TEST_ACCESS_H__
+
+#include "MultiDisplayComposer.h"
+
+namespace android {
+namespace intel {
+
+/*
+ * The composer as the tools drive it, the protected hooks are made
+ * public here only, the service never builds this header.
+ */
+class MultiDisplayComposerTestAccess : public MultiDisplayComposer {
+public:
+    // Send a message to the listeners as the composer does
+    using MultiDisplayComposer::broadcastMessage;
+    // Commit an HDMI hotplug without the debouncer
+    using MultiDisplayComposer::commitHdmiHotplug;
+    // The state of each session, MDS_VIDEO_SESSION_MAX_VALUE entries
+    using MultiDisplayComposer::getVideoStates;
+    using MultiDisplayComposer::getListenerCount;
+};
+
+}; // namespace intel
+}; // namespace android
+
+#endif
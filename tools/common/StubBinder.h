@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2012-2013, Intel Corporation. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef __MDS_TOOLS_STUB_BINDER_H__
+#define __MDS_TOOLS_STUB_BINDER_H__
+
+#include <cutils/atomic.h>
+#include <binder/Parcel.h>
+#include <display/IMultiDisplayListener.h>
+#include <display/IMultiDisplayCallback.h>
+#include "MultiDisplayMarshal.h"
+
+namespace android {
+namespace intel {
+
+// The client end of a listener, it counts the messages by type
+class StubListener : public BnMultiDisplayListener {
+public:
+    StubListener() : mCount(0), mModeCount(0), mReadyCount(0), mStateCount(0) {}
+    virtual status_t onMdsMessage(int msg, void* value, int size) {
+        android_atomic_inc(&mCount);
+        if (msg == MDS_MSG_MODE_CHANGE)
+            android_atomic_inc(&mModeCount);
+        else if (msg == MDS_MSG_READY)
+            android_atomic_inc(&mReadyCount);
+        else if (msg == MDS_MSG_DISPLAY_STATE)
+            android_atomic_inc(&mStateCount);
+        return NO_ERROR;
+    }
+    inline int32_t getCount() {
+        return android_atomic_acquire_load(&mCount);
+    }
+    // The count of one MDS_MESSAGE
+    inline int32_t getCount(int msg) {
+        if (msg == MDS_MSG_MODE_CHANGE)
+            return android_atomic_acquire_load(&mModeCount);
+        if (msg == MDS_MSG_READY)
+            return android_atomic_acquire_load(&mReadyCount);
+        if (msg == MDS_MSG_DISPLAY_STATE)
+            return android_atomic_acquire_load(&mStateCount);
+        return 0;
+    }
+private:
+    volatile int32_t mCount;
+    volatile int32_t mModeCount;
+    volatile int32_t mReadyCount;
+    volatile int32_t mStateCount;
+};
+
+/*
+ * The in-process stand-in of the binder driver: a message is written
+ * into a parcel the way BpMultiDisplayListener does, then the parcel is
+ * passed to the stub of the local listener, which reads it back.
+ * The cost is the marshalling on both ends, without a context switch.
+ */
+class LoopbackListener : public BnMultiDisplayListener {
+public:
+    LoopbackListener(const sp<IMultiDisplayListener>& target)
+        : mTarget(target->asBinder()) {}
+    virtual status_t onMdsMessage(int msg, void* value, int size) {
+        Parcel data, reply;
+        data.writeInterfaceToken(IMultiDisplayListener::descriptor);
+        status_t result = mdsWriteMessage(data, msg, value, size);
+        if (result != NO_ERROR)
+            return result;
+        result = mTarget->transact(
+                IBinder::FIRST_CALL_TRANSACTION, data, &reply);
+        if (result != NO_ERROR)
+            return result;
+        if (mdsRead(reply, &result) != NO_ERROR)
+            return NOT_ENOUGH_DATA;
+        return result;
+    }
+private:
+    sp<IBinder> mTarget;
+};
+
+// HWC's end of the callback, every call succeeds at once
+class StubCallback : public BnMultiDisplayCallback {
+public:
+    virtual status_t blankSecondaryDisplay(bool blank) {
+        return NO_ERROR;
+    }
+    virtual status_t updateVideoState(int sessionId, MDS_VIDEO_STATE state) {
+        return NO_ERROR;
+    }
+    virtual status_t setHdmiTiming(const MDSHdmiTiming& timing) {
+        return NO_ERROR;
+    }
+    virtual status_t setHdmiScalingType(MDS_SCALING_TYPE type) {
+        return NO_ERROR;
+    }
+    virtual status_t setHdmiOverscan(int hValue, int vValue) {
+        return NO_ERROR;
+    }
+    virtual status_t updateInputState(bool state) {
+        return NO_ERROR;
+    }
+    virtual status_t setDisplayConfig(const MDSDisplayConfig& config) {
+        return NO_ERROR;
+    }
+    virtual uint32_t getCapabilities() {
+        return MDS_CB_CAP_LEGACY;
+    }
+};
+
+}; // namespace intel
+}; // namespace android
+
+#endif
@@ -0,0 +1,38 @@
+# The build flags of the composer core in the tools, the same as the
+# ones of libmultidisplay. Included by tools/common/Android.mk, and by
+# each tool after its own sources, module and LOG_TAG.
+
+LOCAL_C_INCLUDES += \
+    $(LOCAL_PATH)/../common \
+    $(LOCAL_PATH)/../../native \
+    $(LOCAL_PATH)/../../shared \
+    $(TARGET_OUT_HEADERS)/libdrm
+
+LOCAL_SHARED_LIBRARIES += \
+    libcutils libutils libbinder
+
+# The persisted state and the DRM node of the service are left alone
+LOCAL_CFLAGS += \
+    -DMDS_DATA_DIR=\"/data/local/tmp\" \
+    -DDRM_DEVICE_NAME=\"/dev/null\"
+LOCAL_CPPFLAGS += -std=gnu++11
+
+ifeq ($(ENABLE_IMG_GRAPHICS),true)
+LOCAL_C_INCLUDES += \
+    $(TARGET_OUT_HEADERS)/pvr/pvr2d \
+    $(TARGET_OUT_HEADERS)/libttm
+LOCAL_CFLAGS += -DENABLE_DRM -DDVI_SUPPORTED
+endif
+
+ifeq ($(ENABLE_GEN_GRAPHICS),true)
+LOCAL_C_INCLUDES += \
+    $(TARGET_OUT_HEADERS)/external/drm
+LOCAL_CFLAGS += -DDVI_SUPPORTED -DVPG_DRM
+endif
+
+ifeq ($(MDS_ENABLE_TRACE),true)
+LOCAL_CFLAGS += -DMDS_TRACE
+endif
+ifeq ($(MDS_ENABLE_LOCK_PROFILE),true)
+LOCAL_CFLAGS += -DMDS_LOCK_PROFILE
+endif
@@ -0,0 +1,24 @@
+# Benchmarks of the composer core, see mds_bench.cpp
+#
+# The composer core is linked from tools/common with a fake libdrm, so it runs
+# on any device of the target, beside the real service:
+#   mmm vendor/intel/hardware/libmultidisplay/tools
+#   adb shell /data/local/tmp/mds_bench -o /data/local/tmp/mds_bench.json
+
+LOCAL_PATH:= $(call my-dir)
+
+ifneq ($(filter true,$(ENABLE_IMG_GRAPHICS) $(ENABLE_GEN_GRAPHICS)),)
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES := mds_bench.cpp
+
+LOCAL_MODULE := mds_bench
+LOCAL_MODULE_TAGS := optional
+LOCAL_MODULE_PATH := $(TARGET_OUT_DATA)/local/tmp
+
+LOCAL_STATIC_LIBRARIES := libmds_tools_core
+LOCAL_CFLAGS := -DLOG_TAG=\"MultiDisplayBench\"
+
+include $(LOCAL_PATH)/../common/mds_tool.mk
+include $(BUILD_EXECUTABLE)
+endif
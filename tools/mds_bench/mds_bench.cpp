@@ -0,0 +1,459 @@
+/*
+ * Copyright (c) 2012-2013, Intel Corporation. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/*
+ * Benchmarks of the composer core, it runs on the real composer and
+ * drm_hdmi.cpp, with a fake libdrm and the listeners in this process.
+ *
+ * usage: mds_bench [-i operations] [-f filter] [-o file]
+ *   -i  the operations timed per run, 2000 by default
+ *   -f  only the benchmarks whose name contains "filter"
+ *   -o  write the JSON report into "file" instead of stdout
+ *
+ * The report is the JSON of BenchReport.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <utils/String8.h>
+#include <utils/threads.h>
+
+#include "MultiDisplayComposerTestAccess.h"
+#include "drm_hdmi.h"
+#include "FakeDrm.h"
+#include "StubBinder.h"
+#include "BenchReport.h"
+#include "BenchWorker.h"
+
+namespace android {
+namespace intel {
+
+static const int DEFAULT_OPERATIONS = 2000;
+// getDisplayMode is too fast to time one by one
+static const int MODE_READ_BATCH = 256;
+static const int READY_TIMEOUT_MS = 5000;
+
+static const MDS_VIDEO_STATE sVideoCycle[] = {
+    MDS_VIDEO_PREPARING,
+    MDS_VIDEO_PREPARED,
+    MDS_VIDEO_UNPREPARING,
+    MDS_VIDEO_UNPREPARED,
+};
+static const int VIDEO_CYCLE_LEN = sizeof(sVideoCycle) / sizeof(sVideoCycle[0]);
+
+class MultiDisplayBenchmark {
+public:
+    MultiDisplayBenchmark(int operations, const char* filter, BenchReport& report)
+        : mOperations(operations), mFilter(filter), mReport(report) {}
+
+    void runDrm();
+    status_t runComposer();
+
+private:
+    int mOperations;
+    const char* mFilter;
+    BenchReport& mReport;
+    sp<MultiDisplayComposerTestAccess> mComposer;
+
+    inline bool enabled(const char* name) {
+        return mFilter == NULL || strstr(name, mFilter) != NULL;
+    }
+    int32_t addListener(Vector<int32_t>& ids);
+    void removeListeners(Vector<int32_t>& ids);
+
+    void runListenerChurn(int registered);
+    void runBroadcastFanout(int listeners);
+    void runVideo(const char* name, int threads);
+    void runDisplayModeContention(int readers, int writers);
+};
+
+// Probe and parse each sink of the corpus, like a hotplug does
+void MultiDisplayBenchmark::runDrm() {
+    if (!enabled("edid_probe") && !enabled("timing_parse"))
+        return;
+    if (!drm_init()) {
+        fprintf(stderr, "drm_init failed\n");
+        return;
+    }
+    for (int sink = 0; sink < fakeDrmGetSinkCount(); sink++) {
+        fakeDrmConnect(sink);
+        BenchSamples probe, parse;
+        int status = DRM_HDMI_DISCONNECTED;
+        int timings = 0;
+        nsecs_t wall = systemTime();
+        for (int i = 0; i < mOperations; i++) {
+            nsecs_t t0 = systemTime();
+            // The EDID blob read and the preferred mode selection
+            status = drm_hdmi_getConnectionStatus(0);
+            nsecs_t t1 = systemTime();
+            timings = drm_hdmi_getTimingNumber(0);
+            nsecs_t t2 = systemTime();
+            drm_hdmi_onHdmiDisconnected(0);
+            probe.add(t1 - t0);
+            parse.add(t2 - t1);
+        }
+        wall = systemTime() - wall;
+        probe.setWallTime(wall);
+        parse.setWallTime(wall);
+        String8 config;
+        config.appendFormat("\"sink\": \"%s\", \"modes\": %d, \"timings\": %d, "
+                "\"status\": %d", fakeDrmGetSinkName(sink),
+                fakeDrmGetSinkModeCount(sink), timings, status);
+        if (enabled("edid_probe"))
+            mReport.add("edid_probe", config, probe);
+        if (enabled("timing_parse"))
+            mReport.add("timing_parse", config, parse);
+    }
+    fakeDrmConnect(-1);
+    drm_cleanup();
+}
+
+int32_t MultiDisplayBenchmark::addListener(Vector<int32_t>& ids) {
+    sp<IMultiDisplayListener> listener =
+        new LoopbackListener(new StubListener());
+    int32_t id = mComposer->registerListener(listener,
+            "BenchListener", MDS_MSG_MODE_CHANGE);
+    if (id >= 0)
+        ids.add(id);
+    return id;
+}
+
+void MultiDisplayBenchmark::removeListeners(Vector<int32_t>& ids) {
+    for (size_t i = 0; i < ids.size(); i++)
+        mComposer->unregisterListener(ids[i]);
+    ids.clear();
+}
+
+// Register and unregister a listener with "registered" ones in the table
+void MultiDisplayBenchmark::runListenerChurn(int registered) {
+    Vector<int32_t> ids;
+    for (int i = 0; i < registered; i++) {
+        if (addListener(ids) < 0) {
+            fprintf(stderr, "listener_churn: fail to register %d listeners\n", registered);
+            removeListeners(ids);
+            return;
+        }
+    }
+    sp<IMultiDisplayListener> listener =
+        new LoopbackListener(new StubListener());
+    BenchSamples samples;
+    nsecs_t wall = systemTime();
+    for (int i = 0; i < mOperations; i++) {
+        nsecs_t t0 = systemTime();
+        int32_t id = mComposer->registerListener(listener,
+                "BenchListener", MDS_MSG_MODE_CHANGE);
+        mComposer->unregisterListener(id);
+        samples.add(systemTime() - t0);
+        if (id < 0) {
+            fprintf(stderr, "listener_churn: fail to register a listener\n");
+            break;
+        }
+    }
+    samples.setWallTime(systemTime() - wall);
+    removeListeners(ids);
+    String8 config;
+    config.appendFormat("\"registered\": %d", registered);
+    mReport.add("listener_churn", config, samples);
+}
+
+// A broadcast to "listeners" loopback listeners
+void MultiDisplayBenchmark::runBroadcastFanout(int listeners) {
+    Vector<int32_t> ids;
+    Vector<sp<StubListener> > sinks;
+    for (int i = 0; i < listeners; i++) {
+        sp<StubListener> sink = new StubListener();
+        int32_t id = mComposer->registerListener(new LoopbackListener(sink),
+                "BenchListener", MDS_MSG_MODE_CHANGE);
+        if (id < 0) {
+            fprintf(stderr, "broadcast_fanout: fail to register %d listeners\n", listeners);
+            removeListeners(ids);
+            return;
+        }
+        ids.add(id);
+        sinks.add(sink);
+    }
+    int32_t mode = mComposer->getDisplayMode(false);
+    BenchSamples samples;
+    nsecs_t wall = systemTime();
+    for (int i = 0; i < mOperations; i++) {
+        nsecs_t t0 = systemTime();
+        mComposer->broadcastMessage((int)MDS_MSG_MODE_CHANGE, &mode, sizeof(mode), false);
+        samples.add(systemTime() - t0);
+    }
+    samples.setWallTime(systemTime() - wall);
+    removeListeners(ids);
+    for (size_t i = 0; i < sinks.size(); i++) {
+        if (sinks[i]->getCount() != mOperations)
+            fprintf(stderr, "broadcast_fanout: listener %d got %d of %d messages\n",
+                    (int)i, sinks[i]->getCount(), mOperations);
+    }
+    String8 config;
+    config.appendFormat("\"listeners\": %d", listeners);
+    mReport.add("broadcast_fanout", config, samples);
+}
+
+/*
+ * Drive the sessions "first", "first + step"... through the video state
+ * cycle, or update their source info. The sessions move in step,
+ * so all of them are active at the same time.
+ */
+class BenchVideoWorker : public BenchWorker {
+public:
+    BenchVideoWorker(BenchGate& gate, MultiDisplayComposer* composer,
+            bool info, int first, int step, int rounds)
+        : BenchWorker(gate), mComposer(composer), mInfo(info),
+          mFirst(first), mStep(step), mRounds(rounds) {}
+private:
+    MultiDisplayComposer* mComposer;
+    bool mInfo;
+    int  mFirst;
+    int  mStep;
+    int  mRounds;
+
+    virtual void work() {
+        MDSVideoSourceInfo info;
+        memset(&info, 0, sizeof(info));
+        info.displayW = 1920;
+        info.displayH = 1080;
+        for (int r = 0; r < mRounds; r++) {
+            for (int c = 0; c < VIDEO_CYCLE_LEN; c++) {
+                // A changed info is written into the snapshot
+                info.frameRate = ((r * VIDEO_CYCLE_LEN + c) & 1) ? 30 : 24;
+                for (int s = mFirst; s < MDS_VIDEO_SESSION_MAX_VALUE; s += mStep) {
+                    nsecs_t t0 = systemTime();
+                    if (mInfo)
+                        mComposer->updateVideoSourceInfo(s, info);
+                    else
+                        mComposer->updateVideoState(s, sVideoCycle[c]);
+                    mSamples.add(systemTime() - t0);
+                }
+            }
+        }
+    }
+};
+
+// All the video sessions, driven by "threads" threads
+void MultiDisplayBenchmark::runVideo(const char* name, int threads) {
+    bool info = (strcmp(name, "video_source_info") == 0);
+    int perRound = MDS_VIDEO_SESSION_MAX_VALUE * VIDEO_CYCLE_LEN;
+    int rounds = (mOperations + perRound - 1) / perRound;
+    BenchGate gate;
+    Vector<sp<BenchVideoWorker> > workers;
+    for (int i = 0; i < threads; i++) {
+        sp<BenchVideoWorker> worker = new BenchVideoWorker(gate,
+                mComposer.get(), info, i, threads, rounds);
+        if (worker->run("MDSBenchVideo", PRIORITY_DEFAULT) != NO_ERROR) {
+            fprintf(stderr, "%s: fail to start a worker\n", name);
+            gate.open();
+            break;
+        }
+        workers.add(worker);
+    }
+    nsecs_t wall = systemTime();
+    gate.open();
+    BenchSamples samples;
+    for (size_t i = 0; i < workers.size(); i++) {
+        workers[i]->join();
+        samples.merge(workers[i]->mSamples);
+    }
+    samples.setWallTime(systemTime() - wall);
+    mComposer->resetVideoPlayback();
+    String8 config;
+    config.appendFormat("\"sessions\": %d, \"threads\": %d",
+            MDS_VIDEO_SESSION_MAX_VALUE, threads);
+    mReport.add(name, config, samples);
+}
+
+// Read the mode in batches
+class BenchModeReader : public BenchWorker {
+public:
+    BenchModeReader(BenchGate& gate, MultiDisplayComposer* composer, int batches)
+        : BenchWorker(gate), mComposer(composer), mBatches(batches) {}
+private:
+    MultiDisplayComposer* mComposer;
+    int mBatches;
+
+    virtual void work() {
+        for (int b = 0; b < mBatches; b++) {
+            nsecs_t t0 = systemTime();
+            for (int i = 0; i < MODE_READ_BATCH; i++)
+                mComposer->getDisplayMode(false);
+            mSamples.add(systemTime() - t0, MODE_READ_BATCH);
+        }
+    }
+};
+
+// Toggle the WiDi connection, each toggle updates the mode
+class BenchModeWriter : public BenchWorker {
+public:
+    BenchModeWriter(BenchGate& gate, MultiDisplayComposer* composer)
+        : BenchWorker(gate), mWrites(0), mComposer(composer) {}
+    int64_t mWrites;
+private:
+    MultiDisplayComposer* mComposer;
+
+    virtual void work() {
+        bool connected = false;
+        while (!exitPending()) {
+            connected = !connected;
+            mComposer->updateWidiConnectionStatus(connected);
+            mWrites++;
+        }
+        if (connected)
+            mComposer->updateWidiConnectionStatus(false);
+    }
+};
+
+void MultiDisplayBenchmark::runDisplayModeContention(int readers, int writers) {
+    BenchGate gate;
+    Vector<sp<BenchModeWriter> > writerThreads;
+    Vector<sp<BenchModeReader> > readerThreads;
+    for (int i = 0; i < writers; i++) {
+        sp<BenchModeWriter> writer = new BenchModeWriter(gate, mComposer.get());
+        if (writer->run("MDSBenchWriter", PRIORITY_DEFAULT) == NO_ERROR)
+            writerThreads.add(writer);
+    }
+    for (int i = 0; i < readers; i++) {
+        sp<BenchModeReader> reader =
+            new BenchModeReader(gate, mComposer.get(), mOperations);
+        if (reader->run("MDSBenchReader", PRIORITY_DEFAULT) == NO_ERROR)
+            readerThreads.add(reader);
+    }
+    nsecs_t wall = systemTime();
+    gate.open();
+    BenchSamples samples;
+    for (size_t i = 0; i < readerThreads.size(); i++) {
+        readerThreads[i]->join();
+        samples.merge(readerThreads[i]->mSamples);
+    }
+    samples.setWallTime(systemTime() - wall);
+    int64_t writes = 0;
+    for (size_t i = 0; i < writerThreads.size(); i++) {
+        writerThreads[i]->requestExitAndWait();
+        writes += writerThreads[i]->mWrites;
+    }
+    String8 config;
+    config.appendFormat("\"readers\": %d, \"writers\": %d, \"writes\": %lld",
+            (int)readerThreads.size(), (int)writerThreads.size(), (long long)writes);
+    mReport.add("display_mode_contention", config, samples);
+}
+
+status_t MultiDisplayBenchmark::runComposer() {
+    // An HDMI TV is connected at the bring-up
+    fakeDrmConnect(0);
+    mComposer = new MultiDisplayComposerTestAccess();
+    int waited = 0;
+    while (!mComposer->isReady() && waited < READY_TIMEOUT_MS) {
+        usleep(1000);
+        waited++;
+    }
+    if (!mComposer->isReady()) {
+        fprintf(stderr, "MDS isn't ready in %d ms\n", READY_TIMEOUT_MS);
+        mComposer = NULL;
+        return TIMED_OUT;
+    }
+    sp<IMultiDisplayCallback> callback = new StubCallback();
+    mComposer->registerCallback(callback);
+
+    static const int churnRegistered[] = { 0, 16, 48 };
+    if (enabled("listener_churn")) {
+        for (size_t i = 0; i < sizeof(churnRegistered) / sizeof(int); i++)
+            runListenerChurn(churnRegistered[i]);
+    }
+    static const int fanout[] = { 1, 4, 16, 64 };
+    if (enabled("broadcast_fanout")) {
+        for (size_t i = 0; i < sizeof(fanout) / sizeof(int); i++)
+            runBroadcastFanout(fanout[i]);
+    }
+    static const int videoThreads[] = { 1, 4, 16 };
+    for (size_t i = 0; i < sizeof(videoThreads) / sizeof(int); i++) {
+        if (enabled("video_state"))
+            runVideo("video_state", videoThreads[i]);
+        if (enabled("video_source_info"))
+            runVideo("video_source_info", videoThreads[i]);
+    }
+    if (enabled("display_mode_contention")) {
+        runDisplayModeContention(1, 0);
+        runDisplayModeContention(1, 1);
+        runDisplayModeContention(4, 1);
+    }
+
+    mComposer->unregisterCallback(callback);
+    mComposer = NULL;
+    fakeDrmConnect(-1);
+    return NO_ERROR;
+}
+
+}; // namespace intel
+}; // namespace android
+
+using namespace android;
+using namespace android::intel;
+
+static void usage(const char* name) {
+    fprintf(stderr, "usage: %s [-i operations] [-f filter] [-o file]\n", name);
+}
+
+int main(int argc, char** argv) {
+    int operations = DEFAULT_OPERATIONS;
+    const char* filter = NULL;
+    const char* path = NULL;
+    int opt;
+    while ((opt = getopt(argc, argv, "i:f:o:h")) != -1) {
+        switch (opt) {
+            case 'i':
+                operations = atoi(optarg);
+                break;
+            case 'f':
+                filter = optarg;
+                break;
+            case 'o':
+                path = optarg;
+                break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+    if (operations <= 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    BenchReport report("mds_bench");
+    MultiDisplayBenchmark bench(operations, filter, report);
+    bench.runDrm();
+    if (bench.runComposer() != NO_ERROR)
+        return 1;
+
+    FILE* file = stdout;
+    if (path != NULL) {
+        file = fopen(path, "w");
+        if (file == NULL) {
+            fprintf(stderr, "Fail to open %s\n", path);
+            return 1;
+        }
+    }
+    String8 members;
+    members.appendFormat("  \"operations\": %d,\n", operations);
+    report.write(file, members);
+    if (file != stdout)
+        fclose(file);
+    return 0;
+}
@@ -0,0 +1,378 @@
+/*
+ * Copyright (c) 2012-2013, Intel Corporation. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/*
+ * End to end HDMI hotplug latency: a hotplug is notified through
+ * IMultiDisplayConnectionObserver, as the uevent observer does, and the
+ * time is taken till MDS_MSG_MODE_CHANGE reaches a listener registered
+ * through IMultiDisplaySinkRegistrar, and till each call of a callback
+ * registered through IMultiDisplayCallbackRegistrar.
+ * The debounce window of the service is part of the latency.
+ *
+ * The service probes DRM at each notification, so it runs in this
+ * process on a fake libdrm, where the sink is plugged and unplugged
+ * before the notification. The real service would see no change.
+ *
+ * usage: mds_hotplug_bench [-i iterations] [-s sink] [-t index] [-g ms] [-o file]
+ *   -i  the connect/disconnect cycles, 100 by default
+ *   -s  the sink of the EDID corpus, 0 by default
+ *   -t  select the timing "index" before the cycles, so each connect
+ *       restores it through the callback
+ *   -g  the time given to the late callbacks after the message, 20 ms
+ *   -o  write the JSON report into "file" instead of stdout
+ *
+ * The report is the JSON of BenchReport, a result per event, named
+ * "connect_" or "disconnect_" and "mode_change" or the callback method.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <utils/KeyedVector.h>
+#include <utils/String8.h>
+#include <utils/threads.h>
+#include <display/MultiDisplayService.h>
+
+#include "FakeDrm.h"
+#include "StubBinder.h"
+#include "BenchReport.h"
+
+namespace android {
+namespace intel {
+
+static const int DEFAULT_ITERATIONS = 100;
+static const int DEFAULT_GRACE_MS = 20;
+// Longer than the debounce window and a DDC probe
+static const int EVENT_TIMEOUT_MS = 3000;
+static const int READY_TIMEOUT_MS = 5000;
+
+static const char* MODE_CHANGE = "mode_change";
+
+/*
+ * The time of the first occurrence of each event since arm(),
+ * the events are string literals, matched by address.
+ */
+class HotplugClock {
+public:
+    HotplugClock() : mConnected(false), mStart(0) {}
+
+    void arm(bool connected) {
+        Mutex::Autolock lock(mLock);
+        mConnected = connected;
+        mEvents.clear();
+        mStart = systemTime();
+    }
+    void mark(const char* event) {
+        nsecs_t now = systemTime();
+        Mutex::Autolock lock(mLock);
+        if (mEvents.indexOfKey(event) >= 0)
+            return;
+        mEvents.add(event, now);
+        mCondition.broadcast();
+    }
+    void markMode(int32_t mode) {
+        bool connected = (mode & (MDS_HDMI_CONNECTED | MDS_DVI_CONNECTED)) != 0;
+        {
+            Mutex::Autolock lock(mLock);
+            if (connected != mConnected)
+                return;
+        }
+        mark(MODE_CHANGE);
+    }
+    bool wait(const char* event, int timeoutMs) {
+        nsecs_t deadline = systemTime() + ms2ns(timeoutMs);
+        Mutex::Autolock lock(mLock);
+        while (mEvents.indexOfKey(event) < 0) {
+            nsecs_t now = systemTime();
+            if (now >= deadline)
+                return false;
+            mCondition.waitRelative(mLock, deadline - now);
+        }
+        return true;
+    }
+    // The events seen since arm(), with their latency
+    void collect(KeyedVector<const char*, nsecs_t>& events) {
+        Mutex::Autolock lock(mLock);
+        events.clear();
+        for (size_t i = 0; i < mEvents.size(); i++)
+            events.add(mEvents.keyAt(i), mEvents.valueAt(i) - mStart);
+    }
+
+private:
+    Mutex     mLock;
+    Condition mCondition;
+    bool      mConnected;
+    nsecs_t   mStart;
+    KeyedVector<const char*, nsecs_t> mEvents;
+};
+
+class HotplugListener : public BnMultiDisplayListener {
+public:
+    HotplugListener(HotplugClock& clock) : mClock(clock) {}
+    virtual status_t onMdsMessage(int msg, void* value, int size) {
+        if (msg == MDS_MSG_MODE_CHANGE && value != NULL && size >= (int)sizeof(int32_t))
+            mClock.markMode(*(int32_t*)value);
+        return NO_ERROR;
+    }
+private:
+    HotplugClock& mClock;
+};
+
+class HotplugCallback : public BnMultiDisplayCallback {
+public:
+    HotplugCallback(HotplugClock& clock) : mClock(clock) {}
+    virtual status_t blankSecondaryDisplay(bool blank) {
+        mClock.mark("blankSecondaryDisplay");
+        return NO_ERROR;
+    }
+    virtual status_t updateVideoState(int sessionId, MDS_VIDEO_STATE state) {
+        mClock.mark("updateVideoState");
+        return NO_ERROR;
+    }
+    virtual status_t setHdmiTiming(const MDSHdmiTiming& timing) {
+        mClock.mark("setHdmiTiming");
+        return NO_ERROR;
+    }
+    virtual status_t setHdmiScalingType(MDS_SCALING_TYPE type) {
+        mClock.mark("setHdmiScalingType");
+        return NO_ERROR;
+    }
+    virtual status_t setHdmiOverscan(int hValue, int vValue) {
+        mClock.mark("setHdmiOverscan");
+        return NO_ERROR;
+    }
+    virtual status_t updateInputState(bool state) {
+        mClock.mark("updateInputState");
+        return NO_ERROR;
+    }
+    virtual status_t setDisplayConfig(const MDSDisplayConfig& config) {
+        mClock.mark("setDisplayConfig");
+        return NO_ERROR;
+    }
+    virtual uint32_t getCapabilities() {
+        return MDS_CB_CAP_LEGACY;
+    }
+private:
+    HotplugClock& mClock;
+};
+
+class MultiDisplayHotplugBench {
+public:
+    MultiDisplayHotplugBench(int sink, int graceMs, BenchReport& report)
+        : mSink(sink), mGraceMs(graceMs),
+          mReport(report), mListenerId(-1), mTimeouts(0), mCycles(0) {}
+
+    status_t setUp(int timingIndex);
+    void run(int iterations);
+    void tearDown();
+    void getMembers(String8& members);
+
+private:
+    int  mSink;
+    int  mGraceMs;
+    BenchReport& mReport;
+
+    sp<IMDService> mService;
+    sp<IMultiDisplayConnectionObserver> mObserver;
+    sp<IMultiDisplaySinkRegistrar> mSinkRegistrar;
+    sp<IMultiDisplayCallbackRegistrar> mCallbackRegistrar;
+    HotplugClock mClock;
+    sp<HotplugListener> mListener;
+    sp<HotplugCallback> mCallback;
+    int32_t mListenerId;
+    // "connect_" or "disconnect_" and the event name
+    KeyedVector<String8, BenchSamples> mSamples;
+    int mTimeouts;
+    int mCycles;
+
+    bool hotplug(bool connected);
+};
+
+status_t MultiDisplayHotplugBench::setUp(int timingIndex) {
+    // An HDMI TV is connected at the bring-up
+    fakeDrmConnect(mSink);
+    mService = new MultiDisplayService();
+    sp<IMultiDisplayInfoProvider> info = mService->getInfoProvider();
+    int waited = 0;
+    while (!info->isReady() && waited < READY_TIMEOUT_MS) {
+        usleep(1000);
+        waited++;
+    }
+    if (!info->isReady()) {
+        fprintf(stderr, "MDS isn't ready in %d ms\n", READY_TIMEOUT_MS);
+        return TIMED_OUT;
+    }
+    mObserver = mService->getConnectionObserver();
+    mSinkRegistrar = mService->getSinkRegistrar();
+    mCallbackRegistrar = mService->getCallbackRegistrar();
+    if (mObserver == NULL || mSinkRegistrar == NULL || mCallbackRegistrar == NULL)
+        return NO_INIT;
+
+    // The messages are marshalled as the binder driver would do
+    mListener = new HotplugListener(mClock);
+    mListenerId = mSinkRegistrar->registerListener(new LoopbackListener(mListener),
+            "HotplugBench", MDS_MSG_MODE_CHANGE);
+    if (mListenerId < 0) {
+        fprintf(stderr, "Fail to register the listener\n");
+        return UNKNOWN_ERROR;
+    }
+    mCallback = new HotplugCallback(mClock);
+    mCallbackRegistrar->registerCallback(mCallback);
+    if (timingIndex >= 0) {
+        // Stored as the preference of the sink, restored at each connect
+        status_t err = mService->getHdmiControl()->setHdmiTimingByIndex(timingIndex);
+        if (err != NO_ERROR)
+            fprintf(stderr, "Fail to select timing %d, %d\n", timingIndex, err);
+    }
+    return NO_ERROR;
+}
+
+// Notify a hotplug and wait for the mode change, false if it times out
+bool MultiDisplayHotplugBench::hotplug(bool connected) {
+    fakeDrmConnect(connected ? mSink : -1);
+    mClock.arm(connected);
+    mObserver->updateHdmiConnectionStatus(connected);
+    if (!mClock.wait(MODE_CHANGE, EVENT_TIMEOUT_MS)) {
+        mTimeouts++;
+        return false;
+    }
+    usleep(mGraceMs * 1000);
+    KeyedVector<const char*, nsecs_t> events;
+    mClock.collect(events);
+    for (size_t i = 0; i < events.size(); i++) {
+        String8 name(connected ? "connect_" : "disconnect_");
+        name.append(events.keyAt(i));
+        ssize_t index = mSamples.indexOfKey(name);
+        if (index < 0)
+            index = mSamples.add(name, BenchSamples());
+        mSamples.editValueAt(index).add(events.valueAt(i));
+    }
+    return true;
+}
+
+void MultiDisplayHotplugBench::run(int iterations) {
+    // Start from a disconnected sink
+    fakeDrmConnect(-1);
+    mClock.arm(false);
+    mObserver->updateHdmiConnectionStatus(false);
+    mClock.wait(MODE_CHANGE, EVENT_TIMEOUT_MS);
+
+    for (int i = 0; i < iterations; i++) {
+        if (!hotplug(true)) {
+            fprintf(stderr, "No mode change after connect %d\n", i);
+            break;
+        }
+        if (!hotplug(false)) {
+            fprintf(stderr, "No mode change after disconnect %d\n", i);
+            break;
+        }
+        mCycles++;
+    }
+    for (size_t i = 0; i < mSamples.size(); i++)
+        mReport.add(mSamples.keyAt(i).string(), String8(), mSamples.editValueAt(i));
+}
+
+void MultiDisplayHotplugBench::tearDown() {
+    if (mSinkRegistrar != NULL && mListenerId >= 0)
+        mSinkRegistrar->unregisterListener(mListenerId);
+    if (mCallbackRegistrar != NULL && mCallback != NULL)
+        mCallbackRegistrar->unregisterCallback(mCallback);
+    mObserver = NULL;
+    mSinkRegistrar = NULL;
+    mCallbackRegistrar = NULL;
+    mService = NULL;
+    fakeDrmConnect(-1);
+}
+
+void MultiDisplayHotplugBench::getMembers(String8& members) {
+    members.appendFormat("  \"sink\": \"%s\",\n", fakeDrmGetSinkName(mSink));
+    members.appendFormat("  \"cycles\": %d,\n", mCycles);
+    members.appendFormat("  \"timeouts\": %d,\n", mTimeouts);
+}
+
+}; // namespace intel
+}; // namespace android
+
+using namespace android;
+using namespace android::intel;
+
+static void usage(const char* name) {
+    fprintf(stderr, "usage: %s [-i iterations] [-s sink] [-t index] [-g ms] [-o file]\n",
+            name);
+}
+
+int main(int argc, char** argv) {
+    int iterations = DEFAULT_ITERATIONS;
+    int sink = 0;
+    int timingIndex = -1;
+    int graceMs = DEFAULT_GRACE_MS;
+    const char* path = NULL;
+    int opt;
+    while ((opt = getopt(argc, argv, "i:s:t:g:o:h")) != -1) {
+        switch (opt) {
+            case 'i':
+                iterations = atoi(optarg);
+                break;
+            case 's':
+                sink = atoi(optarg);
+                break;
+            case 't':
+                timingIndex = atoi(optarg);
+                break;
+            case 'g':
+                graceMs = atoi(optarg);
+                break;
+            case 'o':
+                path = optarg;
+                break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+    if (iterations <= 0 || graceMs < 0 || sink < 0 || sink >= fakeDrmGetSinkCount()) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    BenchReport report("mds_hotplug_bench");
+    MultiDisplayHotplugBench bench(sink, graceMs, report);
+    if (bench.setUp(timingIndex) != NO_ERROR) {
+        bench.tearDown();
+        return 1;
+    }
+    bench.run(iterations);
+
+    FILE* file = stdout;
+    if (path != NULL) {
+        file = fopen(path, "w");
+        if (file == NULL) {
+            fprintf(stderr, "Fail to open %s\n", path);
+            bench.tearDown();
+            return 1;
+        }
+    }
+    String8 members;
+    members.appendFormat("  \"iterations\": %d,\n", iterations);
+    bench.getMembers(members);
+    bench.tearDown();
+    report.write(file, members);
+    if (file != stdout)
+        fclose(file);
+    return 0;
+}
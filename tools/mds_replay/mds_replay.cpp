@@ -0,0 +1,399 @@
+/*
+ * Copyright (c) 2012-2013, Intel Corporation. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/*
+ * Replay a log of MultiDisplayRecorder on the composer, built into this
+ * tool with a fake libdrm, stub listeners and a stub callback.
+ * A log is recorded on a device with:
+ *   setprop mds.record 1 (then restart the service)
+ * or, as root or shell
+ *   dumpsys display.intel.mds --record
+ *   dumpsys display.intel.mds --record-stop
+ * and then pulled from /data/system/mds.rec
+ *
+ * usage: mds_replay [-r] [-s sink] [-v] [-o file] log
+ *   -r  make the calls at their recorded time, by default they are made
+ *       back to back and an HDMI hotplug skips the debouncer
+ *   -s  the sink of the EDID corpus plugged by an HDMI hotplug, 0 by default
+ *   -v  print each call with its result and latency
+ *   -o  write the JSON report into "file" instead of stdout
+ *
+ * The report is the JSON of BenchReport, a result per call of the log.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <utils/KeyedVector.h>
+#include <utils/String8.h>
+
+#include "MultiDisplayComposerTestAccess.h"
+#include "MultiDisplayRecorder.h"
+#include "FakeDrm.h"
+#include "StubBinder.h"
+#include "BenchReport.h"
+
+namespace android {
+namespace intel {
+
+static const int READY_TIMEOUT_MS = 5000;
+// Time to let the debouncer and the listeners settle in real time mode
+static const int SETTLE_MS = 500;
+
+class MultiDisplayReplay {
+public:
+    MultiDisplayReplay(bool realTime, int sink, bool verbose, BenchReport& report)
+        : mRealTime(realTime), mSink(sink), mVerbose(verbose), mReport(report),
+          mStartMode(0), mFailures(0), mUnmapped(0) {}
+
+    status_t load(const char* path);
+    status_t run();
+    void getMembers(String8& members);
+
+private:
+    bool mRealTime;
+    int  mSink;
+    bool mVerbose;
+    BenchReport& mReport;
+
+    // The log is loaded before the composer is created, since the composer
+    // may record into the same file if mds.record is set
+    int32_t mStartMode;
+    Vector<MultiDisplayRecord> mRecords;
+    Vector<size_t>  mOffsets;
+    Vector<uint8_t> mArgs;
+
+    sp<MultiDisplayComposerTestAccess> mComposer;
+    sp<IMultiDisplayCallback> mCallback;
+    // Gets every message, the messages seen by the clients of the log
+    sp<StubListener> mObserver;
+    // The recorded listener ID to the one of the replay
+    KeyedVector<int32_t, int32_t> mListenerIds;
+    BenchSamples mSamples[MDS_REC_MAX];
+    int mFailures;
+    int mUnmapped;
+
+    status_t bringUp();
+    status_t replay(uint32_t op, const Parcel& args);
+};
+
+status_t MultiDisplayReplay::load(const char* path) {
+    MultiDisplayRecordReader reader;
+    status_t err = reader.open(path);
+    if (err != NO_ERROR) {
+        fprintf(stderr, "Fail to open %s, %d\n", path, err);
+        return err;
+    }
+    mStartMode = reader.getStartMode();
+    MultiDisplayRecord record;
+    Parcel args;
+    while ((err = reader.next(&record, &args)) == NO_ERROR) {
+        mRecords.add(record);
+        mOffsets.add(mArgs.size());
+        mArgs.appendArray(args.data(), args.dataSize());
+    }
+    // A truncated record is the end of a log cut by a crash
+    if (err == BAD_VALUE) {
+        fprintf(stderr, "%s is corrupted after %d records\n",
+                path, (int)mRecords.size());
+        return err;
+    }
+    return NO_ERROR;
+}
+
+status_t MultiDisplayReplay::bringUp() {
+    // The external display is as it was when the recording started
+    if (mStartMode & (MDS_HDMI_CONNECTED | MDS_DVI_CONNECTED))
+        fakeDrmConnect(mSink);
+    else
+        fakeDrmConnect(-1);
+    mComposer = new MultiDisplayComposerTestAccess();
+    mComposer->stopRecording();
+    int waited = 0;
+    while (!mComposer->isReady() && waited < READY_TIMEOUT_MS) {
+        usleep(1000);
+        waited++;
+    }
+    if (!mComposer->isReady()) {
+        fprintf(stderr, "MDS isn't ready in %d ms\n", READY_TIMEOUT_MS);
+        mComposer = NULL;
+        return TIMED_OUT;
+    }
+    mObserver = new StubListener();
+    mComposer->registerListener(new LoopbackListener(mObserver), "ReplayObserver",
+            MDS_MSG_MODE_CHANGE | MDS_MSG_READY | MDS_MSG_DISPLAY_STATE);
+    mCallback = new StubCallback();
+    if (mStartMode & MDS_WIDI_ON)
+        mComposer->updateWidiConnectionStatus(true);
+    // A video on at the start is left out, its session isn't in the log
+    return NO_ERROR;
+}
+
+status_t MultiDisplayReplay::replay(uint32_t op, const Parcel& args) {
+    MultiDisplayComposerTestAccess* composer = mComposer.get();
+    switch (op) {
+        case MDS_REC_ALLOCATE_VIDEO_SESSION_ID:
+            return (composer->allocateVideoSessionId() >= 0 ? NO_ERROR : UNKNOWN_ERROR);
+        case MDS_REC_UPDATE_VIDEO_STATE: {
+            int32_t sessionId = -1;
+            MDS_VIDEO_STATE state = MDS_VIDEO_STATE_UNKNOWN;
+            if (mdsRead(args, &sessionId, &state) != NO_ERROR)
+                return BAD_VALUE;
+            return composer->updateVideoState(sessionId, state);
+        }
+        case MDS_REC_RESET_VIDEO_PLAYBACK:
+            return composer->resetVideoPlayback();
+        case MDS_REC_UPDATE_VIDEO_SOURCE_INFO: {
+            int32_t sessionId = -1;
+            MDSVideoSourceInfo info;
+            memset(&info, 0, sizeof(info));
+            if (mdsRead(args, &sessionId, &info) != NO_ERROR)
+                return BAD_VALUE;
+            return composer->updateVideoSourceInfo(sessionId, info);
+        }
+        case MDS_REC_REGISTER_LISTENER: {
+            const char* name = NULL;
+            int32_t msg = 0;
+            int32_t id = -1;
+            if (mdsRead(args, &name, &msg, &id) != NO_ERROR)
+                return BAD_VALUE;
+            int32_t newId = composer->registerListener(
+                    new LoopbackListener(new StubListener()), name, msg);
+            if (newId < 0)
+                return UNKNOWN_ERROR;
+            mListenerIds.add(id, newId);
+            return NO_ERROR;
+        }
+        case MDS_REC_UNREGISTER_LISTENER: {
+            int32_t id = -1;
+            if (mdsRead(args, &id) != NO_ERROR)
+                return BAD_VALUE;
+            ssize_t index = mListenerIds.indexOfKey(id);
+            if (index < 0) {
+                // Registered before the recording started
+                mUnmapped++;
+                return NAME_NOT_FOUND;
+            }
+            int32_t newId = mListenerIds.valueAt(index);
+            mListenerIds.removeItemsAt(index);
+            return composer->unregisterListener(newId);
+        }
+        case MDS_REC_REGISTER_CALLBACK:
+            return composer->registerCallback(mCallback);
+        case MDS_REC_UNREGISTER_CALLBACK:
+            return composer->unregisterCallback(mCallback);
+        case MDS_REC_SET_HDMI_TIMING: {
+            MDSHdmiTiming timing;
+            memset(&timing, 0, sizeof(timing));
+            if (mdsRead(args, &timing) != NO_ERROR)
+                return BAD_VALUE;
+            return composer->setHdmiTiming(timing);
+        }
+        case MDS_REC_SET_HDMI_TIMING_BY_INDEX: {
+            int32_t index = -1;
+            if (mdsRead(args, &index) != NO_ERROR)
+                return BAD_VALUE;
+            return composer->setHdmiTimingByIndex(index);
+        }
+        case MDS_REC_SET_HDMI_SCALING_TYPE: {
+            MDS_SCALING_TYPE type = MDS_SCALING_NONE;
+            if (mdsRead(args, &type) != NO_ERROR)
+                return BAD_VALUE;
+            return composer->setHdmiScalingType(type);
+        }
+        case MDS_REC_SET_HDMI_OVERSCAN: {
+            int32_t h = 0, v = 0;
+            if (mdsRead(args, &h, &v) != NO_ERROR)
+                return BAD_VALUE;
+            return composer->setHdmiOverscan(h, v);
+        }
+        case MDS_REC_APPLY_DISPLAY_CONFIG: {
+            MDSDisplayConfig config;
+            memset(&config, 0, sizeof(config));
+            if (mdsRead(args, &config) != NO_ERROR)
+                return BAD_VALUE;
+            return composer->applyDisplayConfig(config);
+        }
+        case MDS_REC_UPDATE_HDMI_CONNECTION: {
+            bool connected = false;
+            if (mdsRead(args, &connected) != NO_ERROR)
+                return BAD_VALUE;
+            fakeDrmConnect(connected ? mSink : -1);
+            if (mRealTime)
+                return composer->updateHdmiConnectionStatus(connected);
+            return composer->commitHdmiHotplug(connected);
+        }
+        case MDS_REC_UPDATE_WIDI_CONNECTION: {
+            bool connected = false;
+            if (mdsRead(args, &connected) != NO_ERROR)
+                return BAD_VALUE;
+            return composer->updateWidiConnectionStatus(connected);
+        }
+        case MDS_REC_UPDATE_INPUT_STATE: {
+            bool state = false;
+            if (mdsRead(args, &state) != NO_ERROR)
+                return BAD_VALUE;
+            return composer->updateInputState(state);
+        }
+        case MDS_REC_UPDATE_PHONE_CALL_STATE: {
+            bool state = false;
+            if (mdsRead(args, &state) != NO_ERROR)
+                return BAD_VALUE;
+            return composer->updatePhoneCallState(state);
+        }
+        case MDS_REC_NOTIFY_INPUT_ACTIVITY:
+            return composer->notifyInputActivity();
+        case MDS_REC_SET_DECODER_OUTPUT_RESOLUTION: {
+            int32_t sessionId = -1, width = 0, height = 0;
+            if (mdsRead(args, &sessionId, &width, &height) != NO_ERROR)
+                return BAD_VALUE;
+            return composer->setDecoderOutputResolution(sessionId, width, height);
+        }
+#ifdef TARGET_HAS_VPP
+        case MDS_REC_SET_VPP_STATE: {
+            MDS_DISPLAY_ID dpyId = MDS_DISPLAY_PRIMARY;
+            bool on = false;
+            if (mdsRead(args, &dpyId, &on) != NO_ERROR)
+                return BAD_VALUE;
+            return composer->setVppState(dpyId, on);
+        }
+#endif
+        default:
+            return BAD_TYPE;
+    }
+}
+
+status_t MultiDisplayReplay::run() {
+    status_t err = bringUp();
+    if (err != NO_ERROR)
+        return err;
+    nsecs_t start = systemTime();
+    for (size_t i = 0; i < mRecords.size(); i++) {
+        const MultiDisplayRecord& record = mRecords[i];
+        if (mRealTime) {
+            nsecs_t delay = start + record.time - systemTime();
+            if (delay > 0)
+                usleep(ns2us(delay));
+        }
+        Parcel args;
+        args.setData(mArgs.array() + mOffsets[i], record.size);
+        nsecs_t t0 = systemTime();
+        status_t result = replay(record.op, args);
+        nsecs_t t1 = systemTime();
+        if (record.op < MDS_REC_MAX)
+            mSamples[record.op].add(t1 - t0);
+        if (result != NO_ERROR)
+            mFailures++;
+        if (mVerbose)
+            fprintf(stderr, "%10.3f ms %-28s %d %lld ns\n", record.time / 1e6,
+                    MultiDisplayRecorder::getOpName(record.op),
+                    result, (long long)(t1 - t0));
+    }
+    nsecs_t wall = systemTime() - start;
+    if (mRealTime)
+        usleep(SETTLE_MS * 1000);
+
+    for (uint32_t op = 1; op < MDS_REC_MAX; op++) {
+        mSamples[op].setWallTime(wall);
+        mReport.add(MultiDisplayRecorder::getOpName(op), String8(), mSamples[op]);
+    }
+    mComposer = NULL;
+    fakeDrmConnect(-1);
+    return NO_ERROR;
+}
+
+void MultiDisplayReplay::getMembers(String8& members) {
+    members.appendFormat("  \"records\": %d,\n", (int)mRecords.size());
+    members.appendFormat("  \"mode\": \"%s\",\n", (mRealTime ? "realtime" : "fast"));
+    members.appendFormat("  \"start_mode\": %d,\n", mStartMode);
+    members.appendFormat("  \"failures\": %d,\n", mFailures);
+    members.appendFormat("  \"unmapped_listeners\": %d,\n", mUnmapped);
+    if (mObserver != NULL) {
+        members.appendFormat("  \"broadcasts\": {\"mode_change\": %d, "
+                "\"ready\": %d, \"display_state\": %d},\n",
+                mObserver->getCount(MDS_MSG_MODE_CHANGE),
+                mObserver->getCount(MDS_MSG_READY),
+                mObserver->getCount(MDS_MSG_DISPLAY_STATE));
+    }
+}
+
+}; // namespace intel
+}; // namespace android
+
+using namespace android;
+using namespace android::intel;
+
+static void usage(const char* name) {
+    fprintf(stderr, "usage: %s [-r] [-s sink] [-v] [-o file] log\n", name);
+}
+
+int main(int argc, char** argv) {
+    bool realTime = false;
+    bool verbose = false;
+    int sink = 0;
+    const char* path = NULL;
+    int opt;
+    while ((opt = getopt(argc, argv, "rs:vo:h")) != -1) {
+        switch (opt) {
+            case 'r':
+                realTime = true;
+                break;
+            case 's':
+                sink = atoi(optarg);
+                break;
+            case 'v':
+                verbose = true;
+                break;
+            case 'o':
+                path = optarg;
+                break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+    if (optind != argc - 1 || sink < 0 || sink >= fakeDrmGetSinkCount()) {
+        usage(argv[0]);
+        return 1;
+    }
+    const char* log = argv[optind];
+
+    BenchReport report("mds_replay");
+    MultiDisplayReplay replay(realTime, sink, verbose, report);
+    if (replay.load(log) != NO_ERROR)
+        return 1;
+    if (replay.run() != NO_ERROR)
+        return 1;
+
+    FILE* file = stdout;
+    if (path != NULL) {
+        file = fopen(path, "w");
+        if (file == NULL) {
+            fprintf(stderr, "Fail to open %s\n", path);
+            return 1;
+        }
+    }
+    String8 members;
+    members.appendFormat("  \"log\": \"%s\",\n", log);
+    members.appendFormat("  \"sink\": \"%s\",\n", fakeDrmGetSinkName(sink));
+    replay.getMembers(members);
+    report.write(file, members);
+    if (file != stdout)
+        fclose(file);
+    return 0;
+}
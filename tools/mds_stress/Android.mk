@@ -0,0 +1,24 @@
+# Stress and soak test of the composer core, see mds_stress.cpp
+#
+# The composer core is linked from tools/common with a fake libdrm, so it runs
+# on any device of the target, beside the real service:
+#   mmm vendor/intel/hardware/libmultidisplay/tools
+#   adb shell /data/local/tmp/mds_stress -o /data/local/tmp/mds_stress.json
+
+LOCAL_PATH:= $(call my-dir)
+
+ifneq ($(filter true,$(ENABLE_IMG_GRAPHICS) $(ENABLE_GEN_GRAPHICS)),)
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES := mds_stress.cpp
+
+LOCAL_MODULE := mds_stress
+LOCAL_MODULE_TAGS := optional
+LOCAL_MODULE_PATH := $(TARGET_OUT_DATA)/local/tmp
+
+LOCAL_STATIC_LIBRARIES := libmds_tools_core
+LOCAL_CFLAGS := -DLOG_TAG=\"MultiDisplayStress\"
+
+include $(LOCAL_PATH)/../common/mds_tool.mk
+include $(BUILD_EXECUTABLE)
+endif
@@ -0,0 +1,539 @@
+/*
+ * Copyright (c) 2012-2013, Intel Corporation. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/*
+ * Stress and soak test of the composer core, on the real composer and
+ * drm_hdmi.cpp with a fake libdrm, as mds_bench. Each round runs at once:
+ *   - video threads, each one allocates a session and drives it through
+ *     PREPARING, the source info, PREPARED, UNPREPARING and UNPREPARED
+ *   - listener threads, each one registers and unregisters listeners at
+ *     random, with up to LISTENERS_PER_THREAD of them registered
+ *   - a hotplug thread, which plugs and unplugs an HDMI TV
+ * In the odd rounds but the last one, a video thread leaves its last
+ * session PREPARED, and closes it in the next round.
+ *
+ * The invariants are checked all along the run:
+ *   - a session reserved by allocateVideoSession is never given to
+ *     two video threads
+ *   - a listener slot, the low bits of the ID, is never given to two
+ *     registered listeners
+ * and at the end of each round, when no call is in flight:
+ *   - the PREPARED sessions are the ones left by the video threads,
+ *     the others are UNPREPARED, so no session is leaked
+ *   - MDS_VIDEO_ON is set if and only if a session is PREPARED
+ *   - MDS_HDMI_CONNECTED or MDS_DVI_CONNECTED matches the last hotplug
+ *   - the listener table is empty
+ *
+ * usage: mds_stress [-r rounds] [-i cycles] [-v threads] [-l threads] [-p ms] [-o file]
+ *   -r  the rounds, 10 by default
+ *   -i  the video cycles of a video thread per round, 200 by default
+ *   -v  the video threads, 8 by default, up to MDS_VIDEO_SESSION_MAX_VALUE
+ *   -l  the listener threads, 4 by default, up to MAX_LISTENER_THREADS
+ *   -p  the period of the hotplugs, 5 ms by default, 0 disables them
+ *   -o  write the JSON report into "file" instead of stdout
+ *
+ * The report is the JSON of BenchReport, with the time of a video cycle,
+ * of a listener register/unregister pair and of a hotplug, and the counts
+ * of the invariant failures. The tool exits with 1 if one is found.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <unistd.h>
+#include <cutils/atomic.h>
+#include <utils/String8.h>
+#include <utils/threads.h>
+#include <binder/Binder.h>
+
+#include "MultiDisplayComposerTestAccess.h"
+#include "FakeDrm.h"
+#include "StubBinder.h"
+#include "BenchReport.h"
+#include "BenchWorker.h"
+
+namespace android {
+namespace intel {
+
+static const int DEFAULT_ROUNDS = 10;
+static const int DEFAULT_CYCLES = 200;
+static const int DEFAULT_VIDEO_THREADS = 8;
+static const int DEFAULT_LISTENER_THREADS = 4;
+static const int DEFAULT_HOTPLUG_PERIOD_MS = 5;
+static const int READY_TIMEOUT_MS = 5000;
+static const int LISTENERS_PER_THREAD = 8;
+// The listener slots are taken from 0 to 63, some are left to the others
+static const int MAX_LISTENER_THREADS = 6;
+static const int MAX_LISTENER_SLOT = 64;
+
+/*
+ * The state shared by the workers. A worker claims the session that
+ * allocateVideoSession reserves for it before it drives it. The
+ * reservation makes it its own, so a claim lost to another worker is
+ * an invariant failure, counted as a shared session.
+ */
+class StressState {
+public:
+    StressState()
+        : mSharedSessions(0), mAllocateFailures(0),
+          mRegisterFailures(0), mDuplicateListeners(0) {
+        memset((void*)mSessionOwners, 0, sizeof(mSessionOwners));
+        for (int i = 0; i < MAX_LISTENER_SLOT; i++)
+            mListenerSlots[i] = -1;
+    }
+
+    // "owner" is the worker number plus 1
+    inline bool claimSession(int id, int32_t owner) {
+        return android_atomic_release_cas(0, owner, &mSessionOwners[id]) == 0;
+    }
+    inline void releaseSession(int id) {
+        android_atomic_release_store(0, &mSessionOwners[id]);
+    }
+    inline int32_t getSessionOwner(int id) {
+        return android_atomic_acquire_load(&mSessionOwners[id]);
+    }
+
+    // Called once the composer returns the ID
+    void addListener(int32_t id) {
+        Mutex::Autolock lock(mListenerLock);
+        int32_t slot = id % MAX_LISTENER_SLOT;
+        if (mListenerSlots[slot] >= 0) {
+            fprintf(stderr, "listener slot %d is given to %d and %d\n",
+                    slot, mListenerSlots[slot], id);
+            android_atomic_inc(&mDuplicateListeners);
+        }
+        mListenerSlots[slot] = id;
+    }
+    // Called before the composer is asked to remove it
+    void removeListener(int32_t id) {
+        Mutex::Autolock lock(mListenerLock);
+        int32_t slot = id % MAX_LISTENER_SLOT;
+        if (mListenerSlots[slot] == id)
+            mListenerSlots[slot] = -1;
+    }
+
+    volatile int32_t mSharedSessions;
+    volatile int32_t mAllocateFailures;
+    volatile int32_t mRegisterFailures;
+    volatile int32_t mDuplicateListeners;
+
+private:
+    volatile int32_t mSessionOwners[MDS_VIDEO_SESSION_MAX_VALUE];
+    Mutex mListenerLock;
+    // The ID of the listener in each slot, -1 if it is free
+    int32_t mListenerSlots[MAX_LISTENER_SLOT];
+};
+
+/*
+ * Run "cycles" video cycles, the session left PREPARED by the
+ * previous round is closed first, and the last one is left PREPARED
+ * if "hold" is set.
+ */
+class StressVideoWorker : public BenchWorker {
+public:
+    StressVideoWorker(BenchGate& gate, MultiDisplayComposer* composer,
+            StressState& state, int32_t owner, int cycles, bool hold, int held)
+        : BenchWorker(gate), mHeld(held), mComposer(composer), mState(state),
+          mOwner(owner), mCycles(cycles), mHold(hold), mToken(new BBinder()) {}
+    // The session left PREPARED, -1 if none
+    int mHeld;
+private:
+    MultiDisplayComposer* mComposer;
+    StressState& mState;
+    int32_t mOwner;
+    int  mCycles;
+    bool mHold;
+    // The player binder of this thread, the owner of its sessions
+    sp<IBinder> mToken;
+
+    int allocate() {
+        while (true) {
+            int id = mComposer->allocateVideoSession(mToken);
+            if (id < 0) {
+                android_atomic_inc(&mState.mAllocateFailures);
+                sched_yield();
+                continue;
+            }
+            if (mState.claimSession(id, mOwner))
+                return id;
+            fprintf(stderr, "session %d is given to worker %d, held by %d\n",
+                    id, mOwner, mState.getSessionOwner(id));
+            android_atomic_inc(&mState.mSharedSessions);
+            sched_yield();
+        }
+    }
+    void close(int id) {
+        mComposer->updateVideoState(id, MDS_VIDEO_UNPREPARING);
+        // Given up while still reserved, UNPREPARED lets the others take it
+        mState.releaseSession(id);
+        mComposer->updateVideoState(id, MDS_VIDEO_UNPREPARED);
+    }
+
+    virtual void work() {
+        if (mHeld >= 0) {
+            close(mHeld);
+            mHeld = -1;
+        }
+        MDSVideoSourceInfo info;
+        memset(&info, 0, sizeof(info));
+        info.displayW = 1920;
+        info.displayH = 1080;
+        for (int c = 0; c < mCycles; c++) {
+            nsecs_t t0 = systemTime();
+            int id = allocate();
+            mComposer->updateVideoState(id, MDS_VIDEO_PREPARING);
+            info.frameRate = (c & 1) ? 30 : 24;
+            mComposer->updateVideoSourceInfo(id, info);
+            mComposer->updateVideoState(id, MDS_VIDEO_PREPARED);
+            if (mHold && c == mCycles - 1) {
+                mHeld = id;
+                break;
+            }
+            close(id);
+            mSamples.add(systemTime() - t0);
+        }
+    }
+};
+
+// Register and unregister listeners at random till the round ends
+class StressListenerWorker : public BenchWorker {
+public:
+    StressListenerWorker(BenchGate& gate, MultiDisplayComposer* composer,
+            StressState& state, unsigned int seed)
+        : BenchWorker(gate), mComposer(composer), mState(state), mSeed(seed) {}
+private:
+    MultiDisplayComposer* mComposer;
+    StressState& mState;
+    unsigned int mSeed;
+    Vector<int32_t> mIds;
+
+    void remove(size_t index) {
+        int32_t id = mIds[index];
+        mIds.removeAt(index);
+        mState.removeListener(id);
+        mComposer->unregisterListener(id);
+    }
+
+    virtual void work() {
+        sp<IMultiDisplayListener> listener =
+            new LoopbackListener(new StubListener());
+        while (!exitPending()) {
+            nsecs_t t0 = systemTime();
+            if (mIds.size() < (size_t)LISTENERS_PER_THREAD) {
+                int32_t id = mComposer->registerListener(listener,
+                        "StressListener", MDS_MSG_MODE_CHANGE);
+                if (id < 0) {
+                    android_atomic_inc(&mState.mRegisterFailures);
+                } else {
+                    mState.addListener(id);
+                    mIds.add(id);
+                }
+            }
+            if (!mIds.isEmpty() && (rand_r(&mSeed) & 1))
+                remove(rand_r(&mSeed) % mIds.size());
+            mSamples.add(systemTime() - t0);
+        }
+        while (!mIds.isEmpty())
+            remove(mIds.size() - 1);
+    }
+};
+
+class MultiDisplayStress {
+public:
+    MultiDisplayStress(int cycles, int videoThreads, int listenerThreads,
+            int hotplugPeriodMs)
+        : mCycles(cycles), mVideoThreads(videoThreads),
+          mListenerThreads(listenerThreads), mHotplugPeriodMs(hotplugPeriodMs),
+          mConnected(true), mInvariantFailures(0), mWall(0) {}
+
+    status_t setUp();
+    void tearDown();
+    // The video threads leave a session PREPARED if "hold" is set
+    void runRound(int round, bool hold);
+    void report(BenchReport& report, String8& members);
+
+    inline int getInvariantFailures() {
+        return mInvariantFailures + mState.mDuplicateListeners +
+            mState.mSharedSessions;
+    }
+    // Called by the hotplug thread only
+    void toggleHdmi();
+
+private:
+    int mCycles;
+    int mVideoThreads;
+    int mListenerThreads;
+    int mHotplugPeriodMs;
+    bool mConnected;
+    int mInvariantFailures;
+    nsecs_t mWall;
+    sp<MultiDisplayComposerTestAccess> mComposer;
+    sp<IMultiDisplayCallback> mCallback;
+    StressState mState;
+    // The session left PREPARED by each video thread
+    Vector<int> mHeld;
+    BenchSamples mVideoSamples;
+    BenchSamples mListenerSamples;
+    BenchSamples mHotplugSamples;
+
+    void check(int round);
+};
+
+// Plug or unplug the TV, the hotplug is committed without the debouncer
+// so the fake libdrm is only changed between two probes
+class StressHotplugWorker : public BenchWorker {
+public:
+    StressHotplugWorker(BenchGate& gate, MultiDisplayStress* stress, int periodMs)
+        : BenchWorker(gate), mStress(stress), mPeriodMs(periodMs) {}
+private:
+    MultiDisplayStress* mStress;
+    int mPeriodMs;
+
+    virtual void work() {
+        while (!exitPending()) {
+            nsecs_t t0 = systemTime();
+            mStress->toggleHdmi();
+            mSamples.add(systemTime() - t0);
+            usleep(mPeriodMs * 1000);
+        }
+    }
+};
+
+void MultiDisplayStress::toggleHdmi() {
+    mConnected = !mConnected;
+    fakeDrmConnect(mConnected ? 0 : -1);
+    mComposer->commitHdmiHotplug(mConnected);
+}
+
+status_t MultiDisplayStress::setUp() {
+    // An HDMI TV is connected at the bring-up
+    fakeDrmConnect(0);
+    mComposer = new MultiDisplayComposerTestAccess();
+    int waited = 0;
+    while (!mComposer->isReady() && waited < READY_TIMEOUT_MS) {
+        usleep(1000);
+        waited++;
+    }
+    if (!mComposer->isReady()) {
+        fprintf(stderr, "MDS isn't ready in %d ms\n", READY_TIMEOUT_MS);
+        mComposer = NULL;
+        return TIMED_OUT;
+    }
+    // A snapshot of a previous run may be restored
+    mComposer->resetVideoPlayback();
+    mCallback = new StubCallback();
+    mComposer->registerCallback(mCallback);
+    for (int i = 0; i < mVideoThreads; i++)
+        mHeld.add(-1);
+    return NO_ERROR;
+}
+
+void MultiDisplayStress::tearDown() {
+    mComposer->unregisterCallback(mCallback);
+    mComposer = NULL;
+    fakeDrmConnect(-1);
+}
+
+void MultiDisplayStress::runRound(int round, bool hold) {
+    BenchGate gate;
+    Vector<sp<StressVideoWorker> > videoWorkers;
+    Vector<sp<BenchWorker> > loopWorkers;
+    for (int i = 0; i < mVideoThreads; i++) {
+        sp<StressVideoWorker> worker = new StressVideoWorker(gate,
+                mComposer.get(), mState, i + 1, mCycles, hold, mHeld[i]);
+        // A worker not started keeps the session held
+        if (worker->run("MDSStressVideo", PRIORITY_DEFAULT) != NO_ERROR)
+            fprintf(stderr, "round %d: fail to start a video worker\n", round);
+        videoWorkers.add(worker);
+    }
+    for (int i = 0; i < mListenerThreads; i++) {
+        sp<BenchWorker> worker = new StressListenerWorker(gate,
+                mComposer.get(), mState, (unsigned int)(round * 97 + i));
+        if (worker->run("MDSStressListener", PRIORITY_DEFAULT) == NO_ERROR)
+            loopWorkers.add(worker);
+    }
+    sp<BenchWorker> hotplug;
+    if (mHotplugPeriodMs > 0) {
+        hotplug = new StressHotplugWorker(gate, this, mHotplugPeriodMs);
+        if (hotplug->run("MDSStressHotplug", PRIORITY_DEFAULT) == NO_ERROR)
+            loopWorkers.add(hotplug);
+    }
+
+    nsecs_t wall = systemTime();
+    gate.open();
+    for (size_t i = 0; i < videoWorkers.size(); i++) {
+        videoWorkers[i]->join();
+        mVideoSamples.merge(videoWorkers[i]->mSamples);
+    }
+    for (size_t i = 0; i < loopWorkers.size(); i++)
+        loopWorkers[i]->requestExitAndWait();
+    mWall += systemTime() - wall;
+    for (size_t i = 0; i < loopWorkers.size(); i++) {
+        if (loopWorkers[i] == hotplug)
+            mHotplugSamples.merge(loopWorkers[i]->mSamples);
+        else
+            mListenerSamples.merge(loopWorkers[i]->mSamples);
+    }
+    for (size_t i = 0; i < videoWorkers.size(); i++)
+        mHeld.editItemAt(i) = videoWorkers[i]->mHeld;
+    check(round);
+}
+
+// Nothing is in flight, the composer is read directly
+void MultiDisplayStress::check(int round) {
+    int failures = 0;
+    bool playing = false;
+    MDS_VIDEO_STATE states[MDS_VIDEO_SESSION_MAX_VALUE];
+    mComposer->getVideoStates(states);
+    for (int id = 0; id < MDS_VIDEO_SESSION_MAX_VALUE; id++) {
+        MDS_VIDEO_STATE state = states[id];
+        int32_t owner = mState.getSessionOwner(id);
+        MDS_VIDEO_STATE expected = MDS_VIDEO_UNPREPARED;
+        if (owner > 0 && mHeld[owner - 1] == id)
+            expected = MDS_VIDEO_PREPARED;
+        if (state == MDS_VIDEO_PREPARED)
+            playing = true;
+        if (state != expected) {
+            fprintf(stderr, "round %d: session %d is in state %d, "
+                    "expected %d\n", round, id, state, expected);
+            failures++;
+        }
+    }
+    int32_t mode = mComposer->getDisplayMode(false);
+    if (((mode & MDS_VIDEO_ON) != 0) != playing) {
+        fprintf(stderr, "round %d: mode 0x%x, but %s session is PREPARED\n",
+                round, mode, (playing ? "a" : "no"));
+        failures++;
+    }
+    if (mHotplugPeriodMs > 0 &&
+            ((mode & (MDS_HDMI_CONNECTED | MDS_DVI_CONNECTED)) != 0) != mConnected) {
+        fprintf(stderr, "round %d: mode 0x%x, but HDMI is %s\n",
+                round, mode, (mConnected ? "connected" : "disconnected"));
+        failures++;
+    }
+    int32_t listeners = mComposer->getListenerCount();
+    if (listeners != 0) {
+        fprintf(stderr, "round %d: %d listeners are left\n", round, listeners);
+        failures++;
+    }
+    mInvariantFailures += failures;
+}
+
+void MultiDisplayStress::report(BenchReport& report, String8& members) {
+    String8 config;
+    config.appendFormat("\"video_threads\": %d, \"listener_threads\": %d, "
+            "\"hotplug_period_ms\": %d", mVideoThreads, mListenerThreads,
+            mHotplugPeriodMs);
+    mVideoSamples.setWallTime(mWall);
+    mListenerSamples.setWallTime(mWall);
+    mHotplugSamples.setWallTime(mWall);
+    report.add("video_cycle", config, mVideoSamples);
+    report.add("listener_churn", config, mListenerSamples);
+    report.add("hotplug_toggle", config, mHotplugSamples);
+    members.appendFormat("  \"invariant_failures\": %d,\n"
+            "  \"duplicate_listener_ids\": %d,\n"
+            "  \"shared_session_ids\": %d,\n"
+            "  \"allocate_failures\": %d,\n"
+            "  \"register_failures\": %d,\n",
+            getInvariantFailures(), mState.mDuplicateListeners,
+            mState.mSharedSessions, mState.mAllocateFailures,
+            mState.mRegisterFailures);
+}
+
+}; // namespace intel
+}; // namespace android
+
+using namespace android;
+using namespace android::intel;
+
+static void usage(const char* name) {
+    fprintf(stderr, "usage: %s [-r rounds] [-i cycles] [-v threads] "
+            "[-l threads] [-p ms] [-o file]\n", name);
+}
+
+int main(int argc, char** argv) {
+    int rounds = DEFAULT_ROUNDS;
+    int cycles = DEFAULT_CYCLES;
+    int videoThreads = DEFAULT_VIDEO_THREADS;
+    int listenerThreads = DEFAULT_LISTENER_THREADS;
+    int hotplugPeriodMs = DEFAULT_HOTPLUG_PERIOD_MS;
+    const char* path = NULL;
+    int opt;
+    while ((opt = getopt(argc, argv, "r:i:v:l:p:o:h")) != -1) {
+        switch (opt) {
+            case 'r':
+                rounds = atoi(optarg);
+                break;
+            case 'i':
+                cycles = atoi(optarg);
+                break;
+            case 'v':
+                videoThreads = atoi(optarg);
+                break;
+            case 'l':
+                listenerThreads = atoi(optarg);
+                break;
+            case 'p':
+                hotplugPeriodMs = atoi(optarg);
+                break;
+            case 'o':
+                path = optarg;
+                break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+    // A held session per video thread, and the listeners under the table size
+    if (rounds <= 0 || cycles <= 0 || videoThreads < 0 ||
+            videoThreads > MDS_VIDEO_SESSION_MAX_VALUE ||
+            listenerThreads < 0 || listenerThreads > MAX_LISTENER_THREADS ||
+            hotplugPeriodMs < 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    MultiDisplayStress stress(cycles, videoThreads, listenerThreads, hotplugPeriodMs);
+    if (stress.setUp() != NO_ERROR)
+        return 1;
+    // The last round closes the sessions held by the one before
+    for (int r = 0; r < rounds; r++) {
+        stress.runRound(r, (r & 1) != 0 && r < rounds - 1);
+        fprintf(stderr, "round %d: %d invariant failures\n",
+                r, stress.getInvariantFailures());
+    }
+
+    BenchReport report("mds_stress");
+    String8 members;
+    members.appendFormat("  \"rounds\": %d,\n  \"cycles\": %d,\n", rounds, cycles);
+    stress.report(report, members);
+    stress.tearDown();
+
+    FILE* file = stdout;
+    if (path != NULL) {
+        file = fopen(path, "w");
+        if (file == NULL) {
+            fprintf(stderr, "Fail to open %s\n", path);
+            return 1;
+        }
+    }
+    report.write(file, members);
+    if (file != stdout)
+        fclose(file);
+    return (stress.getInvariantFailures() > 0 ? 1 : 0);
+}